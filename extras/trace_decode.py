@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""Decodes a JoystickTrace::dump() blob into per-report field values.
+
+Usage: trace_decode.py <dump file>   (or pipe the blob on stdin)
+"""
+
+import struct
+import sys
+
+USAGE_NAMES = {
+    (0x01, 0x30): "X", (0x01, 0x31): "Y", (0x01, 0x32): "Z",
+    (0x01, 0x33): "Rx", (0x01, 0x34): "Ry", (0x01, 0x35): "Rz",
+    (0x01, 0x39): "Hat",
+    (0x02, 0xBA): "Rudder", (0x02, 0xBB): "Throttle", (0x02, 0xC4): "Accelerator",
+    (0x02, 0xC5): "Brake", (0x02, 0xC8): "Steering",
+}
+
+
+def parse_descriptor(descriptor):
+    """Returns {report_id: [(name, bit_offset, bit_size, signed)]} for the input fields."""
+    reports = {}
+    offsets = {}
+    globals_ = {"page": 0, "size": 0, "count": 0, "minimum": 0, "report_id": 0}
+    usages = []
+    usage_minimum = None
+    index = 0
+
+    while index < len(descriptor):
+        prefix = descriptor[index]
+        size = (0, 1, 2, 4)[prefix & 0x03]
+        raw = descriptor[index + 1:index + 1 + size]
+        value = int.from_bytes(raw, "little")
+        signed_value = int.from_bytes(raw, "little", signed=True) if size else 0
+        tag = prefix & 0xFC
+        index += 1 + size
+
+        if tag == 0x04:
+            globals_["page"] = value
+        elif tag == 0x14:
+            globals_["minimum"] = signed_value
+        elif tag == 0x74:
+            globals_["size"] = value
+        elif tag == 0x94:
+            globals_["count"] = value
+        elif tag == 0x84:
+            globals_["report_id"] = value
+        elif tag == 0x08:
+            usages.append(value)
+        elif tag == 0x18:
+            usage_minimum = value
+        elif tag == 0x28 and usage_minimum is not None:
+            usages.extend(range(usage_minimum, value + 1))
+            usage_minimum = None
+        elif tag in (0x80, 0x90, 0xB0):
+            report_id = globals_["report_id"]
+            offset = offsets.get((tag, report_id), 0)
+            if tag == 0x80 and not value & 0x01:
+                fields = reports.setdefault(report_id, [])
+                for position in range(globals_["count"]):
+                    usage = usages[min(position, len(usages) - 1)] if usages else 0
+                    if globals_["page"] == 0x09:
+                        name = "Button%d" % usage
+                    else:
+                        name = USAGE_NAMES.get((globals_["page"], usage), "Usage%02X:%02X" % (globals_["page"], usage))
+                    fields.append((name, offset + position * globals_["size"], globals_["size"],
+                                   globals_["minimum"] < 0))
+            offsets[(tag, report_id)] = offset + globals_["size"] * globals_["count"]
+            usages = []
+        elif tag in (0xA0, 0xC0):
+            usages = []
+
+    return reports
+
+
+def extract(data, bit_offset, bit_size, signed):
+    value = int.from_bytes(data, "little") >> bit_offset
+    value &= (1 << bit_size) - 1
+    if signed and value & (1 << (bit_size - 1)):
+        value -= 1 << bit_size
+    return value
+
+
+def decode(blob):
+    if blob[:4] != b"JTRC":
+        raise ValueError("not a joystick trace")
+    version = blob[4]
+    if version != 1:
+        raise ValueError("unsupported trace version %d" % version)
+
+    (descriptor_size,) = struct.unpack_from("<H", blob, 5)
+    position = 7
+    reports = parse_descriptor(blob[position:position + descriptor_size])
+    position += descriptor_size
+
+    (count,) = struct.unpack_from("<H", blob, position)
+    position += 2
+
+    time = 0
+    for _ in range(count):
+        interval, report_id, length = struct.unpack_from("<HBB", blob, position)
+        position += 4
+        data = blob[position:position + length]
+        position += length
+        time += interval
+
+        values = []
+        buttons = []
+        for name, bit_offset, bit_size, signed in reports.get(report_id, []):
+            value = extract(data, bit_offset, bit_size, signed)
+            if name.startswith("Button"):
+                if value:
+                    buttons.append(name[6:])
+            else:
+                values.append("%s=%d" % (name, value))
+        values.append("buttons=[%s]" % ",".join(buttons))
+        yield time, report_id, values
+
+
+def main():
+    if len(sys.argv) > 1:
+        with open(sys.argv[1], "rb") as handle:
+            blob = handle.read()
+    else:
+        blob = sys.stdin.buffer.read()
+
+    for time, report_id, values in decode(blob):
+        print("%10.3f ms  id=%d  %s" % (time / 1000.0, report_id, " ".join(values)))
+
+
+if __name__ == "__main__":
+    main()
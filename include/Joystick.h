@@ -35,8 +35,12 @@
 //================================================================================
 //  Joystick (Gamepad)
 
+class JoystickTrace;
+struct JoystickConfig;
+
 #define JOYSTICK_DEFAULT_REPORT_ID         0x03
 #define JOYSTICK_DEFAULT_BUTTON_COUNT        32
+#define JOYSTICK_BUTTON_COUNT_MAXIMUM        64
 #define JOYSTICK_DEFAULT_AXIS_MINIMUM         0
 #define JOYSTICK_DEFAULT_AXIS_MAXIMUM      1023
 #define JOYSTICK_DEFAULT_SIMULATOR_MINIMUM    0
@@ -44,10 +48,58 @@
 #define JOYSTICK_DEFAULT_HATSWITCH_COUNT      2
 #define JOYSTICK_HATSWITCH_COUNT_MAXIMUM      2
 #define JOYSTICK_HATSWITCH_RELEASE           (-1)
+#define JOYSTICK_REPORT_SIZE_MAXIMUM         31
+#define JOYSTICK_RELATIVE_MINIMUM        (-32767)
+#define JOYSTICK_RELATIVE_MAXIMUM          32767
 #define JOYSTICK_TYPE_JOYSTICK             0x04
 #define JOYSTICK_TYPE_GAMEPAD              0x05
 #define JOYSTICK_TYPE_MULTI_AXIS           0x08
 
+// Addressable report fields
+enum JoystickField : uint8_t {
+    JOYSTICK_FIELD_X_AXIS = 0,
+    JOYSTICK_FIELD_Y_AXIS,
+    JOYSTICK_FIELD_Z_AXIS,
+    JOYSTICK_FIELD_RX_AXIS,
+    JOYSTICK_FIELD_RY_AXIS,
+    JOYSTICK_FIELD_RZ_AXIS,
+    JOYSTICK_FIELD_RUDDER,
+    JOYSTICK_FIELD_THROTTLE,
+    JOYSTICK_FIELD_ACCELERATOR,
+    JOYSTICK_FIELD_BRAKE,
+    JOYSTICK_FIELD_STEERING,
+    JOYSTICK_FIELD_HAT_SWITCH_0,
+    JOYSTICK_FIELD_HAT_SWITCH_1,
+    JOYSTICK_FIELD_BUTTONS,
+    JOYSTICK_FIELD_COUNT
+};
+
+// Axis pairs with a coupled radial deadzone
+enum JoystickAxisPair : uint8_t {
+    JOYSTICK_AXIS_PAIR_XY = 0,
+    JOYSTICK_AXIS_PAIR_RX_RY,
+    JOYSTICK_AXIS_PAIR_COUNT
+};
+
+// Full deflection in the radial deadzone settings
+#define JOYSTICK_RADIAL_MAXIMUM 32767L
+
+struct JoystickRadialSettings {
+    bool enabled;
+    bool squareToCircle;
+    uint16_t deadzone;
+    uint16_t saturation;
+};
+
+// Called to request a remote wakeup while the bus is suspended
+typedef void (*JoystickWakeupCallback)();
+
+#define JOYSTICK_FIELD_MASK(field) ((uint16_t) (1 << (field)))
+#define JOYSTICK_FIELD_MASK_ALL    ((uint16_t) ((1 << JOYSTICK_FIELD_COUNT) - 1))
+#define JOYSTICK_FIELD_MASK_DIGITAL (JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_BUTTONS) | \
+                                     JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_HAT_SWITCH_0) | \
+                                     JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_HAT_SWITCH_1))
+
 class Joystick_ {
 private:
 
@@ -64,7 +116,7 @@ private:
     int32_t _brake;
     int32_t _steering;
     int16_t _hatSwitchValues[JOYSTICK_HATSWITCH_COUNT_MAXIMUM];
-    uint8_t _buttonValues[4];
+    uint8_t _buttonValues[JOYSTICK_BUTTON_COUNT_MAXIMUM / 8];
 
     // Joystick Settings
     bool _autoSendState;
@@ -72,6 +124,7 @@ private:
     uint8_t _buttonValuesArraySize = 0;
     uint8_t _hatSwitchCount;
     uint8_t _includeAxisFlags;
+    uint8_t _relativeAxisFlags;
     uint8_t _includeSimulatorFlags;
     int32_t _xAxisMinimum = JOYSTICK_DEFAULT_AXIS_MINIMUM;
     int32_t _xAxisMaximum = JOYSTICK_DEFAULT_AXIS_MAXIMUM;
@@ -98,10 +151,59 @@ private:
 
     uint8_t _hidReportId;
     uint8_t _hidReportSize;
+    uint8_t _hidReport[JOYSTICK_REPORT_SIZE_MAXIMUM];
+    bool _hidReportValid = false;
+
+    // Change Tracking (JOYSTICK_FIELD_MASK bits)
+    uint16_t _pendingFields = 0;
+    uint16_t _changedFields = 0;
+
+    JoystickTrace *_trace = nullptr;
 
-    uint8_t _hidReportDescriptor[150];
+    // Radial Deadzones
+    JoystickRadialSettings _radialSettings[JOYSTICK_AXIS_PAIR_COUNT];
+
+    // Bus Suspend
+    bool _suspended = false;
+    bool _resumeReportPending = false;
+    bool _wakeupRequested = false;
+    uint16_t _wakeupFields = 0;
+    JoystickWakeupCallback _wakeupCallback;
+
+    uint8_t _hidReportDescriptor[JOYSTICK_DESCRIPTOR_SIZE_MAXIMUM];
     HIDSubDescriptor _hidSubDescriptor;
+
+    // Batched Updates
+    uint8_t _updateDepth = 0;
+    bool _updatePending = false;
+
+    void stateChanged();
+
+    void sendAutoState();
 protected:
+    void buildReport(uint8_t data[]) const;
+
+    uint16_t compareReport(const uint8_t data[]) const;
+
+    bool radialPairActive(JoystickAxisPair pair) const;
+
+    int32_t &axisValue(uint8_t axis);
+
+    void consumeRelativeValues();
+
+    int buildAndSetAxisField(uint8_t axisFlag, int32_t value, int32_t valueMinimum, int32_t valueMaximum,
+                             uint8_t dataLocation[]) const;
+
+    static int32_t clampRelativeValue(int32_t value);
+
+    static int buildAndSetRelativeValue(bool includeValue, int32_t value, uint8_t dataLocation[]);
+
+    static int32_t normalizeAxisValue(int32_t value, int32_t valueMinimum, int32_t valueMaximum);
+
+    static int buildAndSetRadialValues(const JoystickRadialSettings &settings, int32_t xValue, int32_t xMinimum,
+                                       int32_t xMaximum, int32_t yValue, int32_t yMinimum, int32_t yMaximum,
+                                       uint8_t dataLocation[]);
+
     static int buildAndSet16BitValue(bool includeValue, int32_t value, int32_t valueMinimum, int32_t valueMaximum,
                                      int32_t actualMinimum, int32_t actualMaximum, uint8_t dataLocation[]);
 
@@ -174,6 +276,22 @@ public:
         _steeringMaximum = maximum;
     }
 
+    // Restores the ranges and radial deadzones of a configuration blob
+    void applyConfig(const JoystickConfig &config);
+
+    // Stores the ranges and radial deadzones into a configuration blob
+    void captureConfig(JoystickConfig &config) const;
+
+    // Coupled radial deadzone for an axis pair, applied before packing.
+    // deadzone and saturation are radii from 0 to JOYSTICK_RADIAL_MAXIMUM;
+    // squareToCircle is for sticks with a square gate: the deflection is
+    // measured against the square, so a gate corner is full deflection and is
+    // drawn on the circle instead of reaching (1, 1).
+    void setRadialDeadzone(JoystickAxisPair pair, uint16_t deadzone, uint16_t saturation = JOYSTICK_RADIAL_MAXIMUM,
+                           bool squareToCircle = false);
+
+    void clearRadialDeadzone(JoystickAxisPair pair);
+
     // Set Axis Values
     void setXAxis(int32_t value);
 
@@ -187,6 +305,22 @@ public:
 
     void setRzAxis(int32_t value);
 
+    // Adds a delta to a relative axis. Deltas accumulate between reports;
+    // anything beyond one report's range stays pending for the next ones.
+    // With autoSendState those reports follow right away; otherwise call
+    // sendState() until hasPendingRelative() is false.
+    // On relative axes the set*Axis functions replace the pending delta.
+    void moveAxis(JoystickField axis, int32_t delta);
+
+    // True while a relative axis holds counts that no report has carried yet
+    inline bool hasPendingRelative() const {
+        return (_pendingFields & _relativeAxisFlags) != 0;
+    }
+
+    // Current value of an absolute axis scaled to its range, from
+    // -JOYSTICK_RADIAL_MAXIMUM to JOYSTICK_RADIAL_MAXIMUM (deadzones not applied)
+    int32_t getAxisPosition(JoystickField axis) const;
+
     // Set Simulation Values
     void setRudder(int32_t value);
 
@@ -204,9 +338,82 @@ public:
 
     void releaseButton(uint8_t button);
 
+    // Writes whole bytes of the button bitmap (bit 0 of byte 0 is button 0)
+    // and sends at most one report
+    void setButtonBytes(uint8_t firstByte, const uint8_t values[], uint8_t count);
+
     void setHatSwitch(int8_t hatSwitch, int16_t value);
 
+    // Sets an axis, simulator control or hat switch by field
+    void setField(JoystickField field, int32_t value);
+
+    // Batched Updates: setters between beginUpdate() and endUpdate() only
+    // update the state, endUpdate() sends a single report for all of them.
+    void beginUpdate();
+
+    void endUpdate();
+
     void sendState();
+
+    // Bus Suspend: while suspended the state is only accumulated, nothing is
+    // encoded or sent. Resuming sends one fresh report if anything is pending.
+    // The cores offer no suspend/resume callback, so either call
+    // pollSuspended() from loop() or call this from the core's own event
+    // (e.g. a TinyUSB suspend/resume callback).
+    void setSuspended(bool suspended);
+
+    // Applies the core's suspend state (USBDevice.isSuspended() on AVR).
+    // Does nothing on cores without such a query.
+    void pollSuspended();
+
+    inline bool isSuspended() const {
+        return _suspended;
+    }
+
+    // Fields (JOYSTICK_FIELD_MASK bits) whose change requests a remote wakeup
+    inline void setWakeupFields(uint16_t wakeupFields) {
+        _wakeupFields = wakeupFields;
+    }
+
+    inline void setWakeupCallback(JoystickWakeupCallback wakeupCallback) {
+        _wakeupCallback = wakeupCallback;
+    }
+
+    // Last sent report (without the report ID)
+    inline const uint8_t *getReport() const {
+        return _hidReport;
+    }
+
+    inline uint8_t getReportSize() const {
+        return _hidReportSize;
+    }
+
+    inline uint8_t getReportId() const {
+        return _hidReportId;
+    }
+
+    inline const uint8_t *getDescriptor() const {
+        return _hidReportDescriptor;
+    }
+
+    inline uint16_t getDescriptorSize() const {
+        return _hidSubDescriptor.length;
+    }
+
+    // Records every sent report into the trace (nullptr disables tracing)
+    inline void setTrace(JoystickTrace *trace) {
+        _trace = trace;
+    }
+
+    // Fields whose encoded value differs between the last two sent reports
+    inline uint16_t getChangedFields() const {
+        return _changedFields;
+    }
+
+    // Fields modified by setters since the last sent report
+    inline uint16_t getPendingFields() const {
+        return _pendingFields;
+    }
 };
 
 #endif // JOYSTICK_h
@@ -0,0 +1,51 @@
+//
+// JoystickAnalogInput.h
+//
+
+#ifndef JOYSTICK_ANALOG_INPUT_H
+#define JOYSTICK_ANALOG_INPUT_H
+
+#include "cstdint"
+
+// Multiplexed analog input: select lines of a CD4051/74HC4067 in front of an
+// ADC that converts without blocking. Abstract so the mux scan can run
+// against a simulated mux on the host.
+class JoystickAnalogInput {
+public:
+    virtual ~JoystickAnalogInput() = default;
+
+    // Drives the mux select lines
+    virtual void selectChannel(uint8_t channel) = 0;
+
+    virtual void startConversion() = 0;
+
+    virtual bool conversionReady() = 0;
+
+    virtual int16_t readConversion() = 0;
+};
+
+// Mux select lines on digital pins and the common line on an analog pin.
+// On AVR the conversion runs in the background, elsewhere it falls back to
+// analogRead() in startConversion().
+class JoystickArduinoAnalogInput : public JoystickAnalogInput {
+public:
+    JoystickArduinoAnalogInput(uint8_t analogPin, const uint8_t selectPins[], uint8_t selectPinCount);
+
+    void begin();
+
+    void selectChannel(uint8_t channel) override;
+
+    void startConversion() override;
+
+    bool conversionReady() override;
+
+    int16_t readConversion() override;
+
+private:
+    uint8_t _analogPin;
+    uint8_t _selectPins[4];
+    uint8_t _selectPinCount;
+    int16_t _value = 0;
+};
+
+#endif // JOYSTICK_ANALOG_INPUT_H
@@ -0,0 +1,72 @@
+//
+// JoystickAnalogMux.h
+//
+
+#ifndef JOYSTICK_ANALOG_MUX_H
+#define JOYSTICK_ANALOG_MUX_H
+
+#include "Joystick.h"
+#include "JoystickAnalogInput.h"
+#include "JoystickClock.h"
+
+#define JOYSTICK_ANALOG_MUX_CHANNEL_MAXIMUM        16
+#define JOYSTICK_ANALOG_MUX_DEFAULT_SETTLING_TIME  10
+
+// Non-blocking scan of a CD4051/74HC4067 mux. As soon as a conversion is
+// done the next channel is selected, so the mux settles while the previous
+// result is processed. Each finished sweep is written to the assigned
+// joystick fields as one batched update.
+class JoystickAnalogMux {
+public:
+    JoystickAnalogMux(Joystick_ &joystick, JoystickAnalogInput &input, JoystickClock clock = joystickDefaultClock);
+
+    // Routes a mux channel to an axis or simulator control
+    void assignChannel(uint8_t channel, JoystickField field);
+
+    void unassignChannel(uint8_t channel);
+
+    // Time in microseconds the mux output needs after switching
+    void setSettlingTime(uint32_t settlingTime);
+
+    // Call from loop(). Returns true when a sweep was completed and applied.
+    bool update();
+
+    int16_t getChannelValue(uint8_t channel) const;
+
+    // Duration of the last complete sweep in microseconds
+    uint32_t getSweepDuration() const;
+
+    uint32_t getSweepCount() const;
+
+private:
+    enum State : uint8_t {
+        STATE_IDLE,
+        STATE_SETTLING,
+        STATE_CONVERTING
+    };
+
+    Joystick_ &_joystick;
+    JoystickAnalogInput &_input;
+    JoystickClock _clock;
+    uint32_t _settlingTime = JOYSTICK_ANALOG_MUX_DEFAULT_SETTLING_TIME;
+
+    uint8_t _fields[JOYSTICK_ANALOG_MUX_CHANNEL_MAXIMUM];
+    int16_t _values[JOYSTICK_ANALOG_MUX_CHANNEL_MAXIMUM];
+    uint8_t _channels[JOYSTICK_ANALOG_MUX_CHANNEL_MAXIMUM];
+    uint8_t _channelCount = 0;
+
+    State _state = STATE_IDLE;
+    uint8_t _position = 0;
+    uint32_t _selectTime = 0;
+    uint32_t _sweepStart = 0;
+    uint32_t _sweepDuration = 0;
+    uint32_t _sweepCount = 0;
+
+    void rebuildChannels();
+
+    void selectPosition(uint8_t position, uint32_t now);
+
+    void applySweep();
+};
+
+#endif // JOYSTICK_ANALOG_MUX_H
@@ -0,0 +1,29 @@
+//
+// JoystickArduinoI2cBus.h
+//
+
+#ifndef JOYSTICK_ARDUINO_I2C_BUS_H
+#define JOYSTICK_ARDUINO_I2C_BUS_H
+
+#include "Wire.h"
+#include "JoystickI2cBus.h"
+
+#define JOYSTICK_I2C_DEFAULT_CLOCK 400000
+
+// Hardware I2C bus on top of the Wire library
+class JoystickArduinoI2cBus : public JoystickI2cBus {
+public:
+    explicit JoystickArduinoI2cBus(TwoWire &wire = Wire, uint32_t clock = JOYSTICK_I2C_DEFAULT_CLOCK);
+
+    void begin();
+
+    bool writeRegisters(uint8_t address, uint8_t reg, const uint8_t data[], uint8_t length) override;
+
+    bool readRegisters(uint8_t address, uint8_t reg, uint8_t buffer[], uint8_t length) override;
+
+private:
+    TwoWire &_wire;
+    uint32_t _clock;
+};
+
+#endif // JOYSTICK_ARDUINO_I2C_BUS_H
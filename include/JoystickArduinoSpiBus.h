@@ -0,0 +1,33 @@
+//
+// JoystickArduinoSpiBus.h
+//
+
+#ifndef JOYSTICK_ARDUINO_SPI_BUS_H
+#define JOYSTICK_ARDUINO_SPI_BUS_H
+
+#include "JoystickSpiBus.h"
+
+#define JOYSTICK_SPI_DEFAULT_CLOCK 4000000
+
+// Hardware SPI bus for 74HC165 chains: SCK to CLK, MISO to QH of the last
+// register, loadPin to SH/LD (CLK INH tied low).
+class JoystickArduinoSpiBus : public JoystickSpiBus {
+public:
+    explicit JoystickArduinoSpiBus(uint8_t loadPin, uint32_t clock = JOYSTICK_SPI_DEFAULT_CLOCK);
+
+    void begin();
+
+    void beginTransaction() override;
+
+    void endTransaction() override;
+
+    void latch() override;
+
+    void read(uint8_t buffer[], uint8_t length) override;
+
+private:
+    uint8_t _loadPin;
+    uint32_t _clock;
+};
+
+#endif // JOYSTICK_ARDUINO_SPI_BUS_H
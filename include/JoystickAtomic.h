@@ -0,0 +1,121 @@
+//
+// JoystickAtomic.h
+//
+
+#ifndef JOYSTICK_ATOMIC_H
+#define JOYSTICK_ATOMIC_H
+
+#include <stdint.h>
+
+#if defined(ARDUINO_ARCH_AVR)
+#include <util/atomic.h>
+
+// avr-gcc has no <atomic>. With one core the only concurrency is an interrupt,
+// so every access is done with interrupts disabled, which is also a compiler
+// barrier; the memory order is not needed.
+typedef uint8_t JoystickMemoryOrder;
+
+#define JOYSTICK_MEMORY_RELAXED 0
+#define JOYSTICK_MEMORY_ACQUIRE 0
+#define JOYSTICK_MEMORY_RELEASE 0
+
+template<typename T>
+class JoystickAtomic {
+public:
+    constexpr JoystickAtomic(T value = 0) : _value(value) {}
+
+    JoystickAtomic(const JoystickAtomic &) = delete;
+
+    JoystickAtomic &operator=(const JoystickAtomic &) = delete;
+
+    inline T load(JoystickMemoryOrder order) const {
+        T value;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            value = _value;
+        }
+        return value;
+    }
+
+    inline void store(T value, JoystickMemoryOrder order) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            _value = value;
+        }
+    }
+
+    inline T exchange(T value, JoystickMemoryOrder order) {
+        T previous;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            previous = _value;
+            _value = value;
+        }
+        return previous;
+    }
+
+    inline T fetchOr(T value, JoystickMemoryOrder order) {
+        T previous;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            previous = _value;
+            _value = previous | value;
+        }
+        return previous;
+    }
+
+    inline T fetchAdd(T value, JoystickMemoryOrder order) {
+        T previous;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            previous = _value;
+            _value = previous + value;
+        }
+        return previous;
+    }
+
+private:
+    volatile T _value;
+};
+
+#else
+#include <atomic>
+
+typedef std::memory_order JoystickMemoryOrder;
+
+#define JOYSTICK_MEMORY_RELAXED std::memory_order_relaxed
+#define JOYSTICK_MEMORY_ACQUIRE std::memory_order_acquire
+#define JOYSTICK_MEMORY_RELEASE std::memory_order_release
+
+// Thin wrapper so the lock-free queues read the same on every architecture
+template<typename T>
+class JoystickAtomic {
+public:
+    constexpr JoystickAtomic(T value = 0) : _value(value) {}
+
+    JoystickAtomic(const JoystickAtomic &) = delete;
+
+    JoystickAtomic &operator=(const JoystickAtomic &) = delete;
+
+    inline T load(JoystickMemoryOrder order) const {
+        return _value.load(order);
+    }
+
+    inline void store(T value, JoystickMemoryOrder order) {
+        _value.store(value, order);
+    }
+
+    inline T exchange(T value, JoystickMemoryOrder order) {
+        return _value.exchange(value, order);
+    }
+
+    inline T fetchOr(T value, JoystickMemoryOrder order) {
+        return _value.fetch_or(value, order);
+    }
+
+    inline T fetchAdd(T value, JoystickMemoryOrder order) {
+        return _value.fetch_add(value, order);
+    }
+
+private:
+    std::atomic<T> _value;
+};
+
+#endif
+
+#endif // JOYSTICK_ATOMIC_H
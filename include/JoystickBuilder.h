@@ -7,10 +7,109 @@
 
 #include "cstdint"
 
+#define JOYSTICK_DESCRIPTOR_SIZE_MAXIMUM 200
+
+#define JOYSTICK_INCLUDE_X_AXIS  0b00000001
+#define JOYSTICK_INCLUDE_Y_AXIS  0b00000010
+#define JOYSTICK_INCLUDE_Z_AXIS  0b00000100
+#define JOYSTICK_INCLUDE_RX_AXIS 0b00001000
+#define JOYSTICK_INCLUDE_RY_AXIS 0b00010000
+#define JOYSTICK_INCLUDE_RZ_AXIS 0b00100000
+#define JOYSTICK_AXIS_COUNT      6
+
+#define JOYSTICK_INCLUDE_RUDDER      0b00000001
+#define JOYSTICK_INCLUDE_THROTTLE    0b00000010
+#define JOYSTICK_INCLUDE_ACCELERATOR 0b00000100
+#define JOYSTICK_INCLUDE_BRAKE       0b00001000
+#define JOYSTICK_INCLUDE_STEERING    0b00010000
+#define JOYSTICK_SIMULATOR_COUNT     5
+
+// Full-speed interrupt endpoint
+#define JOYSTICK_MAX_PACKET_SIZE_DEFAULT 64
+
+// Report layout arithmetic shared by JoystickBuilder and JoystickStatic, so the
+// report size is derived in exactly one place and is available at compile time.
+constexpr uint8_t joystickBitCount(uint8_t value) {
+    return (value == 0) ? 0 : (uint8_t) ((value & 1) + joystickBitCount(value >> 1));
+}
+
+// Buttons are padded to a full byte, one or two hat switches share a byte and
+// every axis or simulator control takes 16 bits.
+constexpr uint16_t joystickReportBits(uint8_t buttonCount, uint8_t hatSwitchCount, uint8_t axisCount,
+                                      uint8_t simulatorCount) {
+    return (uint16_t) (((buttonCount + 7) / 8) * 8 + ((hatSwitchCount > 0) ? 8 : 0) +
+                       16 * (axisCount + simulatorCount));
+}
+
+constexpr uint8_t joystickReportSize(uint8_t buttonCount, uint8_t hatSwitchCount, uint8_t axisCount,
+                                     uint8_t simulatorCount) {
+    return (uint8_t) (joystickReportBits(buttonCount, hatSwitchCount, axisCount, simulatorCount) / 8);
+}
+
+constexpr uint8_t joystickPaddingBits(uint8_t buttonCount, uint8_t hatSwitchCount) {
+    return (uint8_t) ((8 - buttonCount % 8) % 8 + ((hatSwitchCount == 1) ? 4 : 0));
+}
+
+// Bytes the same fields would take packed without any padding
+constexpr uint8_t joystickPackedReportSize(uint8_t buttonCount, uint8_t hatSwitchCount, uint8_t axisCount,
+                                           uint8_t simulatorCount) {
+    return (uint8_t) ((buttonCount + 4 * ((hatSwitchCount > 2) ? 2 : hatSwitchCount) +
+                       16 * (axisCount + simulatorCount) + 7) / 8);
+}
+
+// Runs of consecutive included axes that are all relative (or all absolute);
+// the descriptor has one input item per run
+constexpr uint8_t joystickAxisRunCount(uint8_t axisFlags, uint8_t relativeAxisFlags, bool relative,
+                                       uint8_t axis = 0, bool inRun = false) {
+    return (axis >= JOYSTICK_AXIS_COUNT) ? 0 :
+           !(axisFlags & (1 << axis)) ? joystickAxisRunCount(axisFlags, relativeAxisFlags, relative, axis + 1, inRun) :
+           ((((relativeAxisFlags >> axis) & 1) != 0) != relative)
+           ? joystickAxisRunCount(axisFlags, relativeAxisFlags, relative, axis + 1, false)
+           : (uint8_t) ((inRun ? 0 : 1) + joystickAxisRunCount(axisFlags, relativeAxisFlags, relative, axis + 1, true));
+}
+
+// Size of the descriptor JoystickBuilder::buildDescriptor() writes, item by
+// item in the same order
+constexpr uint8_t joystickDescriptorSize(uint8_t buttonCount, uint8_t hatSwitchCount, uint8_t axisFlags,
+                                         uint8_t relativeAxisFlags, uint8_t simulatorCount,
+                                         bool applicationCollectionOpen = false) {
+    return (uint8_t) (8                                                                // usage, collection, report ID
+                      + ((buttonCount > 0) ? 20 + ((buttonCount % 8 > 0) ? 6 : 0) : 0)  // buttons and padding
+                      + (((axisFlags != 0) || (hatSwitchCount > 0)) ? 2 : 0)           // generic desktop page
+                      + ((hatSwitchCount > 0) ? 19 + ((hatSwitchCount > 1) ? 19 : 6) : 0)
+                      + ((axisFlags != 0) ? 7 + 2 * joystickBitCount(axisFlags)
+                                            + 10 * joystickAxisRunCount(axisFlags, relativeAxisFlags, true)
+                                            + 11 * joystickAxisRunCount(axisFlags, relativeAxisFlags, false) : 0)
+                      + ((simulatorCount > 0) ? 18 + 2 * simulatorCount : 0)
+                      + (applicationCollectionOpen ? 0 : 1));
+}
+
+// Largest layout: padded buttons, two hats, alternating absolute and
+// relative axes and all simulator controls
+static_assert(joystickDescriptorSize(63, 2, 0x3F, 0x15, JOYSTICK_SIMULATOR_COUNT) <= JOYSTICK_DESCRIPTOR_SIZE_MAXIMUM,
+              "JOYSTICK_DESCRIPTOR_SIZE_MAXIMUM is too small");
+
+struct JoystickReportPlan {
+    uint16_t reportBits;     // input report payload
+    uint8_t reportSize;      // input report payload in bytes
+    uint8_t paddingBits;     // constant bits in the report
+    uint8_t paddingBytes;    // bytes a packed layout of the same fields saves
+    uint8_t descriptorSize;
+    uint8_t transferSize;    // report plus report ID prefix
+    uint32_t bandwidth;      // bytes per second
+    bool exceedsPacketSize;  // report does not fit into one packet
+    bool wastesPadding;      // padding costs at least one byte per report
+};
+
+struct JoystickConfig;
+
 class JoystickBuilder {
 public:
     JoystickBuilder(uint8_t hidReportId, uint8_t joystickType);
 
+    // Restores the layout stored in a (valid) configuration blob
+    explicit JoystickBuilder(const JoystickConfig &config);
+
     JoystickBuilder &includeXAxis(bool include);
 
     JoystickBuilder &includeYAxis(bool include);
@@ -33,17 +132,62 @@ public:
 
     JoystickBuilder &includeSteering(bool include);
 
+    // Includes the axes / simulator controls of a JOYSTICK_INCLUDE_* mask
+    JoystickBuilder &includeAxes(uint8_t axisFlags);
+
+    JoystickBuilder &includeSimulatorControls(uint8_t simulatorFlags);
+
+    // Relative axes report deltas (-32767..32767) instead of positions
+    JoystickBuilder &setXAxisRelative(bool relative);
+
+    JoystickBuilder &setYAxisRelative(bool relative);
+
+    JoystickBuilder &setZAxisRelative(bool relative);
+
+    JoystickBuilder &setRxAxisRelative(bool relative);
+
+    JoystickBuilder &setRyAxisRelative(bool relative);
+
+    JoystickBuilder &setRzAxisRelative(bool relative);
+
     JoystickBuilder &setButtonCount(uint8_t buttonCount);
 
     JoystickBuilder &setHatSwitchCount(uint8_t hatSwitchCount);
 
+    // Leaves the application collection open so that a following descriptor
+    // (e.g. JoystickForceFeedback) can add its reports to the same device
+    // collection and close it
+    JoystickBuilder &setApplicationCollectionOpen(bool open);
+
+    // Size of the report descriptor in bytes (joystickDescriptorSize(), no
+    // descriptor is built)
     uint8_t getHidSize() const;
 
+    // Stores the layout into a configuration blob
+    void captureConfig(JoystickConfig &config) const;
+
+    uint16_t getReportBits() const;
+
+    uint8_t getReportSize() const;
+
+    uint8_t getPaddingBits() const;
+
+    // Bytes per second used when reportIdCount reports of this layout are
+    // each sent at pollRate (Hz), including the report ID prefix.
+    uint32_t getBandwidth(uint16_t pollRate, uint8_t reportIdCount = 1) const;
+
+    JoystickReportPlan plan(uint16_t pollRate, uint8_t reportIdCount = 1,
+                            uint8_t maxPacketSize = JOYSTICK_MAX_PACKET_SIZE_DEFAULT) const;
+
     uint8_t getAxisFlags() const;
 
+    uint8_t getRelativeAxisFlags() const;
+
     uint8_t getSimulatorFlags() const;
 
-    void buildDescriptor(uint8_t *buffer) const;
+    // Writes the report descriptor (at most JOYSTICK_DESCRIPTOR_SIZE_MAXIMUM
+    // bytes) and returns its size
+    uint8_t buildDescriptor(uint8_t *buffer) const;
 
     uint8_t getReportId() const;
 
@@ -71,7 +215,10 @@ private:
     uint8_t _joystickType;
     uint8_t _buttonCount = 0;
     uint8_t _hatSwitchCount = 0;
+    uint8_t _relativeAxisFlags = 0;
+    bool _applicationCollectionOpen = false;
 
+    JoystickBuilder &setAxisRelative(uint8_t axisFlag, bool relative);
 
     uint8_t getButtonPaddingBits() const;
 };
@@ -0,0 +1,22 @@
+//
+// JoystickClock.h
+//
+
+#ifndef JOYSTICK_CLOCK_H
+#define JOYSTICK_CLOCK_H
+
+#include "cstdint"
+
+// Microsecond time source used by the scheduling helpers. Replace it with a
+// simulated clock to drive the helpers without hardware.
+typedef uint32_t (*JoystickClock)();
+
+// Default clock, backed by micros()
+uint32_t joystickDefaultClock();
+
+// Wrap-safe signed difference between two clock values (a - b)
+inline int32_t joystickTimeDifference(uint32_t a, uint32_t b) {
+    return (int32_t) (a - b);
+}
+
+#endif // JOYSTICK_CLOCK_H
@@ -0,0 +1,70 @@
+//
+// JoystickConfig.h
+//
+
+#ifndef JOYSTICK_CONFIG_H
+#define JOYSTICK_CONFIG_H
+
+#include "Joystick.h"
+
+#define JOYSTICK_CONFIG_MAGIC   0x434A
+#define JOYSTICK_CONFIG_VERSION 1
+
+// Ranges indexed by JoystickField: the six axes, then the simulator controls
+#define JOYSTICK_CONFIG_RANGE_COUNT (JOYSTICK_AXIS_COUNT + JOYSTICK_SIMULATOR_COUNT)
+
+struct JoystickRange {
+    int32_t minimum;
+    int32_t maximum;
+};
+
+// Everything a sketch sets up before begin(): the builder layout, the axis
+// ranges from calibration and the radial deadzones. Stored as one block so it
+// can be restored with a single read at power-on.
+struct JoystickConfig {
+    uint16_t magic;
+    uint8_t version;
+    uint8_t size;
+
+    // Layout (JoystickBuilder)
+    uint8_t reportId;
+    uint8_t joystickType;
+    uint8_t buttonCount;
+    uint8_t hatSwitchCount;
+    uint8_t axisFlags;
+    uint8_t relativeAxisFlags;
+    uint8_t simulatorFlags;
+    uint8_t reserved;
+
+    // Calibration (Joystick_)
+    JoystickRange ranges[JOYSTICK_CONFIG_RANGE_COUNT];
+    JoystickRadialSettings radialSettings[JOYSTICK_AXIS_PAIR_COUNT];
+
+    // Over all bytes before it
+    uint16_t crc;
+
+    // Fills in magic, version, size and crc
+    void seal();
+
+    // Checks magic, version, size and crc
+    bool isValid() const;
+};
+
+// Byte storage for a JoystickConfig (EEPROM, flash page, file, ...)
+class JoystickConfigStorage {
+public:
+    virtual ~JoystickConfigStorage() = default;
+
+    virtual bool read(uint16_t address, uint8_t data[], uint16_t length) = 0;
+
+    virtual bool write(uint16_t address, const uint8_t data[], uint16_t length) = 0;
+
+    // Reads the whole blob in one block. Returns false (and leaves config
+    // undefined) if nothing valid is stored.
+    bool load(JoystickConfig &config, uint16_t address = 0);
+
+    // Seals and writes the blob
+    bool save(JoystickConfig &config, uint16_t address = 0);
+};
+
+#endif // JOYSTICK_CONFIG_H
@@ -0,0 +1,73 @@
+//
+// JoystickDeltaQueue.h
+//
+
+#ifndef JOYSTICK_DELTA_QUEUE_H
+#define JOYSTICK_DELTA_QUEUE_H
+
+#include "JoystickAtomic.h"
+#include "Joystick.h"
+
+// Number of queued deltas, must be a power of two
+#ifndef JOYSTICK_DELTA_QUEUE_SIZE
+#define JOYSTICK_DELTA_QUEUE_SIZE 64
+#endif
+
+struct JoystickDelta {
+    uint8_t field;   // JoystickField
+    uint8_t index;   // button number for JOYSTICK_FIELD_BUTTONS
+    int32_t value;
+};
+
+// Lock-free single-producer/single-consumer ring of state deltas. The input
+// scanner (producer) pushes deltas from one core, the report task (consumer)
+// applies them to the joystick in batches from the other, so a slow
+// SendReport never blocks scanning.
+//
+// The queue also mirrors the newest value of every field and button. A delta
+// that does not fit only marks its field dirty, and the next apply() that
+// empties the queue sends the mirrored value, so an overflow delays a change
+// but never loses it (e.g. a stuck button after a dropped release). Fields
+// fed through the queue should not also be set directly on the joystick.
+class JoystickDeltaQueue {
+public:
+    JoystickDeltaQueue();
+
+    // Producer side. Returns false (and counts a drop) if the queue is full;
+    // the value is then resent from the mirror.
+    bool push(const JoystickDelta &delta);
+
+    bool pushField(JoystickField field, int32_t value);
+
+    bool pushButton(uint8_t button, bool pressed);
+
+    // Consumer side
+    bool pop(JoystickDelta &delta);
+
+    // Applies up to maxCount deltas as one batched update, followed by the
+    // mirrored values of overflowed fields once the queue is empty. Returns
+    // the number of deltas applied.
+    uint16_t apply(Joystick_ &joystick, uint16_t maxCount = JOYSTICK_DELTA_QUEUE_SIZE);
+
+    uint16_t size() const;
+
+    uint32_t getDroppedCount() const;
+
+private:
+    JoystickDelta _buffer[JOYSTICK_DELTA_QUEUE_SIZE];
+    JoystickAtomic<uint16_t> _head;
+    JoystickAtomic<uint16_t> _tail;
+    JoystickAtomic<uint32_t> _dropped;
+
+    // Newest pushed values, written by the producer only
+    JoystickAtomic<int32_t> _latestValues[JOYSTICK_FIELD_BUTTONS];
+    JoystickAtomic<uint8_t> _latestButtons[JOYSTICK_BUTTON_COUNT_MAXIMUM / 8];
+
+    // Fields (JOYSTICK_FIELD_MASK bits) and button bytes to resend
+    JoystickAtomic<uint16_t> _overflowFields;
+    JoystickAtomic<uint8_t> _overflowButtonBytes;
+
+    void applyOverflow(Joystick_ &joystick, uint16_t fields, uint8_t buttonBytes);
+};
+
+#endif // JOYSTICK_DELTA_QUEUE_H
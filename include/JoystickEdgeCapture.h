@@ -0,0 +1,115 @@
+//
+// JoystickEdgeCapture.h
+//
+
+#ifndef JOYSTICK_EDGE_CAPTURE_H
+#define JOYSTICK_EDGE_CAPTURE_H
+
+#include "JoystickAtomic.h"
+#include "Joystick.h"
+#include "JoystickClock.h"
+
+// Number of queued edges, must be a power of two (at most 128)
+#ifndef JOYSTICK_EDGE_QUEUE_SIZE
+#define JOYSTICK_EDGE_QUEUE_SIZE 32
+#endif
+
+#define JOYSTICK_EDGE_INPUT_MAXIMUM    32
+#define JOYSTICK_EDGE_DEFAULT_DEBOUNCE 5000
+
+struct JoystickEdge {
+    uint32_t time;   // clock at the interrupt
+    uint8_t input;
+    uint8_t level;   // pin level, not yet corrected for active-low
+};
+
+// Button input for directly wired pins, driven by pin-change interrupts
+// instead of polling. The interrupt handlers push each edge with its
+// timestamp into a lock-free ring; update() debounces the edges in time
+// order and applies all accepted changes as one batched button update.
+//
+// Debouncing is eager: the first edge is applied right away and further
+// edges of that input are ignored for the debounce time, after which the
+// level is checked once more. If the ring overflows, the affected inputs
+// are flagged in a bitmap and read directly on the next update(), so the
+// state is never lost, only the timestamp.
+//
+// All capture() calls must come from interrupt handlers that do not
+// preempt each other (always the case on AVR).
+class JoystickEdgeCapture {
+public:
+    explicit JoystickEdgeCapture(Joystick_ &joystick, JoystickClock clock = joystickDefaultClock);
+
+    // Returns the input number for capture(), -1 if all inputs are used
+    int8_t addInput(uint8_t pin, uint8_t button, bool activeLow = true);
+
+    // In microseconds
+    void setDebounceTime(uint32_t debounceTime);
+
+    // Configures the pins and applies their current levels. Attach the
+    // interrupts afterwards.
+    void begin();
+
+    // Interrupt side: records an edge of one input, reading the pin
+    void capture(uint8_t input);
+
+    void capture(uint8_t input, bool level);
+
+    // Records edges of several inputs (bit per input) with one timestamp,
+    // e.g. from a port-wide pin-change handler
+    void captureInputs(uint32_t inputs, uint32_t levels);
+
+    // Call from loop(). Returns true if a button changed.
+    bool update();
+
+    bool isPressed(uint8_t input) const;
+
+    inline uint32_t getEdgeCount() const {
+        return _edgeCount;
+    }
+
+    // Edges that did not fit into the ring
+    uint32_t getOverflowCount() const;
+
+    // Time from the interrupt of the oldest edge in an update to the end of
+    // the report it caused, in microseconds
+    inline uint32_t getLastLatency() const {
+        return _lastLatency;
+    }
+
+    inline uint32_t getMaximumLatency() const {
+        return _maximumLatency;
+    }
+
+private:
+    Joystick_ &_joystick;
+    JoystickClock _clock;
+    uint32_t _debounceTime = JOYSTICK_EDGE_DEFAULT_DEBOUNCE;
+
+    uint8_t _inputCount = 0;
+    uint8_t _pins[JOYSTICK_EDGE_INPUT_MAXIMUM];
+    uint8_t _buttons[JOYSTICK_EDGE_INPUT_MAXIMUM];
+    uint32_t _activeLow = 0;
+
+    // Bit per input: last seen (pressed) level and debounced state
+    uint32_t _rawStates = 0;
+    uint32_t _states = 0;
+    uint32_t _rawTimes[JOYSTICK_EDGE_INPUT_MAXIMUM];
+    uint32_t _changeTimes[JOYSTICK_EDGE_INPUT_MAXIMUM];
+
+    JoystickEdge _buffer[JOYSTICK_EDGE_QUEUE_SIZE];
+    JoystickAtomic<uint8_t> _head;
+    JoystickAtomic<uint8_t> _tail;
+    JoystickAtomic<uint32_t> _overflowInputs;
+    JoystickAtomic<uint32_t> _overflowCount;
+
+    uint32_t _edgeCount = 0;
+    uint32_t _lastLatency = 0;
+    uint32_t _maximumLatency = 0;
+
+    void push(uint8_t input, bool level, uint32_t time);
+
+    void record(uint8_t input, bool level, uint32_t time);
+};
+
+#endif // JOYSTICK_EDGE_CAPTURE_H
@@ -0,0 +1,20 @@
+//
+// JoystickEepromStorage.h
+//
+
+#ifndef JOYSTICK_EEPROM_STORAGE_H
+#define JOYSTICK_EEPROM_STORAGE_H
+
+#include "JoystickConfig.h"
+
+// JoystickConfig storage in the Arduino EEPROM (or its flash emulation on
+// ESP8266/ESP32, where EEPROM.begin() must have been called with a large
+// enough size). Only bytes that differ are written.
+class JoystickEepromStorage : public JoystickConfigStorage {
+public:
+    bool read(uint16_t address, uint8_t data[], uint16_t length) override;
+
+    bool write(uint16_t address, const uint8_t data[], uint16_t length) override;
+};
+
+#endif // JOYSTICK_EEPROM_STORAGE_H
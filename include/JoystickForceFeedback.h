@@ -0,0 +1,193 @@
+//
+// JoystickForceFeedback.h
+//
+
+#ifndef JOYSTICK_FORCE_FEEDBACK_H
+#define JOYSTICK_FORCE_FEEDBACK_H
+
+#include "Joystick.h"
+
+// First of the JOYSTICK_FFB_REPORT_COUNT consecutive report IDs. Fixed at
+// compile time so the descriptor can stay a constant table.
+#ifndef JOYSTICK_FFB_REPORT_ID
+#define JOYSTICK_FFB_REPORT_ID 0x10
+#endif
+
+// Number of effect blocks in the pool (at most 127)
+#ifndef JOYSTICK_FFB_EFFECT_COUNT
+#define JOYSTICK_FFB_EFFECT_COUNT 8
+#endif
+
+#define JOYSTICK_FFB_AXIS_COUNT        2
+#define JOYSTICK_FFB_FORCE_MAXIMUM     10000
+#define JOYSTICK_FFB_DURATION_INFINITE 0xFFFF
+#define JOYSTICK_FFB_LOOP_INFINITE     0xFF
+
+// Velocity (in force units per tick) that a one force unit position change per
+// tick corresponds to for damper effects
+#ifndef JOYSTICK_FFB_VELOCITY_SCALE
+#define JOYSTICK_FFB_VELOCITY_SCALE 100
+#endif
+
+static_assert(JOYSTICK_FFB_EFFECT_COUNT <= 127, "JOYSTICK_FFB_EFFECT_COUNT must not exceed 127");
+
+// Report IDs relative to JOYSTICK_FFB_REPORT_ID
+enum JoystickForceFeedbackReport : uint8_t {
+    JOYSTICK_FFB_REPORT_STATE = 0,       // input
+    JOYSTICK_FFB_REPORT_SET_EFFECT,      // output
+    JOYSTICK_FFB_REPORT_SET_CONDITION,   // output
+    JOYSTICK_FFB_REPORT_SET_PERIODIC,    // output
+    JOYSTICK_FFB_REPORT_SET_CONSTANT,    // output
+    JOYSTICK_FFB_REPORT_EFFECT_OPERATION, // output
+    JOYSTICK_FFB_REPORT_BLOCK_FREE,      // output
+    JOYSTICK_FFB_REPORT_DEVICE_CONTROL,  // output
+    JOYSTICK_FFB_REPORT_DEVICE_GAIN,     // output
+    JOYSTICK_FFB_REPORT_CREATE_EFFECT,   // feature (set)
+    JOYSTICK_FFB_REPORT_BLOCK_LOAD,      // feature (get)
+    JOYSTICK_FFB_REPORT_POOL,            // feature (get)
+    JOYSTICK_FFB_REPORT_COUNT
+};
+
+// Effect types in descriptor order
+enum JoystickEffectType : uint8_t {
+    JOYSTICK_EFFECT_NONE = 0,
+    JOYSTICK_EFFECT_CONSTANT,
+    JOYSTICK_EFFECT_SQUARE,
+    JOYSTICK_EFFECT_SINE,
+    JOYSTICK_EFFECT_TRIANGLE,
+    JOYSTICK_EFFECT_SAWTOOTH_UP,
+    JOYSTICK_EFFECT_SAWTOOTH_DOWN,
+    JOYSTICK_EFFECT_SPRING,
+    JOYSTICK_EFFECT_DAMPER
+};
+
+struct JoystickEffectCondition {
+    int16_t centerOffset;
+    int16_t positiveCoefficient;
+    int16_t negativeCoefficient;
+    uint16_t positiveSaturation;
+    uint16_t negativeSaturation;
+    uint16_t deadBand;
+};
+
+struct JoystickEffect {
+    uint8_t type;            // JoystickEffectType, JOYSTICK_EFFECT_NONE if the block is free
+    bool playing;
+    uint8_t gain;
+    uint8_t axesEnable;      // bit per force feedback axis
+    bool directionEnable;
+    uint8_t direction;       // polar, 256 units per full turn
+    uint8_t loopCount;
+    uint8_t conditionMask;   // conditions received, bit per axis
+    uint16_t duration;       // ms
+    uint16_t startDelay;     // ms
+    uint32_t elapsed;        // ms since start
+    int16_t magnitude;
+    int16_t offset;
+    uint8_t phase;           // 256 units per full turn
+    uint16_t period;         // ms
+    JoystickEffectCondition conditions[JOYSTICK_FFB_AXIS_COUNT];
+};
+
+// Physical Interface Device (force feedback) support for a Joystick_.
+// Appends the PID output and feature reports to the joystick's application
+// collection, keeps a pre-allocated pool of effect blocks and computes the
+// resulting forces in fixed point from the joystick's axis positions.
+//
+// The joystick must be built with setApplicationCollectionOpen(true) and the
+// force feedback object constructed right after it. The HID core does not
+// forward output or feature reports to this library, so the USB glue has to
+// pass SET_REPORT data to handleOutputReport()/handleFeatureReport() and
+// answer GET_REPORT(Feature) with getFeatureReport().
+//
+// Forces follow the DirectInput convention: a direction of 0 is a force
+// coming from the north, i.e. pushing the stick towards positive Y.
+class JoystickForceFeedback {
+public:
+    explicit JoystickForceFeedback(Joystick_ &joystick);
+
+    // Joystick axes the force axes act on. JOYSTICK_FIELD_COUNT leaves the
+    // second force axis unused.
+    void setAxes(JoystickField firstAxis, JoystickField secondAxis = JOYSTICK_FIELD_COUNT);
+
+    // Output report from the host (data without the report ID). Returns
+    // false if the report is not a force feedback report.
+    bool handleOutputReport(uint8_t reportId, const uint8_t data[], uint8_t length);
+
+    // SET_REPORT(Feature) from the host
+    bool handleFeatureReport(uint8_t reportId, const uint8_t data[], uint8_t length);
+
+    // GET_REPORT(Feature). Returns the number of bytes written, 0 if the
+    // report is unknown.
+    uint8_t getFeatureReport(uint8_t reportId, uint8_t data[], uint8_t length) const;
+
+    // Advances all playing effects by one millisecond and recomputes the
+    // forces. Call at 1 kHz.
+    void tick();
+
+    // Force on a force axis from -JOYSTICK_FFB_FORCE_MAXIMUM to JOYSTICK_FFB_FORCE_MAXIMUM
+    inline int16_t getForce(uint8_t axis) const {
+        return (axis < JOYSTICK_FFB_AXIS_COUNT) ? _forces[axis] : 0;
+    }
+
+    // PID state input report (2 bytes)
+    void buildStateReport(uint8_t data[]) const;
+
+    void sendState();
+
+    const JoystickEffect *getEffect(uint8_t blockIndex) const;
+
+    inline bool isActuatorsEnabled() const {
+        return _actuatorsEnabled;
+    }
+
+    inline bool isPaused() const {
+        return _paused;
+    }
+
+    inline uint8_t getDeviceGain() const {
+        return _deviceGain;
+    }
+
+    const uint8_t *getDescriptor() const;
+
+    uint16_t getDescriptorSize() const;
+
+private:
+    Joystick_ &_joystick;
+    JoystickField _axes[JOYSTICK_FFB_AXIS_COUNT] = {JOYSTICK_FIELD_X_AXIS, JOYSTICK_FIELD_Y_AXIS};
+
+    JoystickEffect _effects[JOYSTICK_FFB_EFFECT_COUNT];
+
+    bool _actuatorsEnabled = true;
+    bool _paused = false;
+    uint8_t _deviceGain = 255;
+    uint8_t _lastBlockIndex = 0;
+    uint8_t _blockLoadStatus = 0;
+
+    int16_t _positions[JOYSTICK_FFB_AXIS_COUNT] = {0, 0};
+    int16_t _velocities[JOYSTICK_FFB_AXIS_COUNT] = {0, 0};
+    int16_t _forces[JOYSTICK_FFB_AXIS_COUNT] = {0, 0};
+
+    HIDSubDescriptor _hidSubDescriptor;
+
+    JoystickEffect *effectAt(uint8_t blockIndex);
+
+    void createEffect(uint8_t type);
+
+    void freeEffect(uint8_t blockIndex);
+
+    void startEffect(uint8_t blockIndex, uint8_t loopCount, bool solo);
+
+    void deviceControl(uint8_t control);
+
+    void updateAxes();
+
+    int32_t conditionForce(const JoystickEffect &effect, uint8_t axis) const;
+
+    int32_t periodicValue(const JoystickEffect &effect, uint32_t activeTime) const;
+
+    uint8_t freeBlockCount() const;
+};
+
+#endif // JOYSTICK_FORCE_FEEDBACK_H
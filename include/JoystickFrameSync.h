@@ -0,0 +1,101 @@
+//
+// JoystickFrameSync.h
+//
+
+#ifndef JOYSTICK_FRAME_SYNC_H
+#define JOYSTICK_FRAME_SYNC_H
+
+#include "Joystick.h"
+#include "JoystickClock.h"
+
+#define JOYSTICK_FRAME_SYNC_DEFAULT_INTERVAL  1000
+#define JOYSTICK_FRAME_SYNC_DEFAULT_LEAD_TIME  200
+
+// Reads the inputs and writes them into the joystick (without sending)
+typedef void (*JoystickSampleCallback)(Joystick_ &joystick);
+
+// Schedules input sampling and report encoding just before the host's next
+// poll instead of whenever a setter happens to run. The poll grid is anchored
+// on host events reported through pollObserved() (USB start-of-frame or IN
+// transfer complete) or, if the core offers no such hook, on the completion
+// time of the previous report.
+//
+// Without a hook the phase statistics are predictions from that grid, not
+// measurements of the actual poll.
+//
+// The joystick should be started with begin(false) so that only the frame
+// sync sends reports.
+class JoystickFrameSync {
+public:
+    explicit JoystickFrameSync(Joystick_ &joystick, JoystickClock clock = joystickDefaultClock);
+
+    // Host polling interval in microseconds (bInterval)
+    void setPollInterval(uint32_t pollInterval);
+
+    // Time in microseconds before the predicted poll at which sampling starts.
+    // Must cover sampling and encoding.
+    void setLeadTime(uint32_t leadTime);
+
+    void setSampleCallback(JoystickSampleCallback sampleCallback);
+
+    // Call from the start-of-frame hook or when the host has fetched a report
+    // (e.g. from a transfer complete callback). Only stores the timestamp, so
+    // it is safe to call from an interrupt handler; update() evaluates it.
+    void pollObserved();
+
+    // Call from loop(). Samples and sends when the next poll is within the
+    // lead time. Returns true if a report was sent.
+    bool update();
+
+    uint32_t getNextPoll() const;
+
+    // Sample-to-poll phase of the last report in microseconds (measured with
+    // pollObserved(), predicted without)
+    int32_t getLastPhase() const;
+
+    int32_t getMinimumPhase() const;
+
+    int32_t getMaximumPhase() const;
+
+    int32_t getAveragePhase() const;
+
+    // Duration of the last sample callback plus encode/send in microseconds
+    uint32_t getLastSampleDuration() const;
+
+    void resetStatistics();
+
+private:
+    Joystick_ &_joystick;
+    JoystickClock _clock;
+    JoystickSampleCallback _sampleCallback = nullptr;
+
+    uint32_t _pollInterval = JOYSTICK_FRAME_SYNC_DEFAULT_INTERVAL;
+    uint32_t _leadTime = JOYSTICK_FRAME_SYNC_DEFAULT_LEAD_TIME;
+
+    // Written by pollObserved(): first and last event since the last update()
+    volatile bool _hostEventPending = false;
+    volatile uint32_t _firstHostEvent = 0;
+    volatile uint32_t _lastHostEvent = 0;
+
+    bool _anchorValid = false;
+    bool _anchorFromHost = false;
+    uint32_t _anchor = 0;
+
+    bool _targetSampled = false;
+    bool _samplePending = false;
+    uint32_t _sampleTime = 0;
+    uint32_t _sampleTarget = 0;
+    uint32_t _lastSampleDuration = 0;
+
+    int32_t _lastPhase = 0;
+    int32_t _minimumPhase = 0;
+    int32_t _maximumPhase = 0;
+    int64_t _phaseSum = 0;
+    uint32_t _phaseCount = 0;
+
+    void takeHostEvents();
+
+    void recordPhase(int32_t phase);
+};
+
+#endif // JOYSTICK_FRAME_SYNC_H
@@ -0,0 +1,101 @@
+//
+// JoystickGroup.h
+//
+
+#ifndef JOYSTICK_GROUP_H
+#define JOYSTICK_GROUP_H
+
+#include "Joystick.h"
+#include "JoystickClock.h"
+
+#define JOYSTICK_GROUP_MAXIMUM                 8
+#define JOYSTICK_GROUP_DEFAULT_FRAME_LENGTH 1000
+
+// Several logical controllers sharing one endpoint. Controllers with pending
+// changes are sent round-robin, at most reportsPerFrame per frame, so every
+// controller gets a bounded latency and idle ones cost nothing.
+//
+// Under a bandwidth budget, reports carrying button or hat changes go first
+// and may overdraw the budget. Analog-only changes wait until the budget
+// allows them; they merge in the meantime so the latest value wins.
+//
+// The controllers should be started with begin(false) so that only the
+// group sends reports.
+class JoystickGroup {
+public:
+    explicit JoystickGroup(uint8_t reportsPerFrame = 1, uint32_t frameLength = JOYSTICK_GROUP_DEFAULT_FRAME_LENGTH,
+                           JoystickClock clock = joystickDefaultClock);
+
+    // Returns the controller index, or -1 if the group is full
+    int8_t add(Joystick_ &joystick);
+
+    uint8_t getCount() const;
+
+    Joystick_ &get(uint8_t index);
+
+    void setReportsPerFrame(uint8_t reportsPerFrame);
+
+    // Bytes per millisecond available to the group (0 disables the budget).
+    // burst is the most that can be saved up while idle; it is raised to at
+    // least one report (with its ID) of the largest controller.
+    void setBandwidthBudget(uint16_t bytesPerMillisecond, uint16_t burst);
+
+    // Number of frames that ended with analog-only reports still waiting,
+    // whether held by reportsPerFrame or by the budget
+    uint32_t getDeferredCount() const;
+
+    // Number of frames in which the budget held back an analog-only report
+    uint32_t getBudgetDeferredCount() const;
+
+    // Forces a report for the controller even without pending changes
+    void markDirty(uint8_t index);
+
+    // Bitmask of controllers waiting for a report
+    uint8_t getDirtyMask() const;
+
+    // Call from loop(). Sends up to reportsPerFrame reports once per frame
+    // and returns the number of reports sent.
+    uint8_t update();
+
+    // Most frames a controller had to wait for its report
+    uint16_t getMaximumWait(uint8_t index) const;
+
+    void resetStatistics();
+
+private:
+    Joystick_ *_joysticks[JOYSTICK_GROUP_MAXIMUM];
+    uint8_t _count = 0;
+    uint8_t _reportsPerFrame;
+    uint32_t _frameLength;
+    JoystickClock _clock;
+    uint32_t _frameStart;
+
+    uint16_t _budgetRate = 0;
+    uint16_t _budgetBurst = 0;
+    int32_t _budgetTokens = 0;
+    uint32_t _budgetTime = 0;
+    uint32_t _deferredCount = 0;
+    uint32_t _budgetDeferredCount = 0;
+
+    uint8_t _dirtyMask = 0;
+    uint8_t _digitalMask = 0;
+    uint8_t _forcedMask = 0;
+    uint8_t _next = 0;
+    uint16_t _waitFrames[JOYSTICK_GROUP_MAXIMUM];
+    uint16_t _maximumWait[JOYSTICK_GROUP_MAXIMUM];
+
+    // Returns true once per frame
+    bool startFrame();
+
+    void collectDirty();
+
+    void sendController(uint8_t index);
+
+    void clampBudgetBurst();
+
+    void refillBudget();
+
+    uint8_t sendPass(uint8_t candidates, uint8_t limit, bool budgeted);
+};
+
+#endif // JOYSTICK_GROUP_H
@@ -0,0 +1,24 @@
+//
+// JoystickI2cBus.h
+//
+
+#ifndef JOYSTICK_I2C_BUS_H
+#define JOYSTICK_I2C_BUS_H
+
+#include "cstdint"
+
+// Minimal I2C interface used by the input drivers, so they can run against
+// a simulated device on the host. Addresses are 7-bit.
+class JoystickI2cBus {
+public:
+    virtual ~JoystickI2cBus() = default;
+
+    // Writes length bytes starting at register reg. Returns false on a NACK.
+    virtual bool writeRegisters(uint8_t address, uint8_t reg, const uint8_t data[], uint8_t length) = 0;
+
+    // Reads length bytes starting at register reg in one transaction
+    // (repeated start). Returns false on a NACK or short read.
+    virtual bool readRegisters(uint8_t address, uint8_t reg, uint8_t buffer[], uint8_t length) = 0;
+};
+
+#endif // JOYSTICK_I2C_BUS_H
@@ -0,0 +1,104 @@
+//
+// JoystickIdleManager.h
+//
+
+#ifndef JOYSTICK_IDLE_MANAGER_H
+#define JOYSTICK_IDLE_MANAGER_H
+
+#include "Joystick.h"
+#include "JoystickClock.h"
+
+#define JOYSTICK_IDLE_DEFAULT_ACTIVE_INTERVAL    1000
+#define JOYSTICK_IDLE_DEFAULT_IDLE_INTERVAL     50000
+#define JOYSTICK_IDLE_DEFAULT_TIMEOUT         5000000
+
+// Reads the inputs and writes them into the joystick (without sending)
+typedef void (*JoystickScanCallback)(Joystick_ &joystick);
+
+// Puts the CPU to sleep for at most maxSleep microseconds; any interrupt may
+// end it early. JOYSTICK_IDLE_SLEEP_FOREVER means only an interrupt wakes up.
+typedef void (*JoystickSleepCallback)(uint32_t maxSleep);
+
+#define JOYSTICK_IDLE_SLEEP_FOREVER 0xFFFFFFFF
+
+// Runs the scan loop at full rate while inputs change and drops to a slow
+// rate (or stops scanning) once nothing has changed for the idle timeout.
+// While idle the sleep callback is called between scans. An input edge
+// reported through wake() (e.g. from a pin-change interrupt) switches back to
+// full rate and is scanned and sent on the next update() instead of waiting
+// for the slow cycle.
+//
+// Reports are only sent when a setter actually changed a field, so the
+// joystick should be started with begin(false).
+class JoystickIdleManager {
+public:
+    explicit JoystickIdleManager(Joystick_ &joystick, JoystickClock clock = joystickDefaultClock);
+
+    void setScanCallback(JoystickScanCallback scanCallback);
+
+    void setSleepCallback(JoystickSleepCallback sleepCallback);
+
+    // Scan interval while active, in microseconds
+    void setActiveInterval(uint32_t activeInterval);
+
+    // Scan interval while idle, in microseconds. 0 stops scanning until wake().
+    void setIdleInterval(uint32_t idleInterval);
+
+    // Time without changes after which scanning slows down, in microseconds
+    void setIdleTimeout(uint32_t idleTimeout);
+
+    // Safe to call from an interrupt handler
+    void wake();
+
+    // Call from loop(). Returns true if a report was sent.
+    bool update();
+
+    inline bool isIdle() const {
+        return _idle;
+    }
+
+    inline uint32_t getScanCount() const {
+        return _scanCount;
+    }
+
+    // Time from wake() to the end of the report it caused, in microseconds
+    inline uint32_t getLastWakeLatency() const {
+        return _lastWakeLatency;
+    }
+
+    inline uint32_t getMaximumWakeLatency() const {
+        return _maximumWakeLatency;
+    }
+
+private:
+    Joystick_ &_joystick;
+    JoystickClock _clock;
+    JoystickScanCallback _scanCallback = nullptr;
+    JoystickSleepCallback _sleepCallback = nullptr;
+
+    uint32_t _activeInterval = JOYSTICK_IDLE_DEFAULT_ACTIVE_INTERVAL;
+    uint32_t _idleInterval = JOYSTICK_IDLE_DEFAULT_IDLE_INTERVAL;
+    uint32_t _idleTimeout = JOYSTICK_IDLE_DEFAULT_TIMEOUT;
+
+    bool _idle = false;
+    bool _started = false;
+    uint32_t _lastScan = 0;
+    uint32_t _lastActivity = 0;
+    uint32_t _scanCount = 0;
+
+    volatile bool _wakeRequested = false;
+    volatile uint32_t _wakeTime = 0;
+    uint32_t _lastWakeLatency = 0;
+    uint32_t _maximumWakeLatency = 0;
+
+    bool scan(uint32_t now);
+};
+
+#if defined(ARDUINO_ARCH_AVR)
+// Sleep callback for AVR: idle sleep mode, woken by any interrupt. The
+// millis() timer ends the sleep after at most one overflow (1024 us at
+// 16 MHz), so it does not sleep at all if maxSleep is shorter than that.
+void joystickSleepIdle(uint32_t maxSleep);
+#endif
+
+#endif // JOYSTICK_IDLE_MANAGER_H
@@ -0,0 +1,128 @@
+//
+// JoystickLink.h
+//
+
+#ifndef JOYSTICK_LINK_H
+#define JOYSTICK_LINK_H
+
+#include "Joystick.h"
+
+// Binary protocol for remote input nodes (UART, RS-485, ...) that feed one
+// Joystick_. A frame carries only the fields that changed since the node's
+// previous frame:
+//
+//   0xA5 | length | node | sequence | entries (length bytes) | CRC-16 (LE)
+//
+// The CRC (joystickCrc16) covers length, node, sequence and the entries.
+// Bits 0-6 of the node byte are the node ID, bit 7 marks a key frame.
+// An entry starts with a tag: bits 0-4 the JoystickField, bits 5-6 the value
+// size (0: int8, 1: int16, 2: int32) followed by the value in little endian.
+// JOYSTICK_FIELD_BUTTONS is followed by the first button byte, the byte count
+// and the bitmap bytes instead. Values are absolute, so periodic key frames
+// (all fields) repair the state after a lost frame. A key frame is accepted
+// with any sequence number, so a node that restarted its sequence (e.g.
+// after a reset, whose first frame is always a key frame) is resynced.
+
+#define JOYSTICK_LINK_SYNC             0xA5
+#define JOYSTICK_LINK_HEADER_SIZE      4
+#define JOYSTICK_LINK_PAYLOAD_MAXIMUM  80
+#define JOYSTICK_LINK_FRAME_MAXIMUM    (JOYSTICK_LINK_HEADER_SIZE + JOYSTICK_LINK_PAYLOAD_MAXIMUM + 2)
+#define JOYSTICK_LINK_NODE_COUNT       8
+#define JOYSTICK_LINK_NODE_MASK        0x7F
+#define JOYSTICK_LINK_KEY_FRAME        0x80
+#define JOYSTICK_LINK_DEFAULT_KEY_FRAME_INTERVAL 50
+
+// Node side: collects the node's input state and encodes the changes
+class JoystickLinkEncoder {
+public:
+    explicit JoystickLinkEncoder(uint8_t nodeId);
+
+    // Every n-th call of encode() sends all fields (0 disables periodic key
+    // frames; the first frame is a key frame in any case)
+    void setKeyFrameInterval(uint8_t keyFrameInterval);
+
+    // Axis, simulator control or hat switch
+    void setField(JoystickField field, int32_t value);
+
+    void setButton(uint8_t button, bool pressed);
+
+    void setButtonBytes(uint8_t firstByte, const uint8_t values[], uint8_t count);
+
+    // Writes the next frame into buffer (at least JOYSTICK_LINK_FRAME_MAXIMUM
+    // bytes). Returns its length, 0 if nothing changed and no key frame is due.
+    uint8_t encode(uint8_t buffer[]);
+
+private:
+    uint8_t _nodeId;
+    uint8_t _sequence = 0;
+    uint8_t _keyFrameInterval = JOYSTICK_LINK_DEFAULT_KEY_FRAME_INTERVAL;
+    uint8_t _framesSinceKeyFrame = 0;
+    bool _started = false;
+
+    // Fields set at least once / changed since the last frame
+    uint16_t _usedFields = 0;
+    uint16_t _dirtyFields = 0;
+    int32_t _values[JOYSTICK_FIELD_BUTTONS];
+
+    uint8_t _buttonValues[JOYSTICK_BUTTON_COUNT_MAXIMUM / 8];
+    uint8_t _usedButtonBytes = 0;   // bit per button byte
+    uint8_t _dirtyButtonBytes = 0;
+};
+
+// USB side: parses frames from any number of nodes and applies each one to
+// the joystick as a single batched update
+class JoystickLinkDecoder {
+public:
+    explicit JoystickLinkDecoder(Joystick_ &joystick);
+
+    // Feeds received bytes. Returns the number of frames applied.
+    uint8_t feed(uint8_t value);
+
+    uint16_t feed(const uint8_t data[], uint16_t length);
+
+    // Validates and applies a complete frame in place (e.g. from a DMA
+    // buffer). Returns false if it was rejected.
+    bool applyFrame(const uint8_t frame[], uint8_t length);
+
+    inline uint32_t getFrameCount() const {
+        return _frameCount;
+    }
+
+    inline uint32_t getCrcErrorCount() const {
+        return _crcErrorCount;
+    }
+
+    // Frames missing from sequence gaps
+    inline uint32_t getLostFrameCount() const {
+        return _lostFrameCount;
+    }
+
+    // Frames with bad structure, unknown nodes or stale sequence numbers
+    // (other than key frames)
+    inline uint32_t getRejectedFrameCount() const {
+        return _rejectedFrameCount;
+    }
+
+private:
+    Joystick_ &_joystick;
+
+    uint8_t _buffer[JOYSTICK_LINK_FRAME_MAXIMUM];
+    uint8_t _count = 0;
+
+    uint8_t _sequences[JOYSTICK_LINK_NODE_COUNT];
+    uint8_t _knownNodes = 0;   // bit per node with a valid sequence
+
+    uint32_t _frameCount = 0;
+    uint32_t _crcErrorCount = 0;
+    uint32_t _lostFrameCount = 0;
+    uint32_t _rejectedFrameCount = 0;
+
+    // Drops count buffered bytes and everything up to the next sync byte
+    void discard(uint8_t count);
+
+    bool checkEntries(const uint8_t payload[], uint8_t length) const;
+
+    void applyEntries(const uint8_t payload[], uint8_t length);
+};
+
+#endif // JOYSTICK_LINK_H
@@ -0,0 +1,27 @@
+//
+// JoystickMath.h
+//
+
+#ifndef JOYSTICK_MATH_H
+#define JOYSTICK_MATH_H
+
+#include "cstdint"
+
+// Integer square root, rounded down
+uint16_t joystickSqrt(uint32_t value);
+
+// Integer atan2 (CORDIC) as a binary angle, 65536 units per full turn.
+// |x| and |y| must stay below 2^29.
+int16_t joystickAtan2(int32_t y, int32_t x);
+
+// Sine and cosine of a binary angle (65536 units per full turn), scaled to
+// -32767..32767
+int16_t joystickSin(uint16_t angle);
+
+int16_t joystickCos(uint16_t angle);
+
+// CRC-16/CCITT-FALSE (polynomial 0x1021). Pass the previous result as crc to
+// continue over several blocks.
+uint16_t joystickCrc16(const uint8_t data[], uint16_t length, uint16_t crc = 0xFFFF);
+
+#endif // JOYSTICK_MATH_H
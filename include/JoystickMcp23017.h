@@ -0,0 +1,94 @@
+//
+// JoystickMcp23017.h
+//
+
+#ifndef JOYSTICK_MCP23017_H
+#define JOYSTICK_MCP23017_H
+
+#include "Joystick.h"
+#include "JoystickI2cBus.h"
+
+#define JOYSTICK_MCP23017_DEFAULT_ADDRESS 0x20
+#define JOYSTICK_MCP23017_PORT_COUNT      2
+#define JOYSTICK_MCP23017_NO_PIN          0xFF
+
+#define JOYSTICK_MCP23017_PORT_A   0x01
+#define JOYSTICK_MCP23017_PORT_B   0x02
+#define JOYSTICK_MCP23017_PORT_ALL 0x03
+
+// Reads buttons from an MCP23017 I/O expander using its interrupt-on-change
+// outputs instead of polling. The expander runs with IOCON.BANK=1, so the
+// INTF, INTCAP and GPIO registers of a port are adjacent and a changed port
+// costs one burst read of three bytes; unchanged ports are not read at all.
+// Port A is the lower button byte, port B the next one.
+//
+// A change is detected either through the INTA/INTB pins (polled with one
+// digitalRead each) or by calling interrupt() from a pin-change handler.
+// The interrupt outputs are open-drain, so several expanders can share one
+// line. Without interrupt pins every update() reads all ports, unless the
+// expander is interrupt-driven: then only interrupt() causes a read.
+class JoystickMcp23017 {
+public:
+    // firstButton must be a multiple of 8
+    JoystickMcp23017(Joystick_ &joystick, JoystickI2cBus &bus, uint8_t address = JOYSTICK_MCP23017_DEFAULT_ADDRESS,
+                     uint8_t firstButton = 0, uint8_t portCount = JOYSTICK_MCP23017_PORT_COUNT);
+
+    // Buttons are wired to ground using the internal pull-ups, so the
+    // expander inverts the inputs by default (IPOL). Call before begin().
+    void setInverted(bool inverted);
+
+    // INTA and INTB inputs (active low). With only pinA the outputs are
+    // mirrored and a low level reads both ports. Call before begin().
+    void setInterruptPins(uint8_t pinA, uint8_t pinB = JOYSTICK_MCP23017_NO_PIN);
+
+    // Reads ports only when interrupt() asked for it, for a pin-change
+    // handler without interrupt pins. The first interrupt() call switches to
+    // this mode as well.
+    void setInterruptDriven(bool interruptDriven);
+
+    // Configures the expander and reads the initial state. Returns false if
+    // it does not respond.
+    bool begin();
+
+    // Marks ports (JOYSTICK_MCP23017_PORT_*) to be read by the next update().
+    // Safe to call from an interrupt handler.
+    void interrupt(uint8_t ports = JOYSTICK_MCP23017_PORT_ALL);
+
+    // Reads the changed ports and applies them in one button update.
+    // Returns true if a button changed.
+    bool update();
+
+    const uint8_t *getValues() const;
+
+    inline uint32_t getReadCount() const {
+        return _readCount;
+    }
+
+    inline uint32_t getErrorCount() const {
+        return _errorCount;
+    }
+
+private:
+    Joystick_ &_joystick;
+    JoystickI2cBus &_bus;
+    uint8_t _address;
+    uint8_t _firstByte;
+    uint8_t _portCount;
+    bool _inverted = true;
+    uint8_t _interruptPins[JOYSTICK_MCP23017_PORT_COUNT];
+
+    volatile bool _interruptDriven = false;
+
+    // Ports to read on the next update(): requested by interrupt() and
+    // kept for a port whose short pulse still has to be released
+    volatile bool _requested[JOYSTICK_MCP23017_PORT_COUNT];
+    uint8_t _pendingPorts = 0;
+
+    uint8_t _values[JOYSTICK_MCP23017_PORT_COUNT];
+    uint32_t _readCount = 0;
+    uint32_t _errorCount = 0;
+
+    uint8_t getSignalledPorts() const;
+};
+
+#endif // JOYSTICK_MCP23017_H
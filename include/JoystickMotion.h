@@ -0,0 +1,81 @@
+//
+// JoystickMotion.h
+//
+
+#ifndef JOYSTICK_MOTION_H
+#define JOYSTICK_MOTION_H
+
+#include "Joystick.h"
+
+#define JOYSTICK_MOTION_DEFAULT_SAMPLE_RATE     1000
+#define JOYSTICK_MOTION_DEFAULT_GYRO_RANGE      2000
+#define JOYSTICK_MOTION_DEFAULT_FILTER_SHIFT       6
+#define JOYSTICK_MOTION_DEFAULT_OUTPUT_RANGE     180
+
+// Fixed-point complementary filter for raw accelerometer/gyro samples.
+// Roll drives Rx, pitch drives Ry and the integrated yaw drives Rz. Angles
+// are kept as 32-bit binary angles (2^32 per turn) so they wrap for free.
+class JoystickMotion {
+public:
+    explicit JoystickMotion(Joystick_ &joystick);
+
+    // Sample rate of update() calls in Hz
+    void setSampleRate(uint16_t sampleRate);
+
+    // Gyro full-scale range in degrees per second for a 16-bit reading
+    void setGyroRange(uint16_t gyroRange);
+
+    // Accelerometer weight is 2^-filterShift per sample
+    void setFilterShift(uint8_t filterShift);
+
+    // Rotation (+/- degrees) that maps to the ends of the axes
+    void setOutputRange(uint16_t outputRange);
+
+    // Publish the orientation to the joystick every divider samples
+    void setReportDivider(uint8_t reportDivider);
+
+    void setGyroBias(int16_t x, int16_t y, int16_t z);
+
+    // Sets the axis ranges and seeds roll/pitch from the accelerometer
+    void begin(int16_t accelerationX, int16_t accelerationY, int16_t accelerationZ);
+
+    // Feeds one raw sample, returns true if the joystick was updated
+    bool update(int16_t accelerationX, int16_t accelerationY, int16_t accelerationZ,
+                int16_t rotationX, int16_t rotationY, int16_t rotationZ);
+
+    // Binary angles, 65536 units per turn
+    int16_t getRoll() const;
+
+    int16_t getPitch() const;
+
+    int16_t getYaw() const;
+
+    void resetYaw();
+
+private:
+    Joystick_ &_joystick;
+
+    uint16_t _sampleRate = JOYSTICK_MOTION_DEFAULT_SAMPLE_RATE;
+    uint16_t _gyroRange = JOYSTICK_MOTION_DEFAULT_GYRO_RANGE;
+    uint8_t _filterShift = JOYSTICK_MOTION_DEFAULT_FILTER_SHIFT;
+    uint16_t _outputRange = JOYSTICK_MOTION_DEFAULT_OUTPUT_RANGE;
+    uint8_t _reportDivider = 1;
+    uint8_t _sampleCount = 0;
+
+    // Gyro count to angle step: (count * _gyroFactor) >> _gyroShift
+    int32_t _gyroFactor = 0;
+    uint8_t _gyroShift = 0;
+    int16_t _gyroBias[3] = {0, 0, 0};
+
+    uint32_t _roll = 0;
+    uint32_t _pitch = 0;
+    uint32_t _yaw = 0;
+
+    void updateGyroFactor();
+
+    static uint32_t accelerationRoll(int16_t accelerationY, int16_t accelerationZ);
+
+    static uint32_t accelerationPitch(int16_t accelerationX, int16_t accelerationY, int16_t accelerationZ);
+};
+
+#endif // JOYSTICK_MOTION_H
@@ -0,0 +1,95 @@
+//
+// JoystickProfiler.h
+//
+
+#ifndef JOYSTICK_PROFILER_H
+#define JOYSTICK_PROFILER_H
+
+#include "cstdint"
+
+// Pipeline stages timed by the profiler
+enum JoystickProfileStage : uint8_t {
+    JOYSTICK_STAGE_SCAN = 0,   // reading buttons and analog inputs
+    JOYSTICK_STAGE_FILTER,     // filtering / fusion of raw samples
+    JOYSTICK_STAGE_ENCODE,     // building the report in sendState()
+    JOYSTICK_STAGE_SEND,       // HID().SendReport
+    JOYSTICK_STAGE_COUNT
+};
+
+// The profiler only exists if JOYSTICK_ENABLE_PROFILER is defined for the
+// whole build; otherwise the JOYSTICK_PROFILE_* macros expand to nothing.
+#if defined(JOYSTICK_ENABLE_PROFILER)
+
+#include "Arduino.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif !defined(ARDUINO)
+#include <chrono>
+#endif
+
+// Cheapest clock available: CPU cycles on ESP and Cortex-M3/M4/M7 (DWT),
+// micros() on other boards, the TSC (x86) or steady_clock nanoseconds on the
+// host.
+inline uint32_t joystickProfilerTicks() {
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
+    return ESP.getCycleCount();
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+    return *(volatile uint32_t *) 0xE0001004; // DWT_CYCCNT
+#elif defined(__x86_64__) || defined(__i386__)
+    return (uint32_t) __rdtsc();
+#elif defined(ARDUINO)
+    return micros();
+#else
+    return (uint32_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+struct JoystickProfileStats {
+    uint32_t count;
+    uint32_t minimum;
+    uint32_t maximum;
+    uint64_t total;
+
+    inline uint32_t average() const {
+        return (count > 0) ? (uint32_t) (total / count) : 0;
+    }
+};
+
+class JoystickProfiler {
+public:
+    // Starts the cycle counter where it has to be enabled (Cortex-M)
+    static void begin();
+
+    static void record(JoystickProfileStage stage, uint32_t ticks);
+
+    static const JoystickProfileStats &getStats(JoystickProfileStage stage);
+
+    static void reset();
+
+    // One line per stage: name, count, min, avg, max and unit
+    static void dump(Print &output);
+
+    static const char *getStageName(JoystickProfileStage stage);
+
+    // "cycles", "us" or "ns"
+    static const char *getUnit();
+
+private:
+    static JoystickProfileStats _stats[JOYSTICK_STAGE_COUNT];
+};
+
+#define JOYSTICK_PROFILE_BEGIN(stage) \
+    uint32_t _joystickProfileStart_##stage = joystickProfilerTicks()
+#define JOYSTICK_PROFILE_END(stage) \
+    JoystickProfiler::record(stage, joystickProfilerTicks() - _joystickProfileStart_##stage)
+
+#else
+
+#define JOYSTICK_PROFILE_BEGIN(stage) do {} while (0)
+#define JOYSTICK_PROFILE_END(stage) do {} while (0)
+
+#endif // JOYSTICK_ENABLE_PROFILER
+
+#endif // JOYSTICK_PROFILER_H
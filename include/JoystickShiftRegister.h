@@ -0,0 +1,44 @@
+//
+// JoystickShiftRegister.h
+//
+
+#ifndef JOYSTICK_SHIFT_REGISTER_H
+#define JOYSTICK_SHIFT_REGISTER_H
+
+#include "Joystick.h"
+#include "JoystickSpiBus.h"
+
+#define JOYSTICK_SHIFT_REGISTER_MAXIMUM (JOYSTICK_BUTTON_COUNT_MAXIMUM / 8)
+
+// Reads a daisy-chained 74HC165 chain in one SPI burst and writes the bytes
+// straight into the joystick's button bitmap. Input A of a register is the
+// lowest button of its byte.
+class JoystickShiftRegister {
+public:
+    // firstButton must be a multiple of 8
+    JoystickShiftRegister(Joystick_ &joystick, JoystickSpiBus &bus, uint8_t registerCount, uint8_t firstButton = 0);
+
+    // Buttons wired active-low (pull-ups) read as pressed when low
+    void setInverted(bool inverted);
+
+    // The first byte clocked out comes from the register closest to MISO.
+    // Reverse the order if that register holds the lowest buttons.
+    void setReverseOrder(bool reverseOrder);
+
+    // Latches, reads and applies the chain. Returns true if a button changed.
+    bool update();
+
+    const uint8_t *getValues() const;
+
+private:
+    Joystick_ &_joystick;
+    JoystickSpiBus &_bus;
+    uint8_t _registerCount;
+    uint8_t _firstByte;
+    bool _inverted = false;
+    bool _reverseOrder = false;
+    bool _valid = false;
+    uint8_t _values[JOYSTICK_SHIFT_REGISTER_MAXIMUM];
+};
+
+#endif // JOYSTICK_SHIFT_REGISTER_H
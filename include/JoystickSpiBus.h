@@ -0,0 +1,29 @@
+//
+// JoystickSpiBus.h
+//
+
+#ifndef JOYSTICK_SPI_BUS_H
+#define JOYSTICK_SPI_BUS_H
+
+#include "cstdint"
+
+// Minimal SPI interface used by the input drivers, so they can run against
+// a simulated bus on the host.
+class JoystickSpiBus {
+public:
+    virtual ~JoystickSpiBus() = default;
+
+    // Claims the bus and sets its clock mode. Called before latch() so that
+    // switching the clock polarity cannot shift the freshly latched inputs.
+    virtual void beginTransaction() {}
+
+    virtual void endTransaction() {}
+
+    // Pulses the parallel-load line so the registers latch their inputs
+    virtual void latch() = 0;
+
+    // Clocks length bytes in from the chain in one burst
+    virtual void read(uint8_t buffer[], uint8_t length) = 0;
+};
+
+#endif // JOYSTICK_SPI_BUS_H
@@ -0,0 +1,252 @@
+//
+// JoystickStatic.h
+//
+
+#ifndef JOYSTICK_STATIC_H
+#define JOYSTICK_STATIC_H
+
+#include "Joystick.h"
+#include "JoystickBuilder.h"
+
+// Default layout of a JoystickStatic. Derive from it and override the members
+// that differ; everything must be a compile-time constant. Every axis and
+// simulator control has its own range, like the set*Range() functions of
+// Joystick_.
+struct JoystickStaticConfig {
+    static constexpr uint8_t reportId = JOYSTICK_DEFAULT_REPORT_ID;
+    static constexpr uint8_t joystickType = JOYSTICK_TYPE_JOYSTICK;
+    static constexpr uint8_t buttonCount = JOYSTICK_DEFAULT_BUTTON_COUNT;
+    static constexpr uint8_t hatSwitchCount = JOYSTICK_DEFAULT_HATSWITCH_COUNT;
+    static constexpr uint8_t axisFlags = JOYSTICK_INCLUDE_X_AXIS | JOYSTICK_INCLUDE_Y_AXIS | JOYSTICK_INCLUDE_Z_AXIS |
+                                         JOYSTICK_INCLUDE_RX_AXIS | JOYSTICK_INCLUDE_RY_AXIS | JOYSTICK_INCLUDE_RZ_AXIS;
+    static constexpr uint8_t simulatorFlags = JOYSTICK_INCLUDE_RUDDER | JOYSTICK_INCLUDE_THROTTLE |
+                                              JOYSTICK_INCLUDE_ACCELERATOR | JOYSTICK_INCLUDE_BRAKE |
+                                              JOYSTICK_INCLUDE_STEERING;
+
+    static constexpr int32_t xAxisMinimum = JOYSTICK_DEFAULT_AXIS_MINIMUM;
+    static constexpr int32_t xAxisMaximum = JOYSTICK_DEFAULT_AXIS_MAXIMUM;
+    static constexpr int32_t yAxisMinimum = JOYSTICK_DEFAULT_AXIS_MINIMUM;
+    static constexpr int32_t yAxisMaximum = JOYSTICK_DEFAULT_AXIS_MAXIMUM;
+    static constexpr int32_t zAxisMinimum = JOYSTICK_DEFAULT_AXIS_MINIMUM;
+    static constexpr int32_t zAxisMaximum = JOYSTICK_DEFAULT_AXIS_MAXIMUM;
+    static constexpr int32_t rxAxisMinimum = JOYSTICK_DEFAULT_AXIS_MINIMUM;
+    static constexpr int32_t rxAxisMaximum = JOYSTICK_DEFAULT_AXIS_MAXIMUM;
+    static constexpr int32_t ryAxisMinimum = JOYSTICK_DEFAULT_AXIS_MINIMUM;
+    static constexpr int32_t ryAxisMaximum = JOYSTICK_DEFAULT_AXIS_MAXIMUM;
+    static constexpr int32_t rzAxisMinimum = JOYSTICK_DEFAULT_AXIS_MINIMUM;
+    static constexpr int32_t rzAxisMaximum = JOYSTICK_DEFAULT_AXIS_MAXIMUM;
+
+    static constexpr int32_t rudderMinimum = JOYSTICK_DEFAULT_SIMULATOR_MINIMUM;
+    static constexpr int32_t rudderMaximum = JOYSTICK_DEFAULT_SIMULATOR_MAXIMUM;
+    static constexpr int32_t throttleMinimum = JOYSTICK_DEFAULT_SIMULATOR_MINIMUM;
+    static constexpr int32_t throttleMaximum = JOYSTICK_DEFAULT_SIMULATOR_MAXIMUM;
+    static constexpr int32_t acceleratorMinimum = JOYSTICK_DEFAULT_SIMULATOR_MINIMUM;
+    static constexpr int32_t acceleratorMaximum = JOYSTICK_DEFAULT_SIMULATOR_MAXIMUM;
+    static constexpr int32_t brakeMinimum = JOYSTICK_DEFAULT_SIMULATOR_MINIMUM;
+    static constexpr int32_t brakeMaximum = JOYSTICK_DEFAULT_SIMULATOR_MAXIMUM;
+    static constexpr int32_t steeringMinimum = JOYSTICK_DEFAULT_SIMULATOR_MINIMUM;
+    static constexpr int32_t steeringMaximum = JOYSTICK_DEFAULT_SIMULATOR_MAXIMUM;
+};
+
+// Joystick whose layout is fixed at compile time. Field offsets and ranges
+// are constants, setters encode straight into the report at their offset and
+// sendState() only hands the finished report to the HID core. Setting a
+// field that is not part of the configuration fails to compile.
+//
+// The descriptor comes from JoystickBuilder, so the report layout is the
+// one of Joystick_: every axis and simulator control is 16 bits wide.
+template<class Config>
+class JoystickStatic {
+public:
+    static constexpr uint8_t buttonBytes = (Config::buttonCount + 7) / 8;
+    static constexpr uint8_t hatSwitchOffset = buttonBytes;
+    static constexpr uint8_t axisOffset = buttonBytes + ((Config::hatSwitchCount > 0) ? 1 : 0);
+    static constexpr uint8_t simulatorOffset = axisOffset + 2 * joystickBitCount(Config::axisFlags);
+    static constexpr uint8_t reportSize = joystickReportSize(Config::buttonCount, Config::hatSwitchCount,
+                                                             joystickBitCount(Config::axisFlags),
+                                                             joystickBitCount(Config::simulatorFlags));
+
+    static_assert(Config::buttonCount <= JOYSTICK_BUTTON_COUNT_MAXIMUM, "Unable to use more than 64 buttons");
+    static_assert(Config::hatSwitchCount <= JOYSTICK_HATSWITCH_COUNT_MAXIMUM, "Unable to use more than 2 hat switches");
+    static_assert(reportSize == simulatorOffset + 2 * joystickBitCount(Config::simulatorFlags),
+                  "Field offsets do not match the report layout");
+    static_assert(reportSize <= JOYSTICK_REPORT_SIZE_MAXIMUM, "Report exceeds JOYSTICK_REPORT_SIZE_MAXIMUM");
+
+    static constexpr uint8_t descriptorSize = joystickDescriptorSize(Config::buttonCount, Config::hatSwitchCount,
+                                                                     Config::axisFlags, 0,
+                                                                     joystickBitCount(Config::simulatorFlags));
+
+    JoystickStatic() : _hidSubDescriptor(_hidReportDescriptor, buildDescriptor(_hidReportDescriptor)) {
+        for (uint8_t index = 0; index < sizeof(_hidReport); index++) {
+            _hidReport[index] = 0;
+        }
+        if (Config::hatSwitchCount > 0) {
+            // Both hat switches released
+            _hidReport[hatSwitchOffset] = 0x88;
+        }
+
+        HID().AppendDescriptor(&_hidSubDescriptor);
+    }
+
+    void begin(bool initAutoSendState = true) {
+        _autoSendState = initAutoSendState;
+        sendState();
+    }
+
+    void end() {
+    }
+
+    // Set Axis Values
+    inline void setXAxis(int32_t value) {
+        setAxis<JOYSTICK_INCLUDE_X_AXIS, Config::xAxisMinimum, Config::xAxisMaximum>(value);
+    }
+
+    inline void setYAxis(int32_t value) {
+        setAxis<JOYSTICK_INCLUDE_Y_AXIS, Config::yAxisMinimum, Config::yAxisMaximum>(value);
+    }
+
+    inline void setZAxis(int32_t value) {
+        setAxis<JOYSTICK_INCLUDE_Z_AXIS, Config::zAxisMinimum, Config::zAxisMaximum>(value);
+    }
+
+    inline void setRxAxis(int32_t value) {
+        setAxis<JOYSTICK_INCLUDE_RX_AXIS, Config::rxAxisMinimum, Config::rxAxisMaximum>(value);
+    }
+
+    inline void setRyAxis(int32_t value) {
+        setAxis<JOYSTICK_INCLUDE_RY_AXIS, Config::ryAxisMinimum, Config::ryAxisMaximum>(value);
+    }
+
+    inline void setRzAxis(int32_t value) {
+        setAxis<JOYSTICK_INCLUDE_RZ_AXIS, Config::rzAxisMinimum, Config::rzAxisMaximum>(value);
+    }
+
+    // Set Simulation Values
+    inline void setRudder(int32_t value) {
+        setSimulator<JOYSTICK_INCLUDE_RUDDER, Config::rudderMinimum, Config::rudderMaximum>(value);
+    }
+
+    inline void setThrottle(int32_t value) {
+        setSimulator<JOYSTICK_INCLUDE_THROTTLE, Config::throttleMinimum, Config::throttleMaximum>(value);
+    }
+
+    inline void setAccelerator(int32_t value) {
+        setSimulator<JOYSTICK_INCLUDE_ACCELERATOR, Config::acceleratorMinimum, Config::acceleratorMaximum>(value);
+    }
+
+    inline void setBrake(int32_t value) {
+        setSimulator<JOYSTICK_INCLUDE_BRAKE, Config::brakeMinimum, Config::brakeMaximum>(value);
+    }
+
+    inline void setSteering(int32_t value) {
+        setSimulator<JOYSTICK_INCLUDE_STEERING, Config::steeringMinimum, Config::steeringMaximum>(value);
+    }
+
+    inline void setButton(uint8_t button, uint8_t value) {
+        if (value == 0) {
+            releaseButton(button);
+        } else {
+            pressButton(button);
+        }
+    }
+
+    inline void pressButton(uint8_t button) {
+        if (button >= Config::buttonCount) return;
+
+        bitSet(_hidReport[button / 8], button % 8);
+        stateChanged();
+    }
+
+    inline void releaseButton(uint8_t button) {
+        if (button >= Config::buttonCount) return;
+
+        bitClear(_hidReport[button / 8], button % 8);
+        stateChanged();
+    }
+
+    void setHatSwitch(int8_t hatSwitchIndex, int16_t value) {
+        if ((hatSwitchIndex < 0) || (hatSwitchIndex >= Config::hatSwitchCount)) return;
+
+        uint8_t convertedValue = (value < 0) ? 8 : (uint8_t) ((value % 360) / 45);
+        uint8_t shift = hatSwitchIndex * 4;
+        _hidReport[hatSwitchOffset] = (uint8_t) ((_hidReport[hatSwitchOffset] & ~(0x0F << shift)) |
+                                                 (convertedValue << shift));
+        stateChanged();
+    }
+
+    inline void sendState() {
+        HID().SendReport(Config::reportId, _hidReport, reportSize);
+    }
+
+    inline const uint8_t *getReport() const {
+        return _hidReport;
+    }
+
+private:
+    bool _autoSendState = false;
+    uint8_t _hidReport[(reportSize > 0) ? reportSize : 1];
+    uint8_t _hidReportDescriptor[descriptorSize];
+    HIDSubDescriptor _hidSubDescriptor;
+
+    static uint16_t buildDescriptor(uint8_t buffer[]) {
+        JoystickBuilder builder(Config::reportId, Config::joystickType);
+        builder.setButtonCount(Config::buttonCount)
+                .setHatSwitchCount(Config::hatSwitchCount)
+                .includeAxes(Config::axisFlags)
+                .includeSimulatorControls(Config::simulatorFlags);
+        return builder.buildDescriptor(buffer);
+    }
+
+    inline void stateChanged() {
+        if (_autoSendState) sendState();
+    }
+
+    template<int32_t Minimum, int32_t Maximum>
+    static inline uint16_t scale(int32_t value) {
+        // Folded at compile time: the range is fixed, only the clamp and one
+        // multiply/divide by constants remain.
+        constexpr int32_t realMinimum = (Minimum < Maximum) ? Minimum : Maximum;
+        constexpr int32_t realMaximum = (Minimum < Maximum) ? Maximum : Minimum;
+        constexpr uint32_t span = (uint32_t) (realMaximum - realMinimum);
+
+        if (value < realMinimum) value = realMinimum;
+        if (value > realMaximum) value = realMaximum;
+
+        if (Minimum > Maximum) {
+            // Values go from a larger number to a smaller number (e.g. 1024 to 0)
+            value = realMaximum - value + realMinimum;
+        }
+
+        uint32_t offset = (uint32_t) (value - realMinimum);
+        if (span <= 0xFFFF) {
+            return (uint16_t) ((offset * 65535UL) / span);
+        }
+        return (uint16_t) (((uint64_t) offset * 65535UL) / span);
+    }
+
+    inline void store(uint8_t offset, uint16_t value) {
+        _hidReport[offset] = (uint8_t) (value & 0x00FF);
+        _hidReport[offset + 1] = (uint8_t) (value >> 8);
+    }
+
+    template<uint8_t Flag, int32_t Minimum, int32_t Maximum>
+    inline void setAxis(int32_t value) {
+        static_assert((Config::axisFlags & Flag) != 0, "Axis is not part of the joystick configuration");
+        static_assert(Minimum != Maximum, "Axis range must not be empty");
+
+        store(axisOffset + 2 * joystickBitCount(Config::axisFlags & (Flag - 1)), scale<Minimum, Maximum>(value));
+        stateChanged();
+    }
+
+    template<uint8_t Flag, int32_t Minimum, int32_t Maximum>
+    inline void setSimulator(int32_t value) {
+        static_assert((Config::simulatorFlags & Flag) != 0, "Simulator control is not part of the joystick configuration");
+        static_assert(Minimum != Maximum, "Simulator range must not be empty");
+
+        store(simulatorOffset + 2 * joystickBitCount(Config::simulatorFlags & (Flag - 1)),
+              scale<Minimum, Maximum>(value));
+        stateChanged();
+    }
+};
+
+#endif // JOYSTICK_STATIC_H
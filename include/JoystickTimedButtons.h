@@ -0,0 +1,96 @@
+//
+// JoystickTimedButtons.h
+//
+
+#ifndef JOYSTICK_TIMED_BUTTONS_H
+#define JOYSTICK_TIMED_BUTTONS_H
+
+#include "Joystick.h"
+#include "JoystickClock.h"
+
+// Number of simultaneously active timed actions (at most 255)
+#ifndef JOYSTICK_TIMER_COUNT
+#define JOYSTICK_TIMER_COUNT 32
+#endif
+
+// Number of wheel slots, must be a power of two
+#ifndef JOYSTICK_TIMER_WHEEL_SIZE
+#define JOYSTICK_TIMER_WHEEL_SIZE 64
+#endif
+
+#define JOYSTICK_TIMER_DEFAULT_TICK 1000
+
+// Timed button actions (autofire, pulses, delayed holds) on a hashed timer
+// wheel. Each tick only visits the timers hashed into its slot, so the cost
+// does not grow with the number of active timers. All expirations of an
+// update() are applied as one batched button update.
+class JoystickTimedButtons {
+public:
+    JoystickTimedButtons(Joystick_ &joystick, uint32_t tickLength = JOYSTICK_TIMER_DEFAULT_TICK,
+                         JoystickClock clock = joystickDefaultClock);
+
+    // Toggles the button at the given rate until cancelled
+    bool startAutofire(uint8_t button, uint16_t frequency);
+
+    // Presses the button now and releases it after duration microseconds
+    bool pulse(uint8_t button, uint32_t duration);
+
+    // Presses the button after delay microseconds and releases it after
+    // duration microseconds (0 holds it until cancelled)
+    bool holdAfter(uint8_t button, uint32_t delay, uint32_t duration = 0);
+
+    // Stops any action on the button and releases it
+    void cancel(uint8_t button);
+
+    bool isActive(uint8_t button) const;
+
+    uint8_t getActiveCount() const;
+
+    // Call from loop(). Returns the number of expired timers.
+    uint16_t update();
+
+private:
+    enum Action : uint8_t {
+        ACTION_AUTOFIRE,
+        ACTION_PRESS,
+        ACTION_RELEASE
+    };
+
+    struct Timer {
+        uint8_t next;
+        uint8_t previous;
+        uint8_t slot;
+        uint8_t button;
+        Action action;
+        bool pressed;
+        uint16_t rounds;
+        uint32_t period;
+        uint32_t duration;
+    };
+
+    Joystick_ &_joystick;
+    JoystickClock _clock;
+    uint32_t _tickLength;
+    uint32_t _lastTickTime;
+    uint32_t _currentTick = 0;
+
+    Timer _timers[JOYSTICK_TIMER_COUNT];
+    uint8_t _slots[JOYSTICK_TIMER_WHEEL_SIZE];
+    uint8_t _buttonTimers[JOYSTICK_BUTTON_COUNT_MAXIMUM];
+    uint8_t _freeList;
+    uint8_t _activeCount = 0;
+
+    uint8_t allocate(uint8_t button);
+
+    void release(uint8_t timer);
+
+    void schedule(uint8_t timer, uint32_t ticks);
+
+    void unlink(uint8_t timer);
+
+    uint32_t toTicks(uint32_t duration) const;
+
+    uint16_t processSlot(uint8_t slot);
+};
+
+#endif // JOYSTICK_TIMED_BUTTONS_H
@@ -0,0 +1,59 @@
+//
+// JoystickTrace.h
+//
+
+#ifndef JOYSTICK_TRACE_H
+#define JOYSTICK_TRACE_H
+
+#include "Joystick.h"
+#include "JoystickClock.h"
+
+// Number of recorded reports
+#ifndef JOYSTICK_TRACE_SIZE
+#define JOYSTICK_TRACE_SIZE 32
+#endif
+
+#define JOYSTICK_TRACE_VERSION 1
+
+static_assert(JOYSTICK_TRACE_SIZE <= 255, "JOYSTICK_TRACE_SIZE must not exceed 255");
+
+struct JoystickTraceEntry {
+    uint16_t interval;   // microseconds since the previous entry (saturating)
+    uint8_t reportId;
+    uint8_t length;
+    uint8_t data[JOYSTICK_REPORT_SIZE_MAXIMUM];
+};
+
+// Records the last JOYSTICK_TRACE_SIZE transmitted reports in a fixed ring.
+// Recording is a bounded copy without allocation, so it can stay enabled on
+// the hot path. dump() writes the ring together with the HID descriptor;
+// extras/trace_decode.py turns the blob back into field values.
+class JoystickTrace {
+public:
+    explicit JoystickTrace(JoystickClock clock = joystickDefaultClock);
+
+    void record(uint8_t reportId, const uint8_t data[], uint8_t length);
+
+    void clear();
+
+    uint8_t getCount() const;
+
+    // Oldest entry first
+    const JoystickTraceEntry &getEntry(uint8_t index) const;
+
+    // Binary dump: "JTRC", version, descriptor size and bytes, entry count,
+    // then per entry interval, report ID, length and report bytes (all
+    // multi-byte values little endian).
+    void dump(Print &output, const Joystick_ &joystick) const;
+
+private:
+    JoystickClock _clock;
+    JoystickTraceEntry _entries[JOYSTICK_TRACE_SIZE];
+    uint8_t _next = 0;
+    uint8_t _count = 0;
+    uint32_t _lastTime = 0;
+
+    static void writeUInt16(Print &output, uint16_t value);
+};
+
+#endif // JOYSTICK_TRACE_H
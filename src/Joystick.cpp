@@ -20,6 +20,10 @@
 
 #include "Joystick.h"
 #include "JoystickBuilder.h"
+#include "JoystickConfig.h"
+#include "JoystickMath.h"
+#include "JoystickProfiler.h"
+#include "JoystickTrace.h"
 
 
 #define JOYSTICK_REPORT_ID_INDEX 7
@@ -28,23 +32,19 @@
 #define JOYSTICK_SIMULATOR_MINIMUM 0
 #define JOYSTICK_SIMULATOR_MAXIMUM 65535
 
-#define JOYSTICK_INCLUDE_X_AXIS  B00000001
-#define JOYSTICK_INCLUDE_Y_AXIS  B00000010
-#define JOYSTICK_INCLUDE_Z_AXIS  B00000100
-#define JOYSTICK_INCLUDE_RX_AXIS B00001000
-#define JOYSTICK_INCLUDE_RY_AXIS B00010000
-#define JOYSTICK_INCLUDE_RZ_AXIS B00100000
 
-#define JOYSTICK_INCLUDE_RUDDER      B00000001
-#define JOYSTICK_INCLUDE_THROTTLE    B00000010
-#define JOYSTICK_INCLUDE_ACCELERATOR B00000100
-#define JOYSTICK_INCLUDE_BRAKE       B00001000
-#define JOYSTICK_INCLUDE_STEERING    B00010000
-
-
-static uint8_t tempHidReportDescriptor[150];
-
-Joystick_::Joystick_(JoystickBuilder &builder) : _hidSubDescriptor(_hidReportDescriptor, builder.getHidSize()) {
+#if defined(ARDUINO_ARCH_AVR)
+static void defaultWakeup() {
+    USBDevice.wakeupHost();
+}
+#define JOYSTICK_DEFAULT_WAKEUP defaultWakeup
+#else
+#define JOYSTICK_DEFAULT_WAKEUP nullptr
+#endif
+
+Joystick_::Joystick_(JoystickBuilder &builder)
+        : _wakeupCallback(JOYSTICK_DEFAULT_WAKEUP),
+          _hidSubDescriptor(_hidReportDescriptor, builder.buildDescriptor(_hidReportDescriptor)) {
     // Set the USB HID Report ID
     _hidReportId = builder.getReportId();
 
@@ -52,15 +52,15 @@ Joystick_::Joystick_(JoystickBuilder &builder) : _hidSubDescriptor(_hidReportDes
     _buttonCount = builder.getButtonCount();
     _hatSwitchCount = builder.getSwitchCount();
     _includeAxisFlags = builder.getAxisFlags();
+    _relativeAxisFlags = builder.getRelativeAxisFlags();
     _includeSimulatorFlags = builder.getSimulatorFlags();
 
-    builder.buildDescriptor(_hidReportDescriptor);
     HID().AppendDescriptor(&_hidSubDescriptor);
 
     // Setup Joystick State
-    if (_buttonCount > 64) {
+    if (_buttonCount > JOYSTICK_BUTTON_COUNT_MAXIMUM) {
         Serial.println("Unable to use more than 64 buttons");
-        _buttonCount = 64;
+        _buttonCount = JOYSTICK_BUTTON_COUNT_MAXIMUM;
     }
 
     if (_buttonCount > 0) {
@@ -71,10 +71,7 @@ Joystick_::Joystick_(JoystickBuilder &builder) : _hidSubDescriptor(_hidReportDes
     }
 
     // Calculate HID Report Size
-    _hidReportSize = _buttonValuesArraySize;
-    _hidReportSize += (_hatSwitchCount > 0);
-    _hidReportSize += (builder.getAxisCount() * 2);
-    _hidReportSize += (builder.getSimulatorCount() * 2);
+    _hidReportSize = builder.getReportSize();
 
     // Initialize Joystick State
     _xAxis = 0;
@@ -88,6 +85,9 @@ Joystick_::Joystick_(JoystickBuilder &builder) : _hidSubDescriptor(_hidReportDes
     _accelerator = 0;
     _brake = 0;
     _steering = 0;
+    for (JoystickRadialSettings &radialSettings: _radialSettings) {
+        radialSettings = {false, false, 0, JOYSTICK_RADIAL_MAXIMUM};
+    }
     for (short &_hatSwitchValue: _hatSwitchValues) {
         _hatSwitchValue = JOYSTICK_HATSWITCH_RELEASE;
     }
@@ -104,6 +104,62 @@ void Joystick_::begin(bool initAutoSendState) {
 void Joystick_::end() {
 }
 
+void Joystick_::applyConfig(const JoystickConfig &config) {
+    const JoystickRange *ranges = config.ranges;
+
+    setXAxisRange(ranges[JOYSTICK_FIELD_X_AXIS].minimum, ranges[JOYSTICK_FIELD_X_AXIS].maximum);
+    setYAxisRange(ranges[JOYSTICK_FIELD_Y_AXIS].minimum, ranges[JOYSTICK_FIELD_Y_AXIS].maximum);
+    setZAxisRange(ranges[JOYSTICK_FIELD_Z_AXIS].minimum, ranges[JOYSTICK_FIELD_Z_AXIS].maximum);
+    setRxAxisRange(ranges[JOYSTICK_FIELD_RX_AXIS].minimum, ranges[JOYSTICK_FIELD_RX_AXIS].maximum);
+    setRyAxisRange(ranges[JOYSTICK_FIELD_RY_AXIS].minimum, ranges[JOYSTICK_FIELD_RY_AXIS].maximum);
+    setRzAxisRange(ranges[JOYSTICK_FIELD_RZ_AXIS].minimum, ranges[JOYSTICK_FIELD_RZ_AXIS].maximum);
+    setRudderRange(ranges[JOYSTICK_FIELD_RUDDER].minimum, ranges[JOYSTICK_FIELD_RUDDER].maximum);
+    setThrottleRange(ranges[JOYSTICK_FIELD_THROTTLE].minimum, ranges[JOYSTICK_FIELD_THROTTLE].maximum);
+    setAcceleratorRange(ranges[JOYSTICK_FIELD_ACCELERATOR].minimum, ranges[JOYSTICK_FIELD_ACCELERATOR].maximum);
+    setBrakeRange(ranges[JOYSTICK_FIELD_BRAKE].minimum, ranges[JOYSTICK_FIELD_BRAKE].maximum);
+    setSteeringRange(ranges[JOYSTICK_FIELD_STEERING].minimum, ranges[JOYSTICK_FIELD_STEERING].maximum);
+
+    for (uint8_t pair = 0; pair < JOYSTICK_AXIS_PAIR_COUNT; pair++) {
+        _radialSettings[pair] = config.radialSettings[pair];
+    }
+}
+
+void Joystick_::captureConfig(JoystickConfig &config) const {
+    JoystickRange *ranges = config.ranges;
+
+    ranges[JOYSTICK_FIELD_X_AXIS] = {_xAxisMinimum, _xAxisMaximum};
+    ranges[JOYSTICK_FIELD_Y_AXIS] = {_yAxisMinimum, _yAxisMaximum};
+    ranges[JOYSTICK_FIELD_Z_AXIS] = {_zAxisMinimum, _zAxisMaximum};
+    ranges[JOYSTICK_FIELD_RX_AXIS] = {_rxAxisMinimum, _rxAxisMaximum};
+    ranges[JOYSTICK_FIELD_RY_AXIS] = {_ryAxisMinimum, _ryAxisMaximum};
+    ranges[JOYSTICK_FIELD_RZ_AXIS] = {_rzAxisMinimum, _rzAxisMaximum};
+    ranges[JOYSTICK_FIELD_RUDDER] = {_rudderMinimum, _rudderMaximum};
+    ranges[JOYSTICK_FIELD_THROTTLE] = {_throttleMinimum, _throttleMaximum};
+    ranges[JOYSTICK_FIELD_ACCELERATOR] = {_acceleratorMinimum, _acceleratorMaximum};
+    ranges[JOYSTICK_FIELD_BRAKE] = {_brakeMinimum, _brakeMaximum};
+    ranges[JOYSTICK_FIELD_STEERING] = {_steeringMinimum, _steeringMaximum};
+
+    for (uint8_t pair = 0; pair < JOYSTICK_AXIS_PAIR_COUNT; pair++) {
+        config.radialSettings[pair] = _radialSettings[pair];
+    }
+}
+
+void Joystick_::setRadialDeadzone(JoystickAxisPair pair, uint16_t deadzone, uint16_t saturation,
+                                  bool squareToCircle) {
+    if (pair >= JOYSTICK_AXIS_PAIR_COUNT) return;
+
+    if (saturation > JOYSTICK_RADIAL_MAXIMUM) saturation = JOYSTICK_RADIAL_MAXIMUM;
+    if (deadzone >= saturation) deadzone = saturation - 1;
+
+    _radialSettings[pair] = {true, squareToCircle, deadzone, saturation};
+}
+
+void Joystick_::clearRadialDeadzone(JoystickAxisPair pair) {
+    if (pair >= JOYSTICK_AXIS_PAIR_COUNT) return;
+
+    _radialSettings[pair].enabled = false;
+}
+
 void Joystick_::setButton(uint8_t button, uint8_t value) {
     if (value == 0) {
         releaseButton(button);
@@ -118,8 +174,10 @@ void Joystick_::pressButton(uint8_t button) {
     int index = button / 8;
     int bit = button % 8;
 
+    uint8_t previous = _buttonValues[index];
     bitSet(_buttonValues[index], bit);
-    if (_autoSendState) sendState();
+    if (_buttonValues[index] != previous) _pendingFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_BUTTONS);
+    stateChanged();
 }
 
 void Joystick_::releaseButton(uint8_t button) {
@@ -128,70 +186,369 @@ void Joystick_::releaseButton(uint8_t button) {
     int index = button / 8;
     int bit = button % 8;
 
+    uint8_t previous = _buttonValues[index];
     bitClear(_buttonValues[index], bit);
-    if (_autoSendState) sendState();
+    if (_buttonValues[index] != previous) _pendingFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_BUTTONS);
+    stateChanged();
+}
+
+void Joystick_::setButtonBytes(uint8_t firstByte, const uint8_t values[], uint8_t count) {
+    bool changed = false;
+
+    for (uint8_t offset = 0; offset < count; offset++) {
+        uint8_t index = firstByte + offset;
+        if (index >= _buttonValuesArraySize) break;
+
+        uint8_t value = values[offset];
+        if ((index == _buttonValuesArraySize - 1) && ((_buttonCount % 8) > 0)) {
+            // Keep the padding bits of the last byte cleared
+            value &= (uint8_t) ((1 << (_buttonCount % 8)) - 1);
+        }
+
+        if (_buttonValues[index] != value) {
+            _buttonValues[index] = value;
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        _pendingFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_BUTTONS);
+        stateChanged();
+    }
+}
+
+int32_t &Joystick_::axisValue(uint8_t axis) {
+    switch (axis) {
+        case JOYSTICK_FIELD_X_AXIS:
+            return _xAxis;
+        case JOYSTICK_FIELD_Y_AXIS:
+            return _yAxis;
+        case JOYSTICK_FIELD_Z_AXIS:
+            return _zAxis;
+        case JOYSTICK_FIELD_RX_AXIS:
+            return _xAxisRotation;
+        case JOYSTICK_FIELD_RY_AXIS:
+            return _yAxisRotation;
+        default:
+            return _zAxisRotation;
+    }
+}
+
+void Joystick_::moveAxis(JoystickField axis, int32_t delta) {
+    if (axis > JOYSTICK_FIELD_RZ_AXIS) return;
+    if (delta == 0) return;
+
+    int32_t &value = axisValue(axis);
+    if ((delta > 0) && (value > INT32_MAX - delta)) {
+        value = INT32_MAX;
+    } else if ((delta < 0) && (value < INT32_MIN - delta)) {
+        value = INT32_MIN;
+    } else {
+        value += delta;
+    }
+
+    _pendingFields |= JOYSTICK_FIELD_MASK(axis);
+    stateChanged();
+}
+
+void Joystick_::consumeRelativeValues() {
+    for (uint8_t axis = JOYSTICK_FIELD_X_AXIS; axis <= JOYSTICK_FIELD_RZ_AXIS; axis++) {
+        if (!(_relativeAxisFlags & (1 << axis))) continue;
+
+        int32_t &value = axisValue(axis);
+        value -= clampRelativeValue(value);
+        if (value != 0) {
+            // Remainder goes out with the next report
+            _pendingFields |= JOYSTICK_FIELD_MASK(axis);
+        }
+    }
 }
 
 void Joystick_::setXAxis(int32_t value) {
+    if (_xAxis != value) _pendingFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_X_AXIS);
     _xAxis = value;
-    if (_autoSendState) sendState();
+    stateChanged();
 }
 
 void Joystick_::setYAxis(int32_t value) {
+    if (_yAxis != value) _pendingFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_Y_AXIS);
     _yAxis = value;
-    if (_autoSendState) sendState();
+    stateChanged();
 }
 
 void Joystick_::setZAxis(int32_t value) {
+    if (_zAxis != value) _pendingFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_Z_AXIS);
     _zAxis = value;
-    if (_autoSendState) sendState();
+    stateChanged();
 }
 
 void Joystick_::setRxAxis(int32_t value) {
+    if (_xAxisRotation != value) _pendingFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_RX_AXIS);
     _xAxisRotation = value;
-    if (_autoSendState) sendState();
+    stateChanged();
 }
 
 void Joystick_::setRyAxis(int32_t value) {
+    if (_yAxisRotation != value) _pendingFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_RY_AXIS);
     _yAxisRotation = value;
-    if (_autoSendState) sendState();
+    stateChanged();
 }
 
 void Joystick_::setRzAxis(int32_t value) {
+    if (_zAxisRotation != value) _pendingFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_RZ_AXIS);
     _zAxisRotation = value;
-    if (_autoSendState) sendState();
+    stateChanged();
 }
 
 void Joystick_::setRudder(int32_t value) {
+    if (_rudder != value) _pendingFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_RUDDER);
     _rudder = value;
-    if (_autoSendState) sendState();
+    stateChanged();
 }
 
 void Joystick_::setThrottle(int32_t value) {
+    if (_throttle != value) _pendingFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_THROTTLE);
     _throttle = value;
-    if (_autoSendState) sendState();
+    stateChanged();
 }
 
 void Joystick_::setAccelerator(int32_t value) {
+    if (_accelerator != value) _pendingFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_ACCELERATOR);
     _accelerator = value;
-    if (_autoSendState) sendState();
+    stateChanged();
 }
 
 void Joystick_::setBrake(int32_t value) {
+    if (_brake != value) _pendingFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_BRAKE);
     _brake = value;
-    if (_autoSendState) sendState();
+    stateChanged();
 }
 
 void Joystick_::setSteering(int32_t value) {
+    if (_steering != value) _pendingFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_STEERING);
     _steering = value;
-    if (_autoSendState) sendState();
+    stateChanged();
 }
 
 void Joystick_::setHatSwitch(int8_t hatSwitchIndex, int16_t value) {
     if (hatSwitchIndex >= _hatSwitchCount) return;
 
+    if (_hatSwitchValues[hatSwitchIndex] != value) {
+        _pendingFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_HAT_SWITCH_0 + hatSwitchIndex);
+    }
     _hatSwitchValues[hatSwitchIndex] = value;
-    if (_autoSendState) sendState();
+    stateChanged();
+}
+
+void Joystick_::setField(JoystickField field, int32_t value) {
+    switch (field) {
+        case JOYSTICK_FIELD_X_AXIS:
+            setXAxis(value);
+            break;
+        case JOYSTICK_FIELD_Y_AXIS:
+            setYAxis(value);
+            break;
+        case JOYSTICK_FIELD_Z_AXIS:
+            setZAxis(value);
+            break;
+        case JOYSTICK_FIELD_RX_AXIS:
+            setRxAxis(value);
+            break;
+        case JOYSTICK_FIELD_RY_AXIS:
+            setRyAxis(value);
+            break;
+        case JOYSTICK_FIELD_RZ_AXIS:
+            setRzAxis(value);
+            break;
+        case JOYSTICK_FIELD_RUDDER:
+            setRudder(value);
+            break;
+        case JOYSTICK_FIELD_THROTTLE:
+            setThrottle(value);
+            break;
+        case JOYSTICK_FIELD_ACCELERATOR:
+            setAccelerator(value);
+            break;
+        case JOYSTICK_FIELD_BRAKE:
+            setBrake(value);
+            break;
+        case JOYSTICK_FIELD_STEERING:
+            setSteering(value);
+            break;
+        case JOYSTICK_FIELD_HAT_SWITCH_0:
+            setHatSwitch(0, (int16_t) value);
+            break;
+        case JOYSTICK_FIELD_HAT_SWITCH_1:
+            setHatSwitch(1, (int16_t) value);
+            break;
+        default:
+            break;
+    }
+}
+
+void Joystick_::beginUpdate() {
+    _updateDepth++;
+}
+
+void Joystick_::endUpdate() {
+    if (_updateDepth == 0) return;
+    _updateDepth--;
+
+    if ((_updateDepth == 0) && _updatePending) {
+        _updatePending = false;
+        if (_autoSendState) sendAutoState();
+    }
+}
+
+void Joystick_::stateChanged() {
+    if (_suspended) {
+        if (!_wakeupRequested && (_pendingFields & _wakeupFields) && (_wakeupCallback != nullptr)) {
+            _wakeupRequested = true;
+            _wakeupCallback();
+        }
+    }
+
+    if (_updateDepth > 0) {
+        _updatePending = true;
+        return;
+    }
+
+    if (_autoSendState) sendAutoState();
+}
+
+void Joystick_::sendAutoState() {
+    // No later setter would carry a relative remainder, so it goes out in
+    // the following reports
+    do {
+        sendState();
+    } while (!_suspended && hasPendingRelative());
+}
+
+bool Joystick_::radialPairActive(JoystickAxisPair pair) const {
+    if (!_radialSettings[pair].enabled) return false;
+
+    uint8_t pairFlags = (pair == JOYSTICK_AXIS_PAIR_XY)
+                        ? (JOYSTICK_INCLUDE_X_AXIS | JOYSTICK_INCLUDE_Y_AXIS)
+                        : (JOYSTICK_INCLUDE_RX_AXIS | JOYSTICK_INCLUDE_RY_AXIS);
+    return ((_includeAxisFlags & pairFlags) == pairFlags) && !(_relativeAxisFlags & pairFlags);
+}
+
+int32_t Joystick_::getAxisPosition(JoystickField axis) const {
+    switch (axis) {
+        case JOYSTICK_FIELD_X_AXIS:
+            return normalizeAxisValue(_xAxis, _xAxisMinimum, _xAxisMaximum);
+        case JOYSTICK_FIELD_Y_AXIS:
+            return normalizeAxisValue(_yAxis, _yAxisMinimum, _yAxisMaximum);
+        case JOYSTICK_FIELD_Z_AXIS:
+            return normalizeAxisValue(_zAxis, _zAxisMinimum, _zAxisMaximum);
+        case JOYSTICK_FIELD_RX_AXIS:
+            return normalizeAxisValue(_xAxisRotation, _rxAxisMinimum, _rxAxisMaximum);
+        case JOYSTICK_FIELD_RY_AXIS:
+            return normalizeAxisValue(_yAxisRotation, _ryAxisMinimum, _ryAxisMaximum);
+        case JOYSTICK_FIELD_RZ_AXIS:
+            return normalizeAxisValue(_zAxisRotation, _rzAxisMinimum, _rzAxisMaximum);
+        default:
+            return 0;
+    }
+}
+
+int32_t Joystick_::normalizeAxisValue(int32_t value, int32_t valueMinimum, int32_t valueMaximum) {
+    int32_t realMinimum = min(valueMinimum, valueMaximum);
+    int32_t realMaximum = max(valueMinimum, valueMaximum);
+    uint32_t span = (uint32_t) (realMaximum - realMinimum);
+    uint32_t offset;
+
+    if (span == 0) return 0;
+
+    if (value < realMinimum) {
+        value = realMinimum;
+    }
+    if (value > realMaximum) {
+        value = realMaximum;
+    }
+
+    if (valueMinimum > valueMaximum) {
+        // Values go from a larger number to a smaller number (e.g. 1024 to 0)
+        value = realMaximum - value + realMinimum;
+    }
+
+    // Scale to -JOYSTICK_RADIAL_MAXIMUM..JOYSTICK_RADIAL_MAXIMUM
+    offset = (uint32_t) (value - realMinimum);
+    if (span <= 0xFFFF) {
+        offset = (offset * (2 * JOYSTICK_RADIAL_MAXIMUM)) / span;
+    } else {
+        offset = (uint32_t) (((uint64_t) offset * (2 * JOYSTICK_RADIAL_MAXIMUM)) / span);
+    }
+
+    return (int32_t) offset - JOYSTICK_RADIAL_MAXIMUM;
+}
+
+int Joystick_::buildAndSetRadialValues(const JoystickRadialSettings &settings, int32_t xValue, int32_t xMinimum,
+                                       int32_t xMaximum, int32_t yValue, int32_t yMinimum, int32_t yMaximum,
+                                       uint8_t dataLocation[]) {
+    int32_t x = normalizeAxisValue(xValue, xMinimum, xMaximum);
+    int32_t y = normalizeAxisValue(yValue, yMinimum, yMaximum);
+    int32_t length = joystickSqrt((uint32_t) (x * x) + (uint32_t) (y * y));
+    int32_t magnitude = length;
+
+    if (settings.squareToCircle) {
+        // On a square gate the edge is where the larger component is full
+        // scale, so the deflection is measured against the gate (Chebyshev)
+        // and then drawn on the circle below
+        magnitude = max(abs(x), abs(y));
+    }
+
+    if (magnitude <= settings.deadzone) {
+        x = 0;
+        y = 0;
+    } else {
+        int32_t scaled = JOYSTICK_RADIAL_MAXIMUM;
+        if (magnitude < settings.saturation) {
+            scaled = ((magnitude - settings.deadzone) * JOYSTICK_RADIAL_MAXIMUM) /
+                     (settings.saturation - settings.deadzone);
+        }
+
+        // Rescale along the original direction to a vector of length scaled
+        x = (x * scaled) / length;
+        y = (y * scaled) / length;
+    }
+
+    // Map -JOYSTICK_RADIAL_MAXIMUM..JOYSTICK_RADIAL_MAXIMUM onto 0..65535
+    uint16_t xConverted = (uint16_t) (x + JOYSTICK_RADIAL_MAXIMUM + (x > 0));
+    uint16_t yConverted = (uint16_t) (y + JOYSTICK_RADIAL_MAXIMUM + (y > 0));
+
+    dataLocation[0] = (uint8_t) (xConverted & 0x00FF);
+    dataLocation[1] = (uint8_t) (xConverted >> 8);
+    dataLocation[2] = (uint8_t) (yConverted & 0x00FF);
+    dataLocation[3] = (uint8_t) (yConverted >> 8);
+
+    return 4;
+}
+
+int Joystick_::buildAndSetAxisField(uint8_t axisFlag, int32_t value, int32_t valueMinimum, int32_t valueMaximum,
+                                    uint8_t dataLocation[]) const {
+    if (_relativeAxisFlags & axisFlag) {
+        return buildAndSetRelativeValue(_includeAxisFlags & axisFlag, value, dataLocation);
+    }
+    return buildAndSetAxisValue(_includeAxisFlags & axisFlag, value, valueMinimum, valueMaximum, dataLocation);
+}
+
+int32_t Joystick_::clampRelativeValue(int32_t value) {
+    if (value < JOYSTICK_RELATIVE_MINIMUM) return JOYSTICK_RELATIVE_MINIMUM;
+    if (value > JOYSTICK_RELATIVE_MAXIMUM) return JOYSTICK_RELATIVE_MAXIMUM;
+    return value;
+}
+
+int Joystick_::buildAndSetRelativeValue(bool includeValue, int32_t value, uint8_t dataLocation[]) {
+    if (!includeValue) return 0;
+
+    // Larger deltas are split over several reports
+    uint16_t convertedValue = (uint16_t) (int16_t) clampRelativeValue(value);
+
+    dataLocation[0] = (uint8_t) (convertedValue & 0x00FF);
+    dataLocation[1] = (uint8_t) (convertedValue >> 8);
+
+    return 2;
 }
 
 int Joystick_::buildAndSet16BitValue(bool includeValue, int32_t value, int32_t valueMinimum, int32_t valueMaximum,
@@ -239,8 +596,7 @@ int Joystick_::buildAndSetSimulationValue(bool includeValue, int32_t value, int3
                                  JOYSTICK_SIMULATOR_MAXIMUM, dataLocation);
 }
 
-void Joystick_::sendState() {
-    uint8_t data[_hidReportSize];
+void Joystick_::buildReport(uint8_t data[]) const {
     int index = 0;
 
     // Load Button State
@@ -267,17 +623,28 @@ void Joystick_::sendState() {
     } // Hat Switches
 
     // Set Axis Values
-    index += buildAndSetAxisValue(_includeAxisFlags & JOYSTICK_INCLUDE_X_AXIS, _xAxis, _xAxisMinimum, _xAxisMaximum,
-                                  &(data[index]));
-    index += buildAndSetAxisValue(_includeAxisFlags & JOYSTICK_INCLUDE_Y_AXIS, _yAxis, _yAxisMinimum, _yAxisMaximum,
-                                  &(data[index]));
-    index += buildAndSetAxisValue(_includeAxisFlags & JOYSTICK_INCLUDE_Z_AXIS, _zAxis, _zAxisMinimum, _zAxisMaximum,
+    if (radialPairActive(JOYSTICK_AXIS_PAIR_XY)) {
+        index += buildAndSetRadialValues(_radialSettings[JOYSTICK_AXIS_PAIR_XY], _xAxis, _xAxisMinimum,
+                                         _xAxisMaximum, _yAxis, _yAxisMinimum, _yAxisMaximum, &(data[index]));
+    } else {
+        index += buildAndSetAxisField(JOYSTICK_INCLUDE_X_AXIS, _xAxis, _xAxisMinimum,
+                                      _xAxisMaximum, &(data[index]));
+        index += buildAndSetAxisField(JOYSTICK_INCLUDE_Y_AXIS, _yAxis, _yAxisMinimum,
+                                      _yAxisMaximum, &(data[index]));
+    }
+    index += buildAndSetAxisField(JOYSTICK_INCLUDE_Z_AXIS, _zAxis, _zAxisMinimum, _zAxisMaximum,
                                   &(data[index]));
-    index += buildAndSetAxisValue(_includeAxisFlags & JOYSTICK_INCLUDE_RX_AXIS, _xAxisRotation, _rxAxisMinimum,
-                                  _rxAxisMaximum, &(data[index]));
-    index += buildAndSetAxisValue(_includeAxisFlags & JOYSTICK_INCLUDE_RY_AXIS, _yAxisRotation, _ryAxisMinimum,
-                                  _ryAxisMaximum, &(data[index]));
-    index += buildAndSetAxisValue(_includeAxisFlags & JOYSTICK_INCLUDE_RZ_AXIS, _zAxisRotation, _rzAxisMinimum,
+    if (radialPairActive(JOYSTICK_AXIS_PAIR_RX_RY)) {
+        index += buildAndSetRadialValues(_radialSettings[JOYSTICK_AXIS_PAIR_RX_RY], _xAxisRotation, _rxAxisMinimum,
+                                         _rxAxisMaximum, _yAxisRotation, _ryAxisMinimum, _ryAxisMaximum,
+                                         &(data[index]));
+    } else {
+        index += buildAndSetAxisField(JOYSTICK_INCLUDE_RX_AXIS, _xAxisRotation, _rxAxisMinimum,
+                                      _rxAxisMaximum, &(data[index]));
+        index += buildAndSetAxisField(JOYSTICK_INCLUDE_RY_AXIS, _yAxisRotation, _ryAxisMinimum,
+                                      _ryAxisMaximum, &(data[index]));
+    }
+    index += buildAndSetAxisField(JOYSTICK_INCLUDE_RZ_AXIS, _zAxisRotation, _rzAxisMinimum,
                                   _rzAxisMaximum, &(data[index]));
 
     // Set Simulation Values
@@ -291,6 +658,89 @@ void Joystick_::sendState() {
                                         _brakeMaximum, &(data[index]));
     index += buildAndSetSimulationValue(_includeSimulatorFlags & JOYSTICK_INCLUDE_STEERING, _steering, _steeringMinimum,
                                         _steeringMaximum, &(data[index]));
+}
+
+uint16_t Joystick_::compareReport(const uint8_t data[]) const {
+    if (!_hidReportValid) return JOYSTICK_FIELD_MASK_ALL;
+
+    uint16_t changedFields = 0;
+    int index = 0;
+
+    if (memcmp(data, _hidReport, _buttonValuesArraySize) != 0) {
+        changedFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_BUTTONS);
+    }
+    index += _buttonValuesArraySize;
+
+    if (_hatSwitchCount > 0) {
+        uint8_t difference = data[index] ^ _hidReport[index];
+        if (difference & 0x0F) changedFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_HAT_SWITCH_0);
+        if (difference & 0xF0) changedFields |= JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_HAT_SWITCH_1);
+        index++;
+    }
+
+    // Axes and simulator controls follow in JoystickField order
+    uint16_t includeFlags = _includeAxisFlags | (_includeSimulatorFlags << JOYSTICK_FIELD_RUDDER);
+    for (uint8_t field = JOYSTICK_FIELD_X_AXIS; field <= JOYSTICK_FIELD_STEERING; field++) {
+        if (!(includeFlags & JOYSTICK_FIELD_MASK(field))) continue;
+
+        if ((data[index] != _hidReport[index]) || (data[index + 1] != _hidReport[index + 1])) {
+            changedFields |= JOYSTICK_FIELD_MASK(field);
+        } else if ((_relativeAxisFlags & JOYSTICK_FIELD_MASK(field)) && (data[index] | data[index + 1])) {
+            // Repeating a non-zero delta is still a movement
+            changedFields |= JOYSTICK_FIELD_MASK(field);
+        }
+        index += 2;
+    }
 
-    HID().SendReport(_hidReportId, data, _hidReportSize);
+    return changedFields;
+}
+
+void Joystick_::setSuspended(bool suspended) {
+    if (_suspended == suspended) return;
+
+    _suspended = suspended;
+    _wakeupRequested = false;
+
+    if (!_suspended && (_resumeReportPending || (_pendingFields != 0))) {
+        if (_autoSendState) {
+            sendAutoState();
+        } else {
+            sendState();
+        }
+    }
+}
+
+void Joystick_::pollSuspended() {
+#if defined(ARDUINO_ARCH_AVR)
+    setSuspended(USBDevice.isSuspended());
+#endif
+}
+
+void Joystick_::sendState() {
+    uint8_t data[JOYSTICK_REPORT_SIZE_MAXIMUM];
+
+    if (_suspended) {
+        // Nobody is polling, send once the host resumes
+        _resumeReportPending = true;
+        return;
+    }
+    _resumeReportPending = false;
+
+    JOYSTICK_PROFILE_BEGIN(JOYSTICK_STAGE_ENCODE);
+    buildReport(data);
+    _changedFields = compareReport(data);
+    _pendingFields = 0;
+    if (_relativeAxisFlags != 0) consumeRelativeValues();
+
+    memcpy(_hidReport, data, _hidReportSize);
+    _hidReportValid = true;
+    JOYSTICK_PROFILE_END(JOYSTICK_STAGE_ENCODE);
+
+    JOYSTICK_PROFILE_BEGIN(JOYSTICK_STAGE_SEND);
+    HID().SendReport(_hidReportId, _hidReport, _hidReportSize);
+    JOYSTICK_PROFILE_END(JOYSTICK_STAGE_SEND);
+
+    if (_trace != nullptr) {
+        _trace->record(_hidReportId, _hidReport, _hidReportSize);
+    }
 }
@@ -0,0 +1,76 @@
+//
+// JoystickAnalogInput.cpp
+//
+
+#include "Arduino.h"
+#include "JoystickAnalogInput.h"
+
+JoystickArduinoAnalogInput::JoystickArduinoAnalogInput(uint8_t analogPin, const uint8_t selectPins[],
+                                                       uint8_t selectPinCount)
+        : _analogPin(analogPin), _selectPinCount(selectPinCount) {
+    if (_selectPinCount > 4) {
+        _selectPinCount = 4;
+    }
+    for (uint8_t index = 0; index < _selectPinCount; index++) {
+        _selectPins[index] = selectPins[index];
+    }
+}
+
+void JoystickArduinoAnalogInput::begin() {
+    for (uint8_t index = 0; index < _selectPinCount; index++) {
+        pinMode(_selectPins[index], OUTPUT);
+    }
+
+    // A first blocking read configures the ADC reference and prescaler
+    analogRead(_analogPin);
+}
+
+void JoystickArduinoAnalogInput::selectChannel(uint8_t channel) {
+    for (uint8_t index = 0; index < _selectPinCount; index++) {
+        digitalWrite(_selectPins[index], bitRead(channel, index) ? HIGH : LOW);
+    }
+}
+
+#if defined(__AVR__) && defined(ADCSRA) && defined(ADMUX)
+
+void JoystickArduinoAnalogInput::startConversion() {
+    uint8_t pin = _analogPin;
+#if defined(analogPinToChannel)
+    if (pin >= 18) pin -= 18;
+    pin = analogPinToChannel(pin);
+#else
+    if (pin >= 14) pin -= 14;
+#endif
+
+#if defined(ADCSRB) && defined(MUX5)
+    ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((pin >> 3) & 0x01) << MUX5);
+#endif
+    ADMUX = (ADMUX & 0xE0) | (pin & 0x07);
+    bitSet(ADCSRA, ADSC);
+}
+
+bool JoystickArduinoAnalogInput::conversionReady() {
+    return bit_is_clear(ADCSRA, ADSC);
+}
+
+int16_t JoystickArduinoAnalogInput::readConversion() {
+    uint8_t low = ADCL;
+    uint8_t high = ADCH;
+    return (int16_t) ((high << 8) | low);
+}
+
+#else
+
+void JoystickArduinoAnalogInput::startConversion() {
+    _value = (int16_t) analogRead(_analogPin);
+}
+
+bool JoystickArduinoAnalogInput::conversionReady() {
+    return true;
+}
+
+int16_t JoystickArduinoAnalogInput::readConversion() {
+    return _value;
+}
+
+#endif
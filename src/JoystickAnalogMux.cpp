@@ -0,0 +1,120 @@
+//
+// JoystickAnalogMux.cpp
+//
+
+#include "JoystickAnalogMux.h"
+#include "JoystickProfiler.h"
+
+#define JOYSTICK_ANALOG_MUX_UNASSIGNED 0xFF
+
+JoystickAnalogMux::JoystickAnalogMux(Joystick_ &joystick, JoystickAnalogInput &input, JoystickClock clock)
+        : _joystick(joystick), _input(input), _clock(clock) {
+    for (uint8_t channel = 0; channel < JOYSTICK_ANALOG_MUX_CHANNEL_MAXIMUM; channel++) {
+        _fields[channel] = JOYSTICK_ANALOG_MUX_UNASSIGNED;
+        _values[channel] = 0;
+    }
+}
+
+void JoystickAnalogMux::assignChannel(uint8_t channel, JoystickField field) {
+    if (channel >= JOYSTICK_ANALOG_MUX_CHANNEL_MAXIMUM) return;
+    if (field >= JOYSTICK_FIELD_HAT_SWITCH_0) return;
+
+    _fields[channel] = field;
+    rebuildChannels();
+}
+
+void JoystickAnalogMux::unassignChannel(uint8_t channel) {
+    if (channel >= JOYSTICK_ANALOG_MUX_CHANNEL_MAXIMUM) return;
+
+    _fields[channel] = JOYSTICK_ANALOG_MUX_UNASSIGNED;
+    rebuildChannels();
+}
+
+void JoystickAnalogMux::setSettlingTime(uint32_t settlingTime) {
+    _settlingTime = settlingTime;
+}
+
+void JoystickAnalogMux::rebuildChannels() {
+    _channelCount = 0;
+    for (uint8_t channel = 0; channel < JOYSTICK_ANALOG_MUX_CHANNEL_MAXIMUM; channel++) {
+        if (_fields[channel] != JOYSTICK_ANALOG_MUX_UNASSIGNED) {
+            _channels[_channelCount++] = channel;
+        }
+    }
+
+    // Restart the sweep with the new channel list
+    _state = STATE_IDLE;
+}
+
+void JoystickAnalogMux::selectPosition(uint8_t position, uint32_t now) {
+    _position = position;
+    _input.selectChannel(_channels[position]);
+    _selectTime = now;
+    _state = STATE_SETTLING;
+}
+
+bool JoystickAnalogMux::update() {
+    if (_channelCount == 0) return false;
+
+    uint32_t now = _clock();
+
+    switch (_state) {
+        case STATE_IDLE:
+            _sweepStart = now;
+            selectPosition(0, now);
+            return false;
+
+        case STATE_SETTLING:
+            if (joystickTimeDifference(now, _selectTime) < (int32_t) _settlingTime) return false;
+            _input.startConversion();
+            _state = STATE_CONVERTING;
+            return false;
+
+        case STATE_CONVERTING: {
+            if (!_input.conversionReady()) return false;
+
+            JOYSTICK_PROFILE_BEGIN(JOYSTICK_STAGE_SCAN);
+            int16_t value = _input.readConversion();
+            uint8_t channel = _channels[_position];
+            uint8_t nextPosition = _position + 1;
+            bool sweepDone = (nextPosition >= _channelCount);
+
+            // Switch the mux first, it settles while this result is handled
+            selectPosition(sweepDone ? 0 : nextPosition, now);
+            _values[channel] = value;
+            JOYSTICK_PROFILE_END(JOYSTICK_STAGE_SCAN);
+
+            if (!sweepDone) return false;
+
+            applySweep();
+            _sweepDuration = (uint32_t) joystickTimeDifference(now, _sweepStart);
+            _sweepStart = now;
+            _sweepCount++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void JoystickAnalogMux::applySweep() {
+    _joystick.beginUpdate();
+    for (uint8_t index = 0; index < _channelCount; index++) {
+        uint8_t channel = _channels[index];
+        _joystick.setField((JoystickField) _fields[channel], _values[channel]);
+    }
+    _joystick.endUpdate();
+}
+
+int16_t JoystickAnalogMux::getChannelValue(uint8_t channel) const {
+    if (channel >= JOYSTICK_ANALOG_MUX_CHANNEL_MAXIMUM) return 0;
+    return _values[channel];
+}
+
+uint32_t JoystickAnalogMux::getSweepDuration() const {
+    return _sweepDuration;
+}
+
+uint32_t JoystickAnalogMux::getSweepCount() const {
+    return _sweepCount;
+}
@@ -0,0 +1,33 @@
+//
+// JoystickArduinoI2cBus.cpp
+//
+
+#include "Arduino.h"
+#include "JoystickArduinoI2cBus.h"
+
+JoystickArduinoI2cBus::JoystickArduinoI2cBus(TwoWire &wire, uint32_t clock) : _wire(wire), _clock(clock) {}
+
+void JoystickArduinoI2cBus::begin() {
+    _wire.begin();
+    _wire.setClock(_clock);
+}
+
+bool JoystickArduinoI2cBus::writeRegisters(uint8_t address, uint8_t reg, const uint8_t data[], uint8_t length) {
+    _wire.beginTransmission(address);
+    _wire.write(reg);
+    _wire.write(data, length);
+    return _wire.endTransmission() == 0;
+}
+
+bool JoystickArduinoI2cBus::readRegisters(uint8_t address, uint8_t reg, uint8_t buffer[], uint8_t length) {
+    _wire.beginTransmission(address);
+    _wire.write(reg);
+    if (_wire.endTransmission(false) != 0) return false;
+
+    if (_wire.requestFrom(address, length) != length) return false;
+
+    for (uint8_t index = 0; index < length; index++) {
+        buffer[index] = (uint8_t) _wire.read();
+    }
+    return true;
+}
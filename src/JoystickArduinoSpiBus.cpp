@@ -0,0 +1,38 @@
+//
+// JoystickArduinoSpiBus.cpp
+//
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "JoystickArduinoSpiBus.h"
+
+JoystickArduinoSpiBus::JoystickArduinoSpiBus(uint8_t loadPin, uint32_t clock)
+        : _loadPin(loadPin), _clock(clock) {}
+
+void JoystickArduinoSpiBus::begin() {
+    pinMode(_loadPin, OUTPUT);
+    digitalWrite(_loadPin, HIGH);
+    SPI.begin();
+}
+
+void JoystickArduinoSpiBus::beginTransaction() {
+    // The 74HC165 shifts on the rising edge, so sample on the falling one.
+    // Mode 2 idles high: the clock has to settle there before the load pulse,
+    // or its first rise would shift out input H.
+    SPI.beginTransaction(SPISettings(_clock, MSBFIRST, SPI_MODE2));
+}
+
+void JoystickArduinoSpiBus::endTransaction() {
+    SPI.endTransaction();
+}
+
+void JoystickArduinoSpiBus::latch() {
+    digitalWrite(_loadPin, LOW);
+    delayMicroseconds(1);
+    digitalWrite(_loadPin, HIGH);
+}
+
+void JoystickArduinoSpiBus::read(uint8_t buffer[], uint8_t length) {
+    memset(buffer, 0xFF, length);
+    SPI.transfer(buffer, length);
+}
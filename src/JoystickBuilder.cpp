@@ -5,23 +5,30 @@
 
 
 #include "JoystickBuilder.h"
-
-#define JOYSTICK_INCLUDE_X_AXIS  0b00000001
-#define JOYSTICK_INCLUDE_Y_AXIS  0b00000010
-#define JOYSTICK_INCLUDE_Z_AXIS  0b00000100
-#define JOYSTICK_INCLUDE_RX_AXIS 0b00001000
-#define JOYSTICK_INCLUDE_RY_AXIS 0b00010000
-#define JOYSTICK_INCLUDE_RZ_AXIS 0b00100000
-
-#define JOYSTICK_INCLUDE_RUDDER      0b00000001
-#define JOYSTICK_INCLUDE_THROTTLE    0b00000010
-#define JOYSTICK_INCLUDE_ACCELERATOR 0b00000100
-#define JOYSTICK_INCLUDE_BRAKE       0b00001000
-#define JOYSTICK_INCLUDE_STEERING    0b00010000
+#include "JoystickConfig.h"
 
 JoystickBuilder::JoystickBuilder(uint8_t hidReportId, uint8_t joystickType)
         : _hidReportId(hidReportId), _joystickType(joystickType) {}
 
+JoystickBuilder::JoystickBuilder(const JoystickConfig &config)
+        : _hidReportId(config.reportId), _joystickType(config.joystickType) {
+    setButtonCount(config.buttonCount);
+    setHatSwitchCount(config.hatSwitchCount);
+    includeAxes(config.axisFlags);
+    includeSimulatorControls(config.simulatorFlags);
+    _relativeAxisFlags = config.relativeAxisFlags;
+}
+
+void JoystickBuilder::captureConfig(JoystickConfig &config) const {
+    config.reportId = _hidReportId;
+    config.joystickType = _joystickType;
+    config.buttonCount = _buttonCount;
+    config.hatSwitchCount = _hatSwitchCount;
+    config.axisFlags = getAxisFlags();
+    config.relativeAxisFlags = getRelativeAxisFlags();
+    config.simulatorFlags = getSimulatorFlags();
+}
+
 JoystickBuilder &JoystickBuilder::includeXAxis(bool include) {
     _includeXAxis = include;
     return *this;
@@ -77,116 +84,112 @@ JoystickBuilder &JoystickBuilder::includeSteering(bool include) {
     return *this;
 }
 
-JoystickBuilder &JoystickBuilder::setButtonCount(uint8_t buttonCount) {
-    if (buttonCount >= 64) {
-        _buttonCount = 64;
-    } else {
-        _buttonCount = buttonCount;
-    }
+JoystickBuilder &JoystickBuilder::includeAxes(uint8_t axisFlags) {
+    _includeXAxis = axisFlags & JOYSTICK_INCLUDE_X_AXIS;
+    _includeYAxis = axisFlags & JOYSTICK_INCLUDE_Y_AXIS;
+    _includeZAxis = axisFlags & JOYSTICK_INCLUDE_Z_AXIS;
+    _includeRxAxis = axisFlags & JOYSTICK_INCLUDE_RX_AXIS;
+    _includeRyAxis = axisFlags & JOYSTICK_INCLUDE_RY_AXIS;
+    _includeRzAxis = axisFlags & JOYSTICK_INCLUDE_RZ_AXIS;
     return *this;
 }
 
-JoystickBuilder &JoystickBuilder::setHatSwitchCount(uint8_t hatSwitchCount) {
-    _hatSwitchCount = hatSwitchCount;
+JoystickBuilder &JoystickBuilder::includeSimulatorControls(uint8_t simulatorFlags) {
+    _includeRudder = simulatorFlags & JOYSTICK_INCLUDE_RUDDER;
+    _includeThrottle = simulatorFlags & JOYSTICK_INCLUDE_THROTTLE;
+    _includeAccelerator = simulatorFlags & JOYSTICK_INCLUDE_ACCELERATOR;
+    _includeBrake = simulatorFlags & JOYSTICK_INCLUDE_BRAKE;
+    _includeSteering = simulatorFlags & JOYSTICK_INCLUDE_STEERING;
     return *this;
 }
 
-uint8_t JoystickBuilder::getHidSize() const {
-    // Button
-    uint8_t buttonPaddingBits = getButtonPaddingBits();
-    // Axis Calculations
-    uint8_t axisCount = getAxisCount();
-    uint8_t simulationCount = getSimulatorCount();
+JoystickBuilder &JoystickBuilder::setXAxisRelative(bool relative) {
+    return setAxisRelative(JOYSTICK_INCLUDE_X_AXIS, relative);
+}
 
-    int hidReportDescriptorSize = 8;
+JoystickBuilder &JoystickBuilder::setYAxisRelative(bool relative) {
+    return setAxisRelative(JOYSTICK_INCLUDE_Y_AXIS, relative);
+}
 
-    if (_buttonCount > 0) {
+JoystickBuilder &JoystickBuilder::setZAxisRelative(bool relative) {
+    return setAxisRelative(JOYSTICK_INCLUDE_Z_AXIS, relative);
+}
 
-        hidReportDescriptorSize += 20;
+JoystickBuilder &JoystickBuilder::setRxAxisRelative(bool relative) {
+    return setAxisRelative(JOYSTICK_INCLUDE_RX_AXIS, relative);
+}
 
-        if (buttonPaddingBits > 0) {
-            hidReportDescriptorSize += 6;
-        } // Padding Bits Needed
+JoystickBuilder &JoystickBuilder::setRyAxisRelative(bool relative) {
+    return setAxisRelative(JOYSTICK_INCLUDE_RY_AXIS, relative);
+}
 
-    } // Buttons
+JoystickBuilder &JoystickBuilder::setRzAxisRelative(bool relative) {
+    return setAxisRelative(JOYSTICK_INCLUDE_RZ_AXIS, relative);
+}
 
-    if ((axisCount > 0) || (_hatSwitchCount > 0)) {
-        hidReportDescriptorSize += 2;
+JoystickBuilder &JoystickBuilder::setAxisRelative(uint8_t axisFlag, bool relative) {
+    if (relative) {
+        _relativeAxisFlags |= axisFlag;
+    } else {
+        _relativeAxisFlags &= ~axisFlag;
     }
+    return *this;
+}
 
-    if (_hatSwitchCount > 0) {
-
-        hidReportDescriptorSize += 19;
-        if (_hatSwitchCount > 1) {
-            hidReportDescriptorSize += 19;
-        } else {
-            hidReportDescriptorSize += 6;
-        } // One or Two Hat Switches?
-
-    } // Hat Switches
-
-    if (axisCount > 0) {
-        hidReportDescriptorSize += 15;
-
-        if (_includeXAxis) {
-            hidReportDescriptorSize += 2;
-        }
-
-        if (_includeYAxis) {
-            hidReportDescriptorSize += 2;
-        }
-
-        if (_includeZAxis) {
-            hidReportDescriptorSize += 2;
-        }
-
-        if (_includeRxAxis) {
-            hidReportDescriptorSize += 2;
-        }
-
-        if (_includeRyAxis) {
-            hidReportDescriptorSize += 2;
-        }
-
-        if (_includeRzAxis) {
-            hidReportDescriptorSize += 2;
-        }
-        hidReportDescriptorSize += 3;
-
-    } // X, Y, Z, Rx, Ry, and Rz Axis
-
-    if (simulationCount > 0) {
-
-        hidReportDescriptorSize += 15;
-
-        if (_includeRudder) {
-            hidReportDescriptorSize += 2;
-        }
+JoystickBuilder &JoystickBuilder::setButtonCount(uint8_t buttonCount) {
+    if (buttonCount >= 64) {
+        _buttonCount = 64;
+    } else {
+        _buttonCount = buttonCount;
+    }
+    return *this;
+}
 
-        if (_includeThrottle) {
-            hidReportDescriptorSize += 2;
-        }
+JoystickBuilder &JoystickBuilder::setHatSwitchCount(uint8_t hatSwitchCount) {
+    _hatSwitchCount = hatSwitchCount;
+    return *this;
+}
 
-        if (_includeAccelerator) {
-            hidReportDescriptorSize += 2;
-        }
+JoystickBuilder &JoystickBuilder::setApplicationCollectionOpen(bool open) {
+    _applicationCollectionOpen = open;
+    return *this;
+}
 
-        if (_includeBrake) {
-            hidReportDescriptorSize += 2;
-        }
+uint8_t JoystickBuilder::getHidSize() const {
+    return joystickDescriptorSize(_buttonCount, _hatSwitchCount, getAxisFlags(), getRelativeAxisFlags(),
+                                  getSimulatorCount(), _applicationCollectionOpen);
+}
 
-        if (_includeSteering) {
-            hidReportDescriptorSize += 2;
-        }
+uint16_t JoystickBuilder::getReportBits() const {
+    return joystickReportBits(_buttonCount, _hatSwitchCount, getAxisCount(), getSimulatorCount());
+}
 
-        hidReportDescriptorSize += 3;
+uint8_t JoystickBuilder::getReportSize() const {
+    return joystickReportSize(_buttonCount, _hatSwitchCount, getAxisCount(), getSimulatorCount());
+}
 
-    } // Simulation Controls
+uint8_t JoystickBuilder::getPaddingBits() const {
+    return joystickPaddingBits(_buttonCount, _hatSwitchCount);
+}
 
-    // END_COLLECTION
-    hidReportDescriptorSize += 1;
+uint32_t JoystickBuilder::getBandwidth(uint16_t pollRate, uint8_t reportIdCount) const {
+    // The HID core prefixes every report with its report ID
+    return (uint32_t) (getReportSize() + 1) * pollRate * reportIdCount;
+}
 
-    return hidReportDescriptorSize;
+JoystickReportPlan JoystickBuilder::plan(uint16_t pollRate, uint8_t reportIdCount, uint8_t maxPacketSize) const {
+    JoystickReportPlan plan;
+    plan.reportBits = getReportBits();
+    plan.reportSize = getReportSize();
+    plan.paddingBits = getPaddingBits();
+    plan.paddingBytes = plan.reportSize - joystickPackedReportSize(_buttonCount, _hatSwitchCount, getAxisCount(),
+                                                                   getSimulatorCount());
+    plan.descriptorSize = getHidSize();
+    plan.transferSize = plan.reportSize + 1;
+    plan.bandwidth = getBandwidth(pollRate, reportIdCount);
+    plan.exceedsPacketSize = plan.transferSize > maxPacketSize;
+    plan.wastesPadding = plan.paddingBytes > 0;
+    return plan;
 }
 
 uint8_t JoystickBuilder::getAxisFlags() const {
@@ -201,6 +204,11 @@ uint8_t JoystickBuilder::getAxisFlags() const {
     return includeAxisFlags;
 }
 
+uint8_t JoystickBuilder::getRelativeAxisFlags() const {
+    // Only included axes can be relative
+    return _relativeAxisFlags & getAxisFlags();
+}
+
 uint8_t JoystickBuilder::getSimulatorFlags() const {
     uint8_t includeSimulatorFlags = 0;
     includeSimulatorFlags |= (_includeRudder ? JOYSTICK_INCLUDE_RUDDER : 0);
@@ -212,7 +220,7 @@ uint8_t JoystickBuilder::getSimulatorFlags() const {
     return includeSimulatorFlags;
 }
 
-void JoystickBuilder::buildDescriptor(uint8_t *buffer) const {
+uint8_t JoystickBuilder::buildDescriptor(uint8_t *buffer) const {
     // Button
     uint8_t buttonPaddingBits = getButtonPaddingBits();
     // Axis Calculations
@@ -409,69 +417,75 @@ void JoystickBuilder::buildDescriptor(uint8_t *buffer) const {
         buffer[hidReportDescriptorSize++] = 0x09;
         buffer[hidReportDescriptorSize++] = 0x01;
 
-        // LOGICAL_MINIMUM (0)
-        buffer[hidReportDescriptorSize++] = 0x15;
-        buffer[hidReportDescriptorSize++] = 0x00;
-
-        // LOGICAL_MAXIMUM (65535)
-        buffer[hidReportDescriptorSize++] = 0x27;
-        buffer[hidReportDescriptorSize++] = 0XFF;
-        buffer[hidReportDescriptorSize++] = 0XFF;
-        buffer[hidReportDescriptorSize++] = 0x00;
-        buffer[hidReportDescriptorSize++] = 0x00;
-
         // REPORT_SIZE (16)
         buffer[hidReportDescriptorSize++] = 0x75;
         buffer[hidReportDescriptorSize++] = 0x10;
 
-        // REPORT_COUNT (axisCount)
-        buffer[hidReportDescriptorSize++] = 0x95;
-        buffer[hidReportDescriptorSize++] = axisCount;
-
         // COLLECTION (Physical)
         buffer[hidReportDescriptorSize++] = 0xA1;
         buffer[hidReportDescriptorSize++] = 0x00;
 
-        if (_includeXAxis) {
-            // USAGE (X)
-            buffer[hidReportDescriptorSize++] = 0x09;
-            buffer[hidReportDescriptorSize++] = 0x30;
-        }
-
-        if (_includeYAxis) {
-            // USAGE (Y)
-            buffer[hidReportDescriptorSize++] = 0x09;
-            buffer[hidReportDescriptorSize++] = 0x31;
-        }
-
-        if (_includeZAxis) {
-            // USAGE (Z)
-            buffer[hidReportDescriptorSize++] = 0x09;
-            buffer[hidReportDescriptorSize++] = 0x32;
-        }
-
-        if (_includeRxAxis) {
-            // USAGE (Rx)
-            buffer[hidReportDescriptorSize++] = 0x09;
-            buffer[hidReportDescriptorSize++] = 0x33;
-        }
+        // Consecutive axes of the same kind (absolute or relative) share one
+        // input item, keeping the report in X, Y, Z, Rx, Ry, Rz order.
+        uint8_t axisFlags = getAxisFlags();
+        uint8_t axis = 0;
+        while (axis < JOYSTICK_AXIS_COUNT) {
+            if (!(axisFlags & (1 << axis))) {
+                axis++;
+                continue;
+            }
+
+            bool relative = _relativeAxisFlags & (1 << axis);
+            uint8_t runAxes[JOYSTICK_AXIS_COUNT];
+            uint8_t runCount = 0;
+            for (; axis < JOYSTICK_AXIS_COUNT; axis++) {
+                if (!(axisFlags & (1 << axis))) continue;
+                if (((_relativeAxisFlags & (1 << axis)) != 0) != relative) break;
+                runAxes[runCount++] = axis;
+            }
+
+            if (relative) {
+
+                // LOGICAL_MINIMUM (-32767)
+                buffer[hidReportDescriptorSize++] = 0x16;
+                buffer[hidReportDescriptorSize++] = 0x01;
+                buffer[hidReportDescriptorSize++] = 0x80;
+
+                // LOGICAL_MAXIMUM (32767)
+                buffer[hidReportDescriptorSize++] = 0x26;
+                buffer[hidReportDescriptorSize++] = 0xFF;
+                buffer[hidReportDescriptorSize++] = 0x7F;
+
+            } else {
+
+                // LOGICAL_MINIMUM (0)
+                buffer[hidReportDescriptorSize++] = 0x15;
+                buffer[hidReportDescriptorSize++] = 0x00;
+
+                // LOGICAL_MAXIMUM (65535)
+                buffer[hidReportDescriptorSize++] = 0x27;
+                buffer[hidReportDescriptorSize++] = 0XFF;
+                buffer[hidReportDescriptorSize++] = 0XFF;
+                buffer[hidReportDescriptorSize++] = 0x00;
+                buffer[hidReportDescriptorSize++] = 0x00;
+
+            } // Relative or Absolute
+
+            // REPORT_COUNT (axes in this run)
+            buffer[hidReportDescriptorSize++] = 0x95;
+            buffer[hidReportDescriptorSize++] = runCount;
 
-        if (_includeRyAxis) {
-            // USAGE (Ry)
-            buffer[hidReportDescriptorSize++] = 0x09;
-            buffer[hidReportDescriptorSize++] = 0x34;
-        }
+            for (uint8_t index = 0; index < runCount; index++) {
+                // USAGE (X, Y, Z, Rx, Ry or Rz)
+                buffer[hidReportDescriptorSize++] = 0x09;
+                buffer[hidReportDescriptorSize++] = 0x30 + runAxes[index];
+            }
 
-        if (_includeRzAxis) {
-            // USAGE (Rz)
-            buffer[hidReportDescriptorSize++] = 0x09;
-            buffer[hidReportDescriptorSize++] = 0x35;
+            // INPUT (Data,Var,Rel) or INPUT (Data,Var,Abs)
+            buffer[hidReportDescriptorSize++] = 0x81;
+            buffer[hidReportDescriptorSize++] = relative ? 0x06 : 0x02;
         }
 
-        // INPUT (Data,Var,Abs)
-        buffer[hidReportDescriptorSize++] = 0x81;
-        buffer[hidReportDescriptorSize++] = 0x02;
-
         // END_COLLECTION (Physical)
         buffer[hidReportDescriptorSize++] = 0xc0;
 
@@ -545,8 +559,12 @@ void JoystickBuilder::buildDescriptor(uint8_t *buffer) const {
 
     } // Simulation Controls
 
-    // END_COLLECTION
-    buffer[hidReportDescriptorSize++] = 0xc0;
+    if (!_applicationCollectionOpen) {
+        // END_COLLECTION
+        buffer[hidReportDescriptorSize++] = 0xc0;
+    }
+
+    return hidReportDescriptorSize;
 }
 
 uint8_t JoystickBuilder::getAxisCount() const {
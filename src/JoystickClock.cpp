@@ -0,0 +1,10 @@
+//
+// JoystickClock.cpp
+//
+
+#include "Arduino.h"
+#include "JoystickClock.h"
+
+uint32_t joystickDefaultClock() {
+    return micros();
+}
@@ -0,0 +1,45 @@
+//
+// JoystickConfig.cpp
+//
+
+#include "JoystickConfig.h"
+#include "JoystickMath.h"
+
+static_assert(sizeof(JoystickConfig) <= 255, "JoystickConfig must fit its size field");
+
+static uint16_t configCrc(const JoystickConfig &config) {
+    return joystickCrc16((const uint8_t *) &config, offsetof(JoystickConfig, crc));
+}
+
+void JoystickConfig::seal() {
+    magic = JOYSTICK_CONFIG_MAGIC;
+    version = JOYSTICK_CONFIG_VERSION;
+    size = sizeof(JoystickConfig);
+    reserved = 0;
+    crc = configCrc(*this);
+
+    // Trailing padding on 32-bit targets: keep it fixed so that save() does
+    // not rewrite it every time
+    uint8_t *end = (uint8_t *) &crc + sizeof(crc);
+    memset(end, 0, (size_t) ((uint8_t *) (this + 1) - end));
+}
+
+bool JoystickConfig::isValid() const {
+    if (magic != JOYSTICK_CONFIG_MAGIC) return false;
+    if (version != JOYSTICK_CONFIG_VERSION) return false;
+    if (size != sizeof(JoystickConfig)) return false;
+
+    return crc == configCrc(*this);
+}
+
+bool JoystickConfigStorage::load(JoystickConfig &config, uint16_t address) {
+    if (!read(address, (uint8_t *) &config, sizeof(config))) return false;
+
+    return config.isValid();
+}
+
+bool JoystickConfigStorage::save(JoystickConfig &config, uint16_t address) {
+    config.seal();
+
+    return write(address, (const uint8_t *) &config, sizeof(config));
+}
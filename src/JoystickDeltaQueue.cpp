@@ -0,0 +1,137 @@
+//
+// JoystickDeltaQueue.cpp
+//
+
+#include "JoystickDeltaQueue.h"
+
+#define JOYSTICK_DELTA_QUEUE_MASK (JOYSTICK_DELTA_QUEUE_SIZE - 1)
+
+static_assert((JOYSTICK_DELTA_QUEUE_SIZE & JOYSTICK_DELTA_QUEUE_MASK) == 0,
+              "JOYSTICK_DELTA_QUEUE_SIZE must be a power of two");
+
+static_assert(JOYSTICK_BUTTON_COUNT_MAXIMUM / 8 <= 8, "Button bytes are tracked in an 8-bit mask");
+
+JoystickDeltaQueue::JoystickDeltaQueue() {
+    for (uint8_t field = 0; field < JOYSTICK_FIELD_BUTTONS; field++) {
+        _latestValues[field].store(0, JOYSTICK_MEMORY_RELAXED);
+    }
+    for (uint8_t index = 0; index < JOYSTICK_BUTTON_COUNT_MAXIMUM / 8; index++) {
+        _latestButtons[index].store(0, JOYSTICK_MEMORY_RELAXED);
+    }
+}
+
+bool JoystickDeltaQueue::push(const JoystickDelta &delta) {
+    uint16_t overflowField;
+    uint8_t overflowButtonByte = 0;
+
+    // Single producer, so the mirror needs no read-modify-write
+    if (delta.field == JOYSTICK_FIELD_BUTTONS) {
+        if (delta.index >= JOYSTICK_BUTTON_COUNT_MAXIMUM) return false;
+
+        JoystickAtomic<uint8_t> &buttons = _latestButtons[delta.index / 8];
+        uint8_t mask = (uint8_t) (1 << (delta.index % 8));
+        uint8_t value = buttons.load(JOYSTICK_MEMORY_RELAXED);
+        buttons.store(delta.value ? (value | mask) : (value & ~mask), JOYSTICK_MEMORY_RELAXED);
+        overflowField = 0;
+        overflowButtonByte = (uint8_t) (1 << (delta.index / 8));
+    } else {
+        if (delta.field >= JOYSTICK_FIELD_BUTTONS) return false;
+
+        _latestValues[delta.field].store(delta.value, JOYSTICK_MEMORY_RELAXED);
+        overflowField = JOYSTICK_FIELD_MASK(delta.field);
+    }
+
+    uint16_t head = _head.load(JOYSTICK_MEMORY_RELAXED);
+    uint16_t tail = _tail.load(JOYSTICK_MEMORY_ACQUIRE);
+
+    if ((uint16_t) (head - tail) >= JOYSTICK_DELTA_QUEUE_SIZE) {
+        _dropped.fetchAdd(1, JOYSTICK_MEMORY_RELAXED);
+        if (overflowField != 0) {
+            _overflowFields.fetchOr(overflowField, JOYSTICK_MEMORY_RELEASE);
+        } else {
+            _overflowButtonBytes.fetchOr(overflowButtonByte, JOYSTICK_MEMORY_RELEASE);
+        }
+        return false;
+    }
+
+    _buffer[head & JOYSTICK_DELTA_QUEUE_MASK] = delta;
+    _head.store((uint16_t) (head + 1), JOYSTICK_MEMORY_RELEASE);
+    return true;
+}
+
+bool JoystickDeltaQueue::pushField(JoystickField field, int32_t value) {
+    JoystickDelta delta = {field, 0, value};
+    return push(delta);
+}
+
+bool JoystickDeltaQueue::pushButton(uint8_t button, bool pressed) {
+    JoystickDelta delta = {JOYSTICK_FIELD_BUTTONS, button, pressed ? 1 : 0};
+    return push(delta);
+}
+
+bool JoystickDeltaQueue::pop(JoystickDelta &delta) {
+    uint16_t tail = _tail.load(JOYSTICK_MEMORY_RELAXED);
+    uint16_t head = _head.load(JOYSTICK_MEMORY_ACQUIRE);
+
+    if (head == tail) return false;
+
+    delta = _buffer[tail & JOYSTICK_DELTA_QUEUE_MASK];
+    _tail.store((uint16_t) (tail + 1), JOYSTICK_MEMORY_RELEASE);
+    return true;
+}
+
+uint16_t JoystickDeltaQueue::apply(Joystick_ &joystick, uint16_t maxCount) {
+    JoystickDelta delta;
+    uint16_t count = 0;
+
+    joystick.beginUpdate();
+    while ((count < maxCount) && pop(delta)) {
+        if (delta.field == JOYSTICK_FIELD_BUTTONS) {
+            joystick.setButton(delta.index, delta.value);
+        } else {
+            joystick.setField((JoystickField) delta.field, delta.value);
+        }
+        count++;
+    }
+
+    // The mirror is at least as new as anything that was queued, so it may
+    // only be applied once nothing older is left in the queue. The flags are
+    // taken first: a delta queued before them is then visible to size(), and
+    // one that overflows later raises its flag again.
+    uint16_t fields = _overflowFields.exchange(0, JOYSTICK_MEMORY_ACQUIRE);
+    uint8_t buttonBytes = _overflowButtonBytes.exchange(0, JOYSTICK_MEMORY_ACQUIRE);
+    if (size() == 0) {
+        applyOverflow(joystick, fields, buttonBytes);
+    } else {
+        _overflowFields.fetchOr(fields, JOYSTICK_MEMORY_RELAXED);
+        _overflowButtonBytes.fetchOr(buttonBytes, JOYSTICK_MEMORY_RELAXED);
+    }
+    joystick.endUpdate();
+
+    return count;
+}
+
+void JoystickDeltaQueue::applyOverflow(Joystick_ &joystick, uint16_t fields, uint8_t buttonBytes) {
+    for (uint8_t field = 0; fields != 0; field++, fields >>= 1) {
+        if (fields & 1) {
+            joystick.setField((JoystickField) field, _latestValues[field].load(JOYSTICK_MEMORY_RELAXED));
+        }
+    }
+
+    for (uint8_t index = 0; buttonBytes != 0; index++, buttonBytes >>= 1) {
+        if (buttonBytes & 1) {
+            uint8_t value = _latestButtons[index].load(JOYSTICK_MEMORY_RELAXED);
+            joystick.setButtonBytes(index, &value, 1);
+        }
+    }
+}
+
+uint16_t JoystickDeltaQueue::size() const {
+    uint16_t head = _head.load(JOYSTICK_MEMORY_ACQUIRE);
+    uint16_t tail = _tail.load(JOYSTICK_MEMORY_ACQUIRE);
+    return (uint16_t) (head - tail);
+}
+
+uint32_t JoystickDeltaQueue::getDroppedCount() const {
+    return _dropped.load(JOYSTICK_MEMORY_RELAXED);
+}
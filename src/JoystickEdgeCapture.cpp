@@ -0,0 +1,179 @@
+//
+// JoystickEdgeCapture.cpp
+//
+
+#include "JoystickEdgeCapture.h"
+
+#define JOYSTICK_EDGE_QUEUE_MASK (JOYSTICK_EDGE_QUEUE_SIZE - 1)
+
+static_assert((JOYSTICK_EDGE_QUEUE_SIZE & JOYSTICK_EDGE_QUEUE_MASK) == 0,
+              "JOYSTICK_EDGE_QUEUE_SIZE must be a power of two");
+static_assert(JOYSTICK_EDGE_QUEUE_SIZE <= 128, "JOYSTICK_EDGE_QUEUE_SIZE must fit the 8-bit indices");
+
+JoystickEdgeCapture::JoystickEdgeCapture(Joystick_ &joystick, JoystickClock clock)
+        : _joystick(joystick), _clock(clock) {}
+
+int8_t JoystickEdgeCapture::addInput(uint8_t pin, uint8_t button, bool activeLow) {
+    if (_inputCount >= JOYSTICK_EDGE_INPUT_MAXIMUM) return -1;
+
+    _pins[_inputCount] = pin;
+    _buttons[_inputCount] = button;
+    if (activeLow) {
+        _activeLow |= (uint32_t) 1 << _inputCount;
+    }
+    return (int8_t) _inputCount++;
+}
+
+void JoystickEdgeCapture::setDebounceTime(uint32_t debounceTime) {
+    _debounceTime = debounceTime;
+}
+
+void JoystickEdgeCapture::begin() {
+    uint32_t now = _clock();
+
+    _joystick.beginUpdate();
+    for (uint8_t input = 0; input < _inputCount; input++) {
+        uint32_t mask = (uint32_t) 1 << input;
+        pinMode(_pins[input], (_activeLow & mask) ? INPUT_PULLUP : INPUT);
+
+        bool pressed = (digitalRead(_pins[input]) == HIGH) != ((_activeLow & mask) != 0);
+        if (pressed) {
+            _rawStates |= mask;
+            _states |= mask;
+        }
+        _rawTimes[input] = now;
+        _changeTimes[input] = now - _debounceTime;
+        _joystick.setButton(_buttons[input], pressed);
+    }
+    _joystick.endUpdate();
+}
+
+void JoystickEdgeCapture::capture(uint8_t input) {
+    if (input >= _inputCount) return;
+
+    push(input, digitalRead(_pins[input]) == HIGH, _clock());
+}
+
+void JoystickEdgeCapture::capture(uint8_t input, bool level) {
+    if (input >= _inputCount) return;
+
+    push(input, level, _clock());
+}
+
+void JoystickEdgeCapture::captureInputs(uint32_t inputs, uint32_t levels) {
+    uint32_t time = _clock();
+
+    for (uint8_t input = 0; (input < _inputCount) && (inputs != 0); input++, inputs >>= 1, levels >>= 1) {
+        if (inputs & 1) {
+            push(input, levels & 1, time);
+        }
+    }
+}
+
+void JoystickEdgeCapture::push(uint8_t input, bool level, uint32_t time) {
+    uint8_t head = _head.load(JOYSTICK_MEMORY_RELAXED);
+    uint8_t tail = _tail.load(JOYSTICK_MEMORY_ACQUIRE);
+
+    if ((uint8_t) (head - tail) >= JOYSTICK_EDGE_QUEUE_SIZE) {
+        // update() reads the pin instead
+        _overflowInputs.fetchOr((uint32_t) 1 << input, JOYSTICK_MEMORY_RELAXED);
+        _overflowCount.fetchAdd(1, JOYSTICK_MEMORY_RELAXED);
+        return;
+    }
+
+    JoystickEdge &edge = _buffer[head & JOYSTICK_EDGE_QUEUE_MASK];
+    edge.time = time;
+    edge.input = input;
+    edge.level = level;
+    _head.store((uint8_t) (head + 1), JOYSTICK_MEMORY_RELEASE);
+}
+
+void JoystickEdgeCapture::record(uint8_t input, bool level, uint32_t time) {
+    uint32_t mask = (uint32_t) 1 << input;
+    bool pressed = level != ((_activeLow & mask) != 0);
+
+    if (pressed == ((_rawStates & mask) != 0)) return;
+
+    _rawStates ^= mask;
+    _rawTimes[input] = time;
+    _edgeCount++;
+}
+
+bool JoystickEdgeCapture::update() {
+    uint32_t changed = 0;
+    uint32_t oldest = 0;
+    uint32_t now = _clock();
+
+    uint8_t tail = _tail.load(JOYSTICK_MEMORY_RELAXED);
+    uint8_t head = _head.load(JOYSTICK_MEMORY_ACQUIRE);
+
+    // Edges in the order of their interrupts
+    while (tail != head) {
+        const JoystickEdge &edge = _buffer[tail & JOYSTICK_EDGE_QUEUE_MASK];
+        uint8_t input = edge.input;
+        uint32_t mask = (uint32_t) 1 << input;
+        bool accept = (joystickTimeDifference(edge.time, _changeTimes[input]) >= (int32_t) _debounceTime) &&
+                      ((edge.level != ((_activeLow & mask) != 0)) != ((_states & mask) != 0));
+
+        // A second change of the same input goes into the next report
+        if (accept && (changed & mask)) break;
+
+        record(input, edge.level, edge.time);
+        if (accept) {
+            _states ^= mask;
+            _changeTimes[input] = edge.time;
+            if (!changed || (joystickTimeDifference(edge.time, oldest) < 0)) oldest = edge.time;
+            changed |= mask;
+        }
+
+        tail++;
+    }
+    _tail.store(tail, JOYSTICK_MEMORY_RELEASE);
+
+    // Overflowed inputs only know their current level, which comes after
+    // every queued edge
+    uint32_t overflowInputs = (tail == head) ? _overflowInputs.exchange(0, JOYSTICK_MEMORY_RELAXED) : 0;
+    for (uint8_t input = 0; overflowInputs != 0; input++, overflowInputs >>= 1) {
+        if (overflowInputs & 1) {
+            record(input, digitalRead(_pins[input]) == HIGH, now);
+        }
+    }
+
+    // Inputs that ended up on a different level during their debounce time
+    uint32_t unsettled = (_rawStates ^ _states) & ~changed;
+    for (uint8_t input = 0; unsettled != 0; input++, unsettled >>= 1) {
+        if (!(unsettled & 1) || (joystickTimeDifference(now, _changeTimes[input]) < (int32_t) _debounceTime)) {
+            continue;
+        }
+
+        uint32_t mask = (uint32_t) 1 << input;
+        _states ^= mask;
+        _changeTimes[input] = now;
+        if (!changed || (joystickTimeDifference(_rawTimes[input], oldest) < 0)) oldest = _rawTimes[input];
+        changed |= mask;
+    }
+
+    if (changed == 0) return false;
+
+    _joystick.beginUpdate();
+    for (uint8_t input = 0; changed != 0; input++, changed >>= 1) {
+        if (changed & 1) {
+            _joystick.setButton(_buttons[input], (_states >> input) & 1);
+        }
+    }
+    _joystick.endUpdate();
+
+    _lastLatency = (uint32_t) joystickTimeDifference(_clock(), oldest);
+    if (_lastLatency > _maximumLatency) {
+        _maximumLatency = _lastLatency;
+    }
+    return true;
+}
+
+bool JoystickEdgeCapture::isPressed(uint8_t input) const {
+    return (input < _inputCount) && ((_states >> input) & 1);
+}
+
+uint32_t JoystickEdgeCapture::getOverflowCount() const {
+    return _overflowCount.load(JOYSTICK_MEMORY_RELAXED);
+}
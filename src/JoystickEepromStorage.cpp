@@ -0,0 +1,33 @@
+//
+// JoystickEepromStorage.cpp
+//
+
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "JoystickEepromStorage.h"
+
+bool JoystickEepromStorage::read(uint16_t address, uint8_t data[], uint16_t length) {
+    if ((uint32_t) address + length > EEPROM.length()) return false;
+
+    for (uint16_t index = 0; index < length; index++) {
+        data[index] = EEPROM.read(address + index);
+    }
+    return true;
+}
+
+bool JoystickEepromStorage::write(uint16_t address, const uint8_t data[], uint16_t length) {
+    if ((uint32_t) address + length > EEPROM.length()) return false;
+
+    for (uint16_t index = 0; index < length; index++) {
+        // Spare the cells that already hold the value
+        if (EEPROM.read(address + index) != data[index]) {
+            EEPROM.write(address + index, data[index]);
+        }
+    }
+
+#if defined(ARDUINO_ARCH_ESP8266) || defined(ARDUINO_ARCH_ESP32)
+    return EEPROM.commit();
+#else
+    return true;
+#endif
+}
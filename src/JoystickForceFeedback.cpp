@@ -0,0 +1,548 @@
+//
+// JoystickForceFeedback.cpp
+//
+
+#include "JoystickForceFeedback.h"
+#include "JoystickMath.h"
+
+#define FFB_BLOCK_INDEX(main) \
+        0x09, 0x22, 0x15, 0x01, 0x25, JOYSTICK_FFB_EFFECT_COUNT, 0x75, 0x08, 0x95, 0x01, main, 0x02
+#define FFB_EFFECT_TYPES \
+        0x09, 0x26, 0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x33, 0x09, 0x34, 0x09, 0x40, 0x09, 0x41, \
+        0x15, 0x01, 0x25, 0x08, 0x75, 0x08, 0x95, 0x01
+
+static const uint8_t forceFeedbackDescriptor[] = {
+        // USAGE_PAGE (Physical Interface)
+        0x05, 0x0F,
+
+        // PID State Report: paused, actuators enabled, effect playing, block index
+        0x09, 0x92, 0xA1, 0x02, 0x85, JOYSTICK_FFB_REPORT_ID + JOYSTICK_FFB_REPORT_STATE,
+        0x09, 0x9F, 0x09, 0xA0, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x02, 0x81, 0x02,
+        0x95, 0x06, 0x81, 0x03,
+        0x09, 0x94, 0x95, 0x01, 0x81, 0x02,
+        0x09, 0x22, 0x15, 0x01, 0x25, JOYSTICK_FFB_EFFECT_COUNT, 0x75, 0x07, 0x95, 0x01, 0x81, 0x02,
+        0xC0,
+
+        // Set Effect Report: block, type, duration, start delay, gain, axes
+        // and direction enable, direction
+        0x09, 0x21, 0xA1, 0x02, 0x85, JOYSTICK_FFB_REPORT_ID + JOYSTICK_FFB_REPORT_SET_EFFECT,
+        FFB_BLOCK_INDEX(0x91),
+        0x09, 0x25, 0xA1, 0x02, FFB_EFFECT_TYPES, 0x91, 0x00, 0xC0,
+        0x09, 0x50, 0x09, 0xA7, 0x15, 0x00, 0x27, 0xFF, 0xFF, 0x00, 0x00, 0x66, 0x03, 0x10, 0x55, 0x0D,
+        0x75, 0x10, 0x95, 0x02, 0x91, 0x02, 0x55, 0x00, 0x66, 0x00, 0x00,
+        0x09, 0x52, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x01, 0x91, 0x02,
+        0x09, 0x55, 0xA1, 0x02, 0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01,
+        0x95, 0x02, 0x91, 0x02, 0xC0,
+        0x05, 0x0F, 0x09, 0x56, 0x95, 0x01, 0x91, 0x02, 0x95, 0x05, 0x91, 0x03,
+        0x09, 0x57, 0xA1, 0x02, 0x0B, 0x01, 0x00, 0x0A, 0x00, 0x0B, 0x02, 0x00, 0x0A, 0x00,
+        0x26, 0xFF, 0x00, 0x35, 0x00, 0x46, 0x68, 0x01, 0x65, 0x14, 0x75, 0x08, 0x95, 0x02, 0x91, 0x02,
+        0x65, 0x00, 0x45, 0x00, 0xC0,
+        0xC0,
+
+        // Set Condition Report: block, axis, center, coefficients, saturations, dead band
+        0x09, 0x5F, 0xA1, 0x02, 0x85, JOYSTICK_FFB_REPORT_ID + JOYSTICK_FFB_REPORT_SET_CONDITION,
+        FFB_BLOCK_INDEX(0x91),
+        0x09, 0x23, 0x15, 0x00, 0x25, JOYSTICK_FFB_AXIS_COUNT - 1, 0x75, 0x08, 0x95, 0x01, 0x91, 0x02,
+        0x09, 0x60, 0x09, 0x61, 0x09, 0x62, 0x16, 0xF0, 0xD8, 0x26, 0x10, 0x27, 0x75, 0x10, 0x95, 0x03,
+        0x91, 0x02,
+        0x09, 0x63, 0x09, 0x64, 0x09, 0x65, 0x15, 0x00, 0x26, 0x10, 0x27, 0x95, 0x03, 0x91, 0x02,
+        0xC0,
+
+        // Set Periodic Report: block, magnitude, offset, phase, period
+        0x09, 0x6E, 0xA1, 0x02, 0x85, JOYSTICK_FFB_REPORT_ID + JOYSTICK_FFB_REPORT_SET_PERIODIC,
+        FFB_BLOCK_INDEX(0x91),
+        0x09, 0x70, 0x15, 0x00, 0x26, 0x10, 0x27, 0x75, 0x10, 0x95, 0x01, 0x91, 0x02,
+        0x09, 0x6F, 0x16, 0xF0, 0xD8, 0x91, 0x02,
+        0x09, 0x71, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x35, 0x00, 0x46, 0x68, 0x01, 0x65, 0x14, 0x75, 0x08,
+        0x91, 0x02, 0x65, 0x00, 0x45, 0x00,
+        0x09, 0x72, 0x27, 0xFF, 0xFF, 0x00, 0x00, 0x66, 0x03, 0x10, 0x55, 0x0D, 0x75, 0x10, 0x91, 0x02,
+        0x55, 0x00, 0x66, 0x00, 0x00,
+        0xC0,
+
+        // Set Constant Force Report: block, magnitude
+        0x09, 0x73, 0xA1, 0x02, 0x85, JOYSTICK_FFB_REPORT_ID + JOYSTICK_FFB_REPORT_SET_CONSTANT,
+        FFB_BLOCK_INDEX(0x91),
+        0x09, 0x70, 0x16, 0xF0, 0xD8, 0x26, 0x10, 0x27, 0x75, 0x10, 0x95, 0x01, 0x91, 0x02,
+        0xC0,
+
+        // Effect Operation Report: block, start/start solo/stop, loop count
+        0x09, 0x77, 0xA1, 0x02, 0x85, JOYSTICK_FFB_REPORT_ID + JOYSTICK_FFB_REPORT_EFFECT_OPERATION,
+        FFB_BLOCK_INDEX(0x91),
+        0x09, 0x78, 0xA1, 0x02, 0x09, 0x79, 0x09, 0x7A, 0x09, 0x7B, 0x15, 0x01, 0x25, 0x03, 0x91, 0x00, 0xC0,
+        0x09, 0x7C, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x91, 0x02,
+        0xC0,
+
+        // PID Block Free Report: block
+        0x09, 0x90, 0xA1, 0x02, 0x85, JOYSTICK_FFB_REPORT_ID + JOYSTICK_FFB_REPORT_BLOCK_FREE,
+        FFB_BLOCK_INDEX(0x91),
+        0xC0,
+
+        // PID Device Control Report
+        0x09, 0x96, 0xA1, 0x02, 0x85, JOYSTICK_FFB_REPORT_ID + JOYSTICK_FFB_REPORT_DEVICE_CONTROL,
+        0x09, 0x97, 0x09, 0x98, 0x09, 0x99, 0x09, 0x9A, 0x09, 0x9B, 0x09, 0x9C,
+        0x15, 0x01, 0x25, 0x06, 0x75, 0x08, 0x95, 0x01, 0x91, 0x00,
+        0xC0,
+
+        // Device Gain Report
+        0x09, 0x7D, 0xA1, 0x02, 0x85, JOYSTICK_FFB_REPORT_ID + JOYSTICK_FFB_REPORT_DEVICE_GAIN,
+        0x09, 0x7E, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x01, 0x91, 0x02,
+        0xC0,
+
+        // Create New Effect Report (feature): type, byte count
+        0x09, 0xAB, 0xA1, 0x02, 0x85, JOYSTICK_FFB_REPORT_ID + JOYSTICK_FFB_REPORT_CREATE_EFFECT,
+        0x09, 0x25, 0xA1, 0x02, FFB_EFFECT_TYPES, 0xB1, 0x00, 0xC0,
+        0x05, 0x01, 0x09, 0x3B, 0x15, 0x00, 0x27, 0xFF, 0xFF, 0x00, 0x00, 0x75, 0x10, 0x95, 0x01, 0xB1, 0x02,
+        0x05, 0x0F,
+        0xC0,
+
+        // PID Block Load Report (feature): block, status, RAM pool available
+        0x09, 0x89, 0xA1, 0x02, 0x85, JOYSTICK_FFB_REPORT_ID + JOYSTICK_FFB_REPORT_BLOCK_LOAD,
+        FFB_BLOCK_INDEX(0xB1),
+        0x09, 0x8B, 0xA1, 0x02, 0x09, 0x8C, 0x09, 0x8D, 0x09, 0x8E, 0x25, 0x03, 0xB1, 0x00, 0xC0,
+        0x09, 0xAC, 0x15, 0x00, 0x27, 0xFF, 0xFF, 0x00, 0x00, 0x75, 0x10, 0xB1, 0x02,
+        0xC0,
+
+        // PID Pool Report (feature): RAM pool size, simultaneous effects,
+        // device managed pool, shared parameter blocks
+        0x09, 0x7F, 0xA1, 0x02, 0x85, JOYSTICK_FFB_REPORT_ID + JOYSTICK_FFB_REPORT_POOL,
+        0x09, 0x80, 0x15, 0x00, 0x27, 0xFF, 0xFF, 0x00, 0x00, 0x75, 0x10, 0x95, 0x01, 0xB1, 0x02,
+        0x09, 0x83, 0x26, 0xFF, 0x00, 0x75, 0x08, 0xB1, 0x02,
+        0x09, 0xA9, 0x09, 0xAA, 0x25, 0x01, 0x75, 0x01, 0x95, 0x02, 0xB1, 0x02, 0x95, 0x06, 0xB1, 0x03,
+        0xC0,
+
+        // END_COLLECTION (Application, left open by the joystick)
+        0xC0
+};
+
+// Device control values in descriptor order
+#define FFB_CONTROL_ENABLE_ACTUATORS  1
+#define FFB_CONTROL_DISABLE_ACTUATORS 2
+#define FFB_CONTROL_STOP_ALL          3
+#define FFB_CONTROL_RESET             4
+#define FFB_CONTROL_PAUSE             5
+#define FFB_CONTROL_CONTINUE          6
+
+#define FFB_OPERATION_START      1
+#define FFB_OPERATION_START_SOLO 2
+#define FFB_OPERATION_STOP       3
+
+#define FFB_BLOCK_LOAD_SUCCESS 1
+#define FFB_BLOCK_LOAD_FULL    2
+#define FFB_BLOCK_LOAD_ERROR   3
+
+static inline uint16_t readUInt16(const uint8_t data[]) {
+    return (uint16_t) (data[0] | (data[1] << 8));
+}
+
+static inline int16_t readInt16(const uint8_t data[]) {
+    return (int16_t) readUInt16(data);
+}
+
+static inline void writeUInt16(uint8_t data[], uint16_t value) {
+    data[0] = (uint8_t) (value & 0x00FF);
+    data[1] = (uint8_t) (value >> 8);
+}
+
+static inline int32_t clampForce(int32_t force) {
+    if (force > JOYSTICK_FFB_FORCE_MAXIMUM) return JOYSTICK_FFB_FORCE_MAXIMUM;
+    if (force < -JOYSTICK_FFB_FORCE_MAXIMUM) return -JOYSTICK_FFB_FORCE_MAXIMUM;
+    return force;
+}
+
+JoystickForceFeedback::JoystickForceFeedback(Joystick_ &joystick)
+        : _joystick(joystick), _hidSubDescriptor(forceFeedbackDescriptor, sizeof(forceFeedbackDescriptor)) {
+    for (uint8_t index = 0; index < JOYSTICK_FFB_EFFECT_COUNT; index++) {
+        _effects[index].type = JOYSTICK_EFFECT_NONE;
+        _effects[index].playing = false;
+    }
+
+    HID().AppendDescriptor(&_hidSubDescriptor);
+}
+
+void JoystickForceFeedback::setAxes(JoystickField firstAxis, JoystickField secondAxis) {
+    _axes[0] = firstAxis;
+    _axes[1] = secondAxis;
+}
+
+JoystickEffect *JoystickForceFeedback::effectAt(uint8_t blockIndex) {
+    if ((blockIndex < 1) || (blockIndex > JOYSTICK_FFB_EFFECT_COUNT)) return nullptr;
+    return &_effects[blockIndex - 1];
+}
+
+const uint8_t *JoystickForceFeedback::getDescriptor() const {
+    return forceFeedbackDescriptor;
+}
+
+uint16_t JoystickForceFeedback::getDescriptorSize() const {
+    return sizeof(forceFeedbackDescriptor);
+}
+
+const JoystickEffect *JoystickForceFeedback::getEffect(uint8_t blockIndex) const {
+    if ((blockIndex < 1) || (blockIndex > JOYSTICK_FFB_EFFECT_COUNT)) return nullptr;
+    return &_effects[blockIndex - 1];
+}
+
+uint8_t JoystickForceFeedback::freeBlockCount() const {
+    uint8_t count = 0;
+    for (uint8_t index = 0; index < JOYSTICK_FFB_EFFECT_COUNT; index++) {
+        if (_effects[index].type == JOYSTICK_EFFECT_NONE) count++;
+    }
+    return count;
+}
+
+void JoystickForceFeedback::createEffect(uint8_t type) {
+    _lastBlockIndex = 0;
+
+    if ((type < JOYSTICK_EFFECT_CONSTANT) || (type > JOYSTICK_EFFECT_DAMPER)) {
+        _blockLoadStatus = FFB_BLOCK_LOAD_ERROR;
+        return;
+    }
+
+    for (uint8_t index = 0; index < JOYSTICK_FFB_EFFECT_COUNT; index++) {
+        JoystickEffect &effect = _effects[index];
+        if (effect.type != JOYSTICK_EFFECT_NONE) continue;
+
+        memset(&effect, 0, sizeof(effect));
+        effect.type = type;
+        effect.gain = 255;
+        effect.duration = JOYSTICK_FFB_DURATION_INFINITE;
+        effect.axesEnable = 0x01;
+        effect.loopCount = 1;
+
+        _lastBlockIndex = index + 1;
+        _blockLoadStatus = FFB_BLOCK_LOAD_SUCCESS;
+        return;
+    }
+
+    _blockLoadStatus = FFB_BLOCK_LOAD_FULL;
+}
+
+void JoystickForceFeedback::freeEffect(uint8_t blockIndex) {
+    JoystickEffect *effect = effectAt(blockIndex);
+    if (effect == nullptr) return;
+
+    effect->type = JOYSTICK_EFFECT_NONE;
+    effect->playing = false;
+}
+
+void JoystickForceFeedback::startEffect(uint8_t blockIndex, uint8_t loopCount, bool solo) {
+    JoystickEffect *effect = effectAt(blockIndex);
+    if ((effect == nullptr) || (effect->type == JOYSTICK_EFFECT_NONE)) return;
+
+    if (solo) {
+        for (uint8_t index = 0; index < JOYSTICK_FFB_EFFECT_COUNT; index++) {
+            _effects[index].playing = false;
+        }
+    }
+
+    effect->playing = true;
+    effect->elapsed = 0;
+    effect->loopCount = (loopCount == 0) ? 1 : loopCount;
+}
+
+void JoystickForceFeedback::deviceControl(uint8_t control) {
+    switch (control) {
+        case FFB_CONTROL_ENABLE_ACTUATORS:
+            _actuatorsEnabled = true;
+            break;
+        case FFB_CONTROL_DISABLE_ACTUATORS:
+            _actuatorsEnabled = false;
+            break;
+        case FFB_CONTROL_STOP_ALL:
+            for (uint8_t index = 0; index < JOYSTICK_FFB_EFFECT_COUNT; index++) {
+                _effects[index].playing = false;
+            }
+            break;
+        case FFB_CONTROL_RESET:
+            for (uint8_t index = 0; index < JOYSTICK_FFB_EFFECT_COUNT; index++) {
+                _effects[index].type = JOYSTICK_EFFECT_NONE;
+                _effects[index].playing = false;
+            }
+            _actuatorsEnabled = true;
+            _paused = false;
+            _deviceGain = 255;
+            break;
+        case FFB_CONTROL_PAUSE:
+            _paused = true;
+            break;
+        case FFB_CONTROL_CONTINUE:
+            _paused = false;
+            break;
+        default:
+            break;
+    }
+}
+
+bool JoystickForceFeedback::handleOutputReport(uint8_t reportId, const uint8_t data[], uint8_t length) {
+    uint8_t report = reportId - JOYSTICK_FFB_REPORT_ID;
+    JoystickEffect *effect;
+
+    switch (report) {
+        case JOYSTICK_FFB_REPORT_SET_EFFECT:
+            if (length < 10) return true;
+            effect = effectAt(data[0]);
+            if (effect == nullptr) return true;
+
+            if (effect->type == JOYSTICK_EFFECT_NONE) {
+                // Host skipped Create New Effect, take the block anyway
+                memset(effect, 0, sizeof(*effect));
+                effect->loopCount = 1;
+            }
+            if ((data[1] >= JOYSTICK_EFFECT_CONSTANT) && (data[1] <= JOYSTICK_EFFECT_DAMPER)) {
+                effect->type = data[1];
+            }
+            effect->duration = readUInt16(&data[2]);
+            effect->startDelay = readUInt16(&data[4]);
+            effect->gain = data[6];
+            effect->axesEnable = data[7] & 0x03;
+            effect->directionEnable = (data[7] & 0x04) != 0;
+            effect->direction = data[8];
+            return true;
+
+        case JOYSTICK_FFB_REPORT_SET_CONDITION:
+            if (length < 14) return true;
+            effect = effectAt(data[0]);
+            if ((effect == nullptr) || (data[1] >= JOYSTICK_FFB_AXIS_COUNT)) return true;
+
+            effect->conditions[data[1]].centerOffset = readInt16(&data[2]);
+            effect->conditions[data[1]].positiveCoefficient = readInt16(&data[4]);
+            effect->conditions[data[1]].negativeCoefficient = readInt16(&data[6]);
+            effect->conditions[data[1]].positiveSaturation = readUInt16(&data[8]);
+            effect->conditions[data[1]].negativeSaturation = readUInt16(&data[10]);
+            effect->conditions[data[1]].deadBand = readUInt16(&data[12]);
+            effect->conditionMask |= (uint8_t) (1 << data[1]);
+            return true;
+
+        case JOYSTICK_FFB_REPORT_SET_PERIODIC:
+            if (length < 8) return true;
+            effect = effectAt(data[0]);
+            if (effect == nullptr) return true;
+
+            effect->magnitude = readInt16(&data[1]);
+            effect->offset = readInt16(&data[3]);
+            effect->phase = data[5];
+            effect->period = readUInt16(&data[6]);
+            return true;
+
+        case JOYSTICK_FFB_REPORT_SET_CONSTANT:
+            if (length < 3) return true;
+            effect = effectAt(data[0]);
+            if (effect == nullptr) return true;
+
+            effect->magnitude = readInt16(&data[1]);
+            return true;
+
+        case JOYSTICK_FFB_REPORT_EFFECT_OPERATION:
+            if (length < 3) return true;
+            if (data[1] == FFB_OPERATION_STOP) {
+                effect = effectAt(data[0]);
+                if (effect != nullptr) effect->playing = false;
+            } else {
+                startEffect(data[0], data[2], data[1] == FFB_OPERATION_START_SOLO);
+            }
+            return true;
+
+        case JOYSTICK_FFB_REPORT_BLOCK_FREE:
+            if (length < 1) return true;
+            freeEffect(data[0]);
+            return true;
+
+        case JOYSTICK_FFB_REPORT_DEVICE_CONTROL:
+            if (length < 1) return true;
+            deviceControl(data[0]);
+            return true;
+
+        case JOYSTICK_FFB_REPORT_DEVICE_GAIN:
+            if (length < 1) return true;
+            _deviceGain = data[0];
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+bool JoystickForceFeedback::handleFeatureReport(uint8_t reportId, const uint8_t data[], uint8_t length) {
+    if ((uint8_t) (reportId - JOYSTICK_FFB_REPORT_ID) != JOYSTICK_FFB_REPORT_CREATE_EFFECT) return false;
+    if (length < 1) return true;
+
+    createEffect(data[0]);
+    return true;
+}
+
+uint8_t JoystickForceFeedback::getFeatureReport(uint8_t reportId, uint8_t data[], uint8_t length) const {
+    uint16_t poolSize = JOYSTICK_FFB_EFFECT_COUNT * sizeof(JoystickEffect);
+
+    switch ((uint8_t) (reportId - JOYSTICK_FFB_REPORT_ID)) {
+        case JOYSTICK_FFB_REPORT_BLOCK_LOAD:
+            if (length < 4) return 0;
+            data[0] = _lastBlockIndex;
+            data[1] = _blockLoadStatus;
+            writeUInt16(&data[2], (uint16_t) (freeBlockCount() * sizeof(JoystickEffect)));
+            return 4;
+
+        case JOYSTICK_FFB_REPORT_POOL:
+            if (length < 4) return 0;
+            writeUInt16(&data[0], poolSize);
+            data[2] = JOYSTICK_FFB_EFFECT_COUNT;
+            // Device managed pool, no shared parameter blocks
+            data[3] = 0x01;
+            return 4;
+
+        default:
+            return 0;
+    }
+}
+
+void JoystickForceFeedback::buildStateReport(uint8_t data[]) const {
+    uint8_t playingBlock = 0;
+
+    for (uint8_t index = 0; index < JOYSTICK_FFB_EFFECT_COUNT; index++) {
+        if (_effects[index].playing) {
+            playingBlock = index + 1;
+            break;
+        }
+    }
+
+    data[0] = (uint8_t) ((_paused ? 0x01 : 0) | (_actuatorsEnabled ? 0x02 : 0));
+    data[1] = (uint8_t) ((playingBlock > 0 ? 0x01 : 0) | (playingBlock << 1));
+}
+
+void JoystickForceFeedback::sendState() {
+    uint8_t data[2];
+    buildStateReport(data);
+    HID().SendReport(JOYSTICK_FFB_REPORT_ID + JOYSTICK_FFB_REPORT_STATE, data, sizeof(data));
+}
+
+void JoystickForceFeedback::updateAxes() {
+    for (uint8_t axis = 0; axis < JOYSTICK_FFB_AXIS_COUNT; axis++) {
+        int32_t position = 0;
+        if (_axes[axis] <= JOYSTICK_FIELD_RZ_AXIS) {
+            position = (_joystick.getAxisPosition(_axes[axis]) * JOYSTICK_FFB_FORCE_MAXIMUM) / JOYSTICK_RADIAL_MAXIMUM;
+        }
+
+        _velocities[axis] = (int16_t) clampForce((position - _positions[axis]) * JOYSTICK_FFB_VELOCITY_SCALE);
+        _positions[axis] = (int16_t) position;
+    }
+}
+
+int32_t JoystickForceFeedback::conditionForce(const JoystickEffect &effect, uint8_t axis) const {
+    // Without a condition for this axis the first one applies to all axes
+    const JoystickEffectCondition &condition =
+            (effect.conditionMask & (1 << axis)) ? effect.conditions[axis] : effect.conditions[0];
+    int32_t metric = (effect.type == JOYSTICK_EFFECT_SPRING) ? _positions[axis] : _velocities[axis];
+    int32_t center = condition.centerOffset;
+    int32_t deadBand = condition.deadBand;
+    int32_t saturation;
+    int32_t force;
+
+    // Spring and damper push back towards the center
+    if (metric > center + deadBand) {
+        force = -((metric - (center + deadBand)) * condition.positiveCoefficient) / JOYSTICK_FFB_FORCE_MAXIMUM;
+        saturation = condition.positiveSaturation;
+    } else if (metric < center - deadBand) {
+        force = -((metric - (center - deadBand)) * condition.negativeCoefficient) / JOYSTICK_FFB_FORCE_MAXIMUM;
+        saturation = condition.negativeSaturation;
+    } else {
+        return 0;
+    }
+
+    if (force > saturation) return saturation;
+    if (force < -saturation) return -saturation;
+    return force;
+}
+
+int32_t JoystickForceFeedback::periodicValue(const JoystickEffect &effect, uint32_t activeTime) const {
+    uint16_t period = (effect.period == 0) ? 1 : effect.period;
+    uint16_t angle = (uint16_t) (((uint16_t) effect.phase << 8) + (((activeTime % period) << 16) / period));
+    int32_t wave;
+
+    switch (effect.type) {
+        case JOYSTICK_EFFECT_SQUARE:
+            wave = (angle < 32768) ? 32767 : -32767;
+            break;
+        case JOYSTICK_EFFECT_TRIANGLE:
+            if (angle < 16384) {
+                wave = 2 * (int32_t) angle;
+            } else if (angle < 49152) {
+                wave = 65536 - 2 * (int32_t) angle;
+            } else {
+                wave = 2 * (int32_t) angle - 131072;
+            }
+            break;
+        case JOYSTICK_EFFECT_SAWTOOTH_UP:
+            wave = (int32_t) angle - 32768;
+            break;
+        case JOYSTICK_EFFECT_SAWTOOTH_DOWN:
+            wave = 32767 - (int32_t) angle;
+            break;
+        default:
+            wave = joystickSin(angle);
+            break;
+    }
+
+    if (wave > 32767) wave = 32767;
+    if (wave < -32767) wave = -32767;
+
+    return effect.offset + (effect.magnitude * wave) / 32767;
+}
+
+void JoystickForceFeedback::tick() {
+    int32_t forces[JOYSTICK_FFB_AXIS_COUNT] = {0, 0};
+
+    updateAxes();
+
+    for (uint8_t index = 0; index < JOYSTICK_FFB_EFFECT_COUNT; index++) {
+        JoystickEffect &effect = _effects[index];
+
+        // A paused device freezes every effect and outputs no force
+        if (!effect.playing || _paused) continue;
+
+        if (effect.elapsed < effect.startDelay) {
+            effect.elapsed++;
+            continue;
+        }
+
+        uint32_t activeTime = effect.elapsed - effect.startDelay;
+        if ((effect.duration != JOYSTICK_FFB_DURATION_INFINITE) && (activeTime >= effect.duration)) {
+            if ((effect.loopCount != JOYSTICK_FFB_LOOP_INFINITE) && (--effect.loopCount == 0)) {
+                effect.playing = false;
+                continue;
+            }
+            effect.elapsed = effect.startDelay;
+            activeTime = 0;
+        }
+
+        if ((effect.type == JOYSTICK_EFFECT_SPRING) || (effect.type == JOYSTICK_EFFECT_DAMPER)) {
+            // Conditions act on each enabled axis separately
+            for (uint8_t axis = 0; axis < JOYSTICK_FFB_AXIS_COUNT; axis++) {
+                if (!(effect.axesEnable & (1 << axis)) && !effect.directionEnable) continue;
+                forces[axis] += (conditionForce(effect, axis) * effect.gain) / 255;
+            }
+        } else {
+            int32_t force = (effect.type == JOYSTICK_EFFECT_CONSTANT) ? effect.magnitude
+                                                                      : periodicValue(effect, activeTime);
+            force = (force * effect.gain) / 255;
+
+            if (effect.directionEnable) {
+                uint16_t angle = (uint16_t) ((uint16_t) effect.direction << 8);
+                forces[0] -= (force * joystickSin(angle)) / 32767;
+                forces[1] += (force * joystickCos(angle)) / 32767;
+            } else {
+                for (uint8_t axis = 0; axis < JOYSTICK_FFB_AXIS_COUNT; axis++) {
+                    if (effect.axesEnable & (1 << axis)) forces[axis] += force;
+                }
+            }
+        }
+
+        effect.elapsed++;
+    }
+
+    for (uint8_t axis = 0; axis < JOYSTICK_FFB_AXIS_COUNT; axis++) {
+        int32_t force = 0;
+        if (_actuatorsEnabled && !_paused && (_axes[axis] != JOYSTICK_FIELD_COUNT)) {
+            force = (clampForce(forces[axis]) * _deviceGain) / 255;
+        }
+        _forces[axis] = (int16_t) force;
+    }
+}
@@ -0,0 +1,140 @@
+//
+// JoystickFrameSync.cpp
+//
+
+#include "JoystickFrameSync.h"
+
+JoystickFrameSync::JoystickFrameSync(Joystick_ &joystick, JoystickClock clock)
+        : _joystick(joystick), _clock(clock) {}
+
+void JoystickFrameSync::setPollInterval(uint32_t pollInterval) {
+    if (pollInterval == 0) return;
+    _pollInterval = pollInterval;
+}
+
+void JoystickFrameSync::setLeadTime(uint32_t leadTime) {
+    _leadTime = leadTime;
+}
+
+void JoystickFrameSync::setSampleCallback(JoystickSampleCallback sampleCallback) {
+    _sampleCallback = sampleCallback;
+}
+
+void JoystickFrameSync::pollObserved() {
+    uint32_t timestamp = _clock();
+
+    if (!_hostEventPending) {
+        _firstHostEvent = timestamp;
+    }
+    _lastHostEvent = timestamp;
+    _hostEventPending = true;
+}
+
+void JoystickFrameSync::takeHostEvents() {
+    // The timestamps are not atomic on 8-bit targets
+    noInterrupts();
+    bool pending = _hostEventPending;
+    uint32_t firstEvent = _firstHostEvent;
+    uint32_t lastEvent = _lastHostEvent;
+    _hostEventPending = false;
+    interrupts();
+
+    if (!pending) return;
+
+    if (_samplePending && joystickTimeDifference(firstEvent, _sampleTime) >= 0) {
+        // The first poll after sampling took the report built for it
+        recordPhase(joystickTimeDifference(firstEvent, _sampleTime));
+        _samplePending = false;
+    }
+
+    _anchor = lastEvent;
+    _anchorValid = true;
+    _anchorFromHost = true;
+}
+
+uint32_t JoystickFrameSync::getNextPoll() const {
+    uint32_t now = _clock();
+    if (!_anchorValid) return now;
+
+    int32_t elapsed = joystickTimeDifference(now, _anchor);
+    if (elapsed < 0) return _anchor;
+
+    uint32_t periods = ((uint32_t) elapsed / _pollInterval) + 1;
+    return _anchor + periods * _pollInterval;
+}
+
+bool JoystickFrameSync::update() {
+    takeHostEvents();
+
+    uint32_t now = _clock();
+    uint32_t nextPoll = getNextPoll();
+
+    if (_anchorValid) {
+        if (joystickTimeDifference(nextPoll, now) > (int32_t) _leadTime) return false;
+        if (_targetSampled && _sampleTarget == nextPoll) return false;
+    }
+
+    if (_sampleCallback != nullptr) {
+        _sampleCallback(_joystick);
+    }
+    _joystick.sendState();
+
+    uint32_t done = _clock();
+    _lastSampleDuration = (uint32_t) joystickTimeDifference(done, now);
+    _sampleTime = now;
+    _sampleTarget = nextPoll;
+    _targetSampled = true;
+
+    if (_anchorFromHost) {
+        // Phase is measured when the host hook reports the poll
+        _samplePending = true;
+    } else {
+        if (!_anchorValid || _lastSampleDuration > _leadTime) {
+            // A send that blocked for longer than the lead time waited for the
+            // host to free the endpoint, so its completion marks a poll.
+            _anchor = done;
+            _anchorValid = true;
+            _sampleTarget = done;
+        }
+        recordPhase(joystickTimeDifference(_sampleTarget, now));
+    }
+
+    return true;
+}
+
+void JoystickFrameSync::recordPhase(int32_t phase) {
+    if (_phaseCount == 0 || phase < _minimumPhase) _minimumPhase = phase;
+    if (_phaseCount == 0 || phase > _maximumPhase) _maximumPhase = phase;
+    _lastPhase = phase;
+    _phaseSum += phase;
+    _phaseCount++;
+}
+
+int32_t JoystickFrameSync::getLastPhase() const {
+    return _lastPhase;
+}
+
+int32_t JoystickFrameSync::getMinimumPhase() const {
+    return _minimumPhase;
+}
+
+int32_t JoystickFrameSync::getMaximumPhase() const {
+    return _maximumPhase;
+}
+
+int32_t JoystickFrameSync::getAveragePhase() const {
+    if (_phaseCount == 0) return 0;
+    return (int32_t) (_phaseSum / _phaseCount);
+}
+
+uint32_t JoystickFrameSync::getLastSampleDuration() const {
+    return _lastSampleDuration;
+}
+
+void JoystickFrameSync::resetStatistics() {
+    _lastPhase = 0;
+    _minimumPhase = 0;
+    _maximumPhase = 0;
+    _phaseSum = 0;
+    _phaseCount = 0;
+}
@@ -0,0 +1,202 @@
+//
+// JoystickGroup.cpp
+//
+
+#include "JoystickGroup.h"
+
+JoystickGroup::JoystickGroup(uint8_t reportsPerFrame, uint32_t frameLength, JoystickClock clock)
+        : _reportsPerFrame(reportsPerFrame > 0 ? reportsPerFrame : 1), _frameLength(frameLength), _clock(clock) {
+    _frameStart = _clock() - _frameLength;
+    for (uint16_t &waitFrames: _waitFrames) {
+        waitFrames = 0;
+    }
+    resetStatistics();
+}
+
+int8_t JoystickGroup::add(Joystick_ &joystick) {
+    if (_count >= JOYSTICK_GROUP_MAXIMUM) return -1;
+
+    _joysticks[_count] = &joystick;
+    _count++;
+    clampBudgetBurst();
+    return (int8_t) (_count - 1);
+}
+
+uint8_t JoystickGroup::getCount() const {
+    return _count;
+}
+
+Joystick_ &JoystickGroup::get(uint8_t index) {
+    return *_joysticks[index];
+}
+
+void JoystickGroup::setReportsPerFrame(uint8_t reportsPerFrame) {
+    _reportsPerFrame = (reportsPerFrame > 0) ? reportsPerFrame : 1;
+}
+
+void JoystickGroup::setBandwidthBudget(uint16_t bytesPerMillisecond, uint16_t burst) {
+    _budgetRate = bytesPerMillisecond;
+    _budgetBurst = burst;
+    clampBudgetBurst();
+    _budgetTokens = _budgetBurst;
+    _budgetTime = _clock();
+}
+
+void JoystickGroup::clampBudgetBurst() {
+    if (_budgetRate == 0) return;
+
+    // A smaller burst could never pay for an analog-only report of the
+    // largest controller, which would then wait forever
+    for (uint8_t index = 0; index < _count; index++) {
+        uint16_t transferSize = 1 + _joysticks[index]->getReportSize();
+        if (_budgetBurst < transferSize) {
+            _budgetBurst = transferSize;
+        }
+    }
+}
+
+uint32_t JoystickGroup::getDeferredCount() const {
+    return _deferredCount;
+}
+
+uint32_t JoystickGroup::getBudgetDeferredCount() const {
+    return _budgetDeferredCount;
+}
+
+void JoystickGroup::refillBudget() {
+    if (_budgetRate == 0) return;
+
+    uint32_t now = _clock();
+    uint32_t elapsed = (uint32_t) joystickTimeDifference(now, _budgetTime);
+    if (elapsed > 1000000UL) {
+        // Idle for long enough to have saved up a full burst
+        _budgetTokens = _budgetBurst;
+        _budgetTime = now;
+        return;
+    }
+
+    uint32_t tokens = (elapsed * _budgetRate) / 1000;
+    if (tokens == 0) return;
+
+    // Only advance by the time that produced whole tokens
+    _budgetTime += (tokens * 1000) / _budgetRate;
+    _budgetTokens += (int32_t) tokens;
+    if (_budgetTokens > _budgetBurst) {
+        _budgetTokens = _budgetBurst;
+    }
+}
+
+void JoystickGroup::markDirty(uint8_t index) {
+    if (index >= _count) return;
+    _forcedMask |= (1 << index);
+}
+
+uint8_t JoystickGroup::getDirtyMask() const {
+    return _dirtyMask;
+}
+
+bool JoystickGroup::startFrame() {
+    uint32_t now = _clock();
+    if (joystickTimeDifference(now, _frameStart) < (int32_t) _frameLength) return false;
+
+    // Skip frames that were missed entirely instead of bursting to catch up
+    _frameStart += _frameLength;
+    if (joystickTimeDifference(now, _frameStart) >= (int32_t) _frameLength) {
+        _frameStart = now;
+    }
+    return true;
+}
+
+void JoystickGroup::collectDirty() {
+    _dirtyMask = _forcedMask;
+    _digitalMask = 0;
+    for (uint8_t index = 0; index < _count; index++) {
+        uint16_t pendingFields = _joysticks[index]->getPendingFields();
+        if (pendingFields != 0) {
+            _dirtyMask |= (1 << index);
+        }
+        if (pendingFields & JOYSTICK_FIELD_MASK_DIGITAL) {
+            _digitalMask |= (1 << index);
+        }
+    }
+}
+
+void JoystickGroup::sendController(uint8_t index) {
+    _joysticks[index]->sendState();
+    _dirtyMask &= ~(1 << index);
+    _digitalMask &= ~(1 << index);
+    _forcedMask &= ~(1 << index);
+
+    if (_budgetRate != 0) {
+        // Report ID plus payload
+        _budgetTokens -= 1 + _joysticks[index]->getReportSize();
+    }
+    _waitFrames[index] = 0;
+}
+
+uint8_t JoystickGroup::update() {
+    if (!startFrame()) return 0;
+
+    collectDirty();
+
+    refillBudget();
+
+    // Button and hat edges first, then analog-only changes within the budget
+    uint8_t sent = sendPass(_digitalMask, _reportsPerFrame, false);
+    sent += sendPass(_dirtyMask, _reportsPerFrame - sent, _budgetRate != 0);
+
+    if (_dirtyMask & ~_digitalMask) {
+        _deferredCount++;
+    }
+
+    // Account the frame to everyone still waiting
+    for (uint8_t index = 0; index < _count; index++) {
+        if (!(_dirtyMask & (1 << index))) continue;
+
+        _waitFrames[index]++;
+        if (_waitFrames[index] > _maximumWait[index]) {
+            _maximumWait[index] = _waitFrames[index];
+        }
+    }
+
+    return sent;
+}
+
+uint8_t JoystickGroup::sendPass(uint8_t candidates, uint8_t limit, bool budgeted) {
+    uint8_t sent = 0;
+    uint8_t start = _next;
+    uint8_t last = 0;
+
+    for (uint8_t step = 0; (step < _count) && (sent < limit) && (candidates != 0); step++) {
+        uint8_t index = (start + step) % _count;
+        if (!(candidates & (1 << index))) continue;
+
+        if (budgeted && (_budgetTokens < (int32_t) (1 + _joysticks[index]->getReportSize()))) {
+            _budgetDeferredCount++;
+            break;
+        }
+
+        sendController(index);
+        candidates &= ~(1 << index);
+        last = index;
+        sent++;
+    }
+
+    // The next pass starts after the last controller sent
+    if (sent > 0) {
+        _next = (last + 1) % _count;
+    }
+
+    return sent;
+}
+
+uint16_t JoystickGroup::getMaximumWait(uint8_t index) const {
+    if (index >= _count) return 0;
+    return _maximumWait[index];
+}
+
+void JoystickGroup::resetStatistics() {
+    for (uint16_t &maximumWait: _maximumWait) {
+        maximumWait = 0;
+    }
+}
@@ -0,0 +1,122 @@
+//
+// JoystickIdleManager.cpp
+//
+
+#include "JoystickIdleManager.h"
+
+#if defined(ARDUINO_ARCH_AVR)
+#include <avr/sleep.h>
+#endif
+
+JoystickIdleManager::JoystickIdleManager(Joystick_ &joystick, JoystickClock clock)
+        : _joystick(joystick), _clock(clock) {}
+
+void JoystickIdleManager::setScanCallback(JoystickScanCallback scanCallback) {
+    _scanCallback = scanCallback;
+}
+
+void JoystickIdleManager::setSleepCallback(JoystickSleepCallback sleepCallback) {
+    _sleepCallback = sleepCallback;
+}
+
+void JoystickIdleManager::setActiveInterval(uint32_t activeInterval) {
+    _activeInterval = activeInterval;
+}
+
+void JoystickIdleManager::setIdleInterval(uint32_t idleInterval) {
+    _idleInterval = idleInterval;
+}
+
+void JoystickIdleManager::setIdleTimeout(uint32_t idleTimeout) {
+    _idleTimeout = idleTimeout;
+}
+
+void JoystickIdleManager::wake() {
+    if (!_wakeRequested) {
+        // Latency counts from the first edge
+        _wakeTime = _clock();
+        _wakeRequested = true;
+    }
+}
+
+bool JoystickIdleManager::scan(uint32_t now) {
+    _lastScan = now;
+    _scanCount++;
+
+    if (_scanCallback != nullptr) {
+        _scanCallback(_joystick);
+    }
+
+    if (_joystick.getPendingFields() == 0) return false;
+
+    _joystick.sendState();
+    _lastActivity = now;
+    _idle = false;
+    return true;
+}
+
+bool JoystickIdleManager::update() {
+    uint32_t now = _clock();
+
+    if (!_started) {
+        _started = true;
+        _lastActivity = now;
+        return scan(now);
+    }
+
+    if (_wakeRequested) {
+        // A 32-bit read is not atomic on AVR
+        noInterrupts();
+        uint32_t wakeTime = _wakeTime;
+        _wakeRequested = false;
+        interrupts();
+
+        // Back to full rate right away, the edge is reported by this scan
+        _idle = false;
+        _lastActivity = now;
+        bool sent = scan(now);
+
+        _lastWakeLatency = (uint32_t) joystickTimeDifference(_clock(), wakeTime);
+        if (_lastWakeLatency > _maximumWakeLatency) {
+            _maximumWakeLatency = _lastWakeLatency;
+        }
+        return sent;
+    }
+
+    if (!_idle && (joystickTimeDifference(now, _lastActivity) >= (int32_t) _idleTimeout)) {
+        _idle = true;
+    }
+
+    uint32_t interval = _idle ? _idleInterval : _activeInterval;
+    uint32_t sleep = JOYSTICK_IDLE_SLEEP_FOREVER;
+
+    if (interval != 0) {
+        int32_t remaining = (int32_t) interval - joystickTimeDifference(now, _lastScan);
+        if (remaining <= 0) return scan(now);
+        sleep = (uint32_t) remaining;
+    } else if (!_idle) {
+        return scan(now);
+    }
+
+    // Checked again right before sleeping to keep the window for a missed
+    // edge small; the next interrupt ends the sleep in any case
+    if (_idle && (_sleepCallback != nullptr) && !_wakeRequested) {
+        _sleepCallback(sleep);
+    }
+
+    return false;
+}
+
+#if defined(ARDUINO_ARCH_AVR)
+// Period of the timer 0 overflow that drives millis(), in microseconds
+#define JOYSTICK_IDLE_TIMER_TICK ((64UL * 256UL * 1000UL) / (F_CPU / 1000UL))
+
+void joystickSleepIdle(uint32_t maxSleep) {
+    // The next timer overflow is the latest wake-up, which could already be
+    // past the next scan
+    if (maxSleep < JOYSTICK_IDLE_TIMER_TICK) return;
+
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_mode();
+}
+#endif
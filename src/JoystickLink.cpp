@@ -0,0 +1,273 @@
+//
+// JoystickLink.cpp
+//
+
+#include "JoystickLink.h"
+#include "JoystickMath.h"
+
+#define JOYSTICK_LINK_FIELD_MASK 0x1F
+#define JOYSTICK_LINK_SIZE_SHIFT 5
+
+static_assert(JOYSTICK_LINK_NODE_COUNT <= 8, "Nodes are tracked in an 8-bit mask");
+
+static uint8_t valueSizeCode(int32_t value) {
+    if ((value >= INT8_MIN) && (value <= INT8_MAX)) return 0;
+    if ((value >= INT16_MIN) && (value <= INT16_MAX)) return 1;
+    return 2;
+}
+
+JoystickLinkEncoder::JoystickLinkEncoder(uint8_t nodeId) : _nodeId(nodeId) {
+    memset(_values, 0, sizeof(_values));
+    memset(_buttonValues, 0, sizeof(_buttonValues));
+}
+
+void JoystickLinkEncoder::setKeyFrameInterval(uint8_t keyFrameInterval) {
+    _keyFrameInterval = keyFrameInterval;
+}
+
+void JoystickLinkEncoder::setField(JoystickField field, int32_t value) {
+    if (field >= JOYSTICK_FIELD_BUTTONS) return;
+
+    uint16_t mask = JOYSTICK_FIELD_MASK(field);
+    if ((_usedFields & mask) && (_values[field] == value)) return;
+
+    _values[field] = value;
+    _usedFields |= mask;
+    _dirtyFields |= mask;
+}
+
+void JoystickLinkEncoder::setButton(uint8_t button, bool pressed) {
+    if (button >= JOYSTICK_BUTTON_COUNT_MAXIMUM) return;
+
+    uint8_t value = _buttonValues[button / 8];
+    if (pressed) {
+        bitSet(value, button % 8);
+    } else {
+        bitClear(value, button % 8);
+    }
+    setButtonBytes(button / 8, &value, 1);
+}
+
+void JoystickLinkEncoder::setButtonBytes(uint8_t firstByte, const uint8_t values[], uint8_t count) {
+    for (uint8_t index = 0; index < count; index++) {
+        uint8_t byteIndex = firstByte + index;
+        if (byteIndex >= sizeof(_buttonValues)) break;
+
+        uint8_t mask = (uint8_t) (1 << byteIndex);
+        if ((_usedButtonBytes & mask) && (_buttonValues[byteIndex] == values[index])) continue;
+
+        _buttonValues[byteIndex] = values[index];
+        _usedButtonBytes |= mask;
+        _dirtyButtonBytes |= mask;
+    }
+}
+
+uint8_t JoystickLinkEncoder::encode(uint8_t buffer[]) {
+    bool keyFrame = !_started || ((_keyFrameInterval != 0) && (_framesSinceKeyFrame + 1 >= _keyFrameInterval));
+    uint16_t fields = keyFrame ? _usedFields : _dirtyFields;
+    uint8_t buttonBytes = keyFrame ? _usedButtonBytes : _dirtyButtonBytes;
+    uint8_t length = JOYSTICK_LINK_HEADER_SIZE;
+
+    // Counts calls rather than frames, so an idle node still sends a key
+    // frame now and then and a lost last change gets repaired
+    _framesSinceKeyFrame = keyFrame ? 0 : _framesSinceKeyFrame + 1;
+    _started = true;
+
+    if ((fields == 0) && (buttonBytes == 0) && !keyFrame) return 0;
+
+    for (uint8_t field = 0; field < JOYSTICK_FIELD_BUTTONS; field++) {
+        if (!(fields & JOYSTICK_FIELD_MASK(field))) continue;
+
+        int32_t value = _values[field];
+        uint8_t sizeCode = valueSizeCode(value);
+        buffer[length++] = (uint8_t) (field | (sizeCode << JOYSTICK_LINK_SIZE_SHIFT));
+        for (uint8_t index = 0; index < (1 << sizeCode); index++) {
+            buffer[length++] = (uint8_t) ((uint32_t) value >> (8 * index));
+        }
+    }
+
+    if (buttonBytes != 0) {
+        // One run from the first to the last changed byte
+        uint8_t first = 0;
+        uint8_t last = sizeof(_buttonValues) - 1;
+        while (!(buttonBytes & (1 << first))) first++;
+        while (!(buttonBytes & (1 << last))) last--;
+
+        buffer[length++] = JOYSTICK_FIELD_BUTTONS;
+        buffer[length++] = first;
+        buffer[length++] = (uint8_t) (last - first + 1);
+        for (uint8_t index = first; index <= last; index++) {
+            buffer[length++] = _buttonValues[index];
+        }
+    }
+
+    buffer[0] = JOYSTICK_LINK_SYNC;
+    buffer[1] = (uint8_t) (length - JOYSTICK_LINK_HEADER_SIZE);
+    buffer[2] = (uint8_t) ((_nodeId & JOYSTICK_LINK_NODE_MASK) | (keyFrame ? JOYSTICK_LINK_KEY_FRAME : 0));
+    buffer[3] = _sequence++;
+
+    uint16_t crc = joystickCrc16(&buffer[1], (uint16_t) (length - 1));
+    buffer[length++] = (uint8_t) (crc & 0x00FF);
+    buffer[length++] = (uint8_t) (crc >> 8);
+
+    _dirtyFields = 0;
+    _dirtyButtonBytes = 0;
+
+    return length;
+}
+
+JoystickLinkDecoder::JoystickLinkDecoder(Joystick_ &joystick) : _joystick(joystick) {
+    memset(_sequences, 0, sizeof(_sequences));
+}
+
+uint8_t JoystickLinkDecoder::feed(uint8_t value) {
+    uint8_t frames = 0;
+
+    if ((_count == 0) && (value != JOYSTICK_LINK_SYNC)) return 0;
+
+    _buffer[_count++] = value;
+
+    // A rejected frame only drops its sync byte, the bytes after it may hold
+    // the start of a real frame and are scanned again
+    while (_count >= 2) {
+        if (_buffer[1] > JOYSTICK_LINK_PAYLOAD_MAXIMUM) {
+            // Not a frame start after all
+            _rejectedFrameCount++;
+            discard(1);
+            continue;
+        }
+
+        uint8_t length = JOYSTICK_LINK_HEADER_SIZE + _buffer[1] + 2;
+        if (_count < length) break;
+
+        if (applyFrame(_buffer, length)) {
+            frames++;
+            discard(length);
+        } else {
+            discard(1);
+        }
+    }
+
+    return frames;
+}
+
+void JoystickLinkDecoder::discard(uint8_t count) {
+    while ((count < _count) && (_buffer[count] != JOYSTICK_LINK_SYNC)) {
+        count++;
+    }
+
+    _count -= count;
+    memmove(_buffer, &_buffer[count], _count);
+}
+
+uint16_t JoystickLinkDecoder::feed(const uint8_t data[], uint16_t length) {
+    uint16_t frames = 0;
+
+    for (uint16_t index = 0; index < length; index++) {
+        frames += feed(data[index]);
+    }
+
+    return frames;
+}
+
+bool JoystickLinkDecoder::applyFrame(const uint8_t frame[], uint8_t length) {
+    if ((length < JOYSTICK_LINK_HEADER_SIZE + 2) || (frame[0] != JOYSTICK_LINK_SYNC) ||
+        (length != JOYSTICK_LINK_HEADER_SIZE + frame[1] + 2)) {
+        _rejectedFrameCount++;
+        return false;
+    }
+
+    uint16_t crc = joystickCrc16(&frame[1], (uint16_t) (length - 3));
+    if ((frame[length - 2] != (uint8_t) (crc & 0x00FF)) || (frame[length - 1] != (uint8_t) (crc >> 8))) {
+        _crcErrorCount++;
+        return false;
+    }
+
+    uint8_t node = frame[2] & JOYSTICK_LINK_NODE_MASK;
+    bool keyFrame = (frame[2] & JOYSTICK_LINK_KEY_FRAME) != 0;
+    uint8_t sequence = frame[3];
+    const uint8_t *payload = &frame[JOYSTICK_LINK_HEADER_SIZE];
+
+    if ((node >= JOYSTICK_LINK_NODE_COUNT) || !checkEntries(payload, frame[1])) {
+        _rejectedFrameCount++;
+        return false;
+    }
+
+    if (_knownNodes & (1 << node)) {
+        uint8_t gap = (uint8_t) (sequence - _sequences[node]);
+        if ((gap == 0) || ((gap >= 128) && !keyFrame)) {
+            // Repeated or reordered frame
+            _rejectedFrameCount++;
+            return false;
+        }
+        if (gap < 128) {
+            _lostFrameCount += gap - 1;
+        }
+    }
+    _sequences[node] = sequence;
+    _knownNodes |= (uint8_t) (1 << node);
+
+    applyEntries(payload, frame[1]);
+    _frameCount++;
+    return true;
+}
+
+bool JoystickLinkDecoder::checkEntries(const uint8_t payload[], uint8_t length) const {
+    uint8_t index = 0;
+
+    // Walks the entries once so that a malformed frame changes nothing
+    while (index < length) {
+        uint8_t tag = payload[index++];
+        uint8_t field = tag & JOYSTICK_LINK_FIELD_MASK;
+
+        if (field == JOYSTICK_FIELD_BUTTONS) {
+            if (index + 2 > length) return false;
+            uint8_t count = payload[index + 1];
+            if (payload[index] + count > JOYSTICK_BUTTON_COUNT_MAXIMUM / 8) return false;
+            index += 2 + count;
+        } else {
+            uint8_t sizeCode = tag >> JOYSTICK_LINK_SIZE_SHIFT;
+            if ((field > JOYSTICK_FIELD_BUTTONS) || (sizeCode > 2)) return false;
+            index += 1 << sizeCode;
+        }
+    }
+
+    return index == length;
+}
+
+void JoystickLinkDecoder::applyEntries(const uint8_t payload[], uint8_t length) {
+    uint8_t index = 0;
+
+    _joystick.beginUpdate();
+    while (index < length) {
+        uint8_t tag = payload[index++];
+        uint8_t field = tag & JOYSTICK_LINK_FIELD_MASK;
+
+        if (field == JOYSTICK_FIELD_BUTTONS) {
+            uint8_t firstByte = payload[index];
+            uint8_t count = payload[index + 1];
+            _joystick.setButtonBytes(firstByte, &payload[index + 2], count);
+            index += 2 + count;
+            continue;
+        }
+
+        uint8_t size = 1 << (tag >> JOYSTICK_LINK_SIZE_SHIFT);
+        uint32_t raw = 0;
+        for (uint8_t byte = 0; byte < size; byte++) {
+            raw |= (uint32_t) payload[index + byte] << (8 * byte);
+        }
+        index += size;
+
+        // Sign-extend from the encoded size
+        int32_t value;
+        if (size == 1) {
+            value = (int8_t) raw;
+        } else if (size == 2) {
+            value = (int16_t) raw;
+        } else {
+            value = (int32_t) raw;
+        }
+        _joystick.setField((JoystickField) field, value);
+    }
+    _joystick.endUpdate();
+}
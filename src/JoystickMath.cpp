@@ -0,0 +1,115 @@
+//
+// JoystickMath.cpp
+//
+
+#include "JoystickMath.h"
+
+// atan(2^-i) as binary angles
+static const uint16_t cordicAngles[] = {8192, 4836, 2555, 1297, 651, 326, 163, 81, 41, 20, 10, 5, 3, 1};
+
+// CRC-16/CCITT-FALSE for one nibble
+static const uint16_t crcNibbles[] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+// First quarter of a sine wave in 64 steps
+static const int16_t sineQuarter[] = {
+        0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+        12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+        23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+        30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+        32767
+};
+
+uint16_t joystickSqrt(uint32_t value) {
+    uint32_t result = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+
+    while (bit != 0) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint16_t) result;
+}
+
+int16_t joystickAtan2(int32_t y, int32_t x) {
+    uint16_t angle = 0;
+
+    if ((x == 0) && (y == 0)) return 0;
+
+    if (x < 0) {
+        // Rotate into the right half plane first
+        x = -x;
+        y = -y;
+        angle = 32768;
+    }
+
+    // Small vectors lose their low bits in the shifts, so scale them up
+    // to use the full range first
+    uint32_t magnitude = (uint32_t) x | (uint32_t) (y < 0 ? -y : y);
+    while (magnitude < (1UL << 27)) {
+        x <<= 1;
+        y *= 2;
+        magnitude <<= 1;
+    }
+
+    for (uint8_t iteration = 0; iteration < sizeof(cordicAngles) / sizeof(cordicAngles[0]); iteration++) {
+        int32_t xShifted = x >> iteration;
+        int32_t yShifted = y >> iteration;
+
+        if (y > 0) {
+            x += yShifted;
+            y -= xShifted;
+            angle += cordicAngles[iteration];
+        } else {
+            x -= yShifted;
+            y += xShifted;
+            angle -= cordicAngles[iteration];
+        }
+    }
+
+    return (int16_t) angle;
+}
+
+int16_t joystickSin(uint16_t angle) {
+    bool negative = angle >= 32768;
+    uint16_t quarterAngle = angle & 0x3FFF;
+
+    if (angle & 0x4000) {
+        // Second and fourth quarter run backwards through the table
+        quarterAngle = 0x4000 - quarterAngle;
+    }
+
+    // 256 angle units per table step, interpolated linearly
+    uint8_t index = quarterAngle >> 8;
+    int16_t value = sineQuarter[index];
+    if (index < 64) {
+        value += (int16_t) (((int32_t) (sineQuarter[index + 1] - value) * (quarterAngle & 0xFF)) >> 8);
+    }
+
+    return negative ? -value : value;
+}
+
+int16_t joystickCos(uint16_t angle) {
+    return joystickSin(angle + 16384);
+}
+
+uint16_t joystickCrc16(const uint8_t data[], uint16_t length, uint16_t crc) {
+    for (uint16_t index = 0; index < length; index++) {
+        crc = (uint16_t) ((crc << 4) ^ crcNibbles[(crc >> 12) ^ (data[index] >> 4)]);
+        crc = (uint16_t) ((crc << 4) ^ crcNibbles[(crc >> 12) ^ (data[index] & 0x0F)]);
+    }
+
+    return crc;
+}
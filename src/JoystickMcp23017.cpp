@@ -0,0 +1,147 @@
+//
+// JoystickMcp23017.cpp
+//
+
+#include "JoystickMcp23017.h"
+#include "JoystickProfiler.h"
+
+// Register addresses with IOCON.BANK=1, port B at +0x10
+#define MCP23017_PORT_OFFSET 0x10
+#define MCP23017_IODIR       0x00
+#define MCP23017_IOCON       0x05
+#define MCP23017_INTF        0x07
+#define MCP23017_IOCON_BANK0 0x0A   // IOCON after power-up (BANK=0)
+
+#define MCP23017_IOCON_BANK   0x80
+#define MCP23017_IOCON_MIRROR 0x40
+#define MCP23017_IOCON_ODR    0x04
+
+JoystickMcp23017::JoystickMcp23017(Joystick_ &joystick, JoystickI2cBus &bus, uint8_t address, uint8_t firstButton,
+                                   uint8_t portCount)
+        : _joystick(joystick), _bus(bus), _address(address), _firstByte(firstButton / 8), _portCount(portCount) {
+    if ((_portCount == 0) || (_portCount > JOYSTICK_MCP23017_PORT_COUNT)) {
+        _portCount = JOYSTICK_MCP23017_PORT_COUNT;
+    }
+    for (uint8_t port = 0; port < JOYSTICK_MCP23017_PORT_COUNT; port++) {
+        _interruptPins[port] = JOYSTICK_MCP23017_NO_PIN;
+        _requested[port] = false;
+        _values[port] = 0;
+    }
+}
+
+void JoystickMcp23017::setInverted(bool inverted) {
+    _inverted = inverted;
+}
+
+void JoystickMcp23017::setInterruptPins(uint8_t pinA, uint8_t pinB) {
+    _interruptPins[0] = pinA;
+    _interruptPins[1] = pinB;
+}
+
+void JoystickMcp23017::setInterruptDriven(bool interruptDriven) {
+    _interruptDriven = interruptDriven;
+}
+
+bool JoystickMcp23017::begin() {
+    bool mirror = (_interruptPins[1] == JOYSTICK_MCP23017_NO_PIN) && (_portCount > 1);
+    uint8_t iocon = MCP23017_IOCON_BANK | MCP23017_IOCON_ODR | (mirror ? MCP23017_IOCON_MIRROR : 0);
+
+    // Switches to BANK=1 from the power-up layout. If the expander already
+    // uses BANK=1 (MCU reset only) this lands on OLATA, which is unused.
+    if (!_bus.writeRegisters(_address, MCP23017_IOCON_BANK0, &iocon, 1)) return false;
+
+    for (uint8_t port = 0; port < _portCount; port++) {
+        // IODIR, IPOL, GPINTEN, DEFVAL, INTCON, IOCON, GPPU in one burst:
+        // inputs with pull-ups, interrupt on any change
+        const uint8_t config[] = {0xFF, (uint8_t) (_inverted ? 0xFF : 0x00), 0xFF, 0x00, 0x00, iocon, 0xFF};
+        if (!_bus.writeRegisters(_address, port * MCP23017_PORT_OFFSET + MCP23017_IODIR, config, sizeof(config))) {
+            return false;
+        }
+
+        if (_interruptPins[port] != JOYSTICK_MCP23017_NO_PIN) {
+            pinMode(_interruptPins[port], INPUT_PULLUP);
+        }
+    }
+
+    // Reading all ports clears pending interrupts and applies the state
+    _pendingPorts = JOYSTICK_MCP23017_PORT_ALL;
+    update();
+    return _errorCount == 0;
+}
+
+void JoystickMcp23017::interrupt(uint8_t ports) {
+    _interruptDriven = true;
+    if (ports & JOYSTICK_MCP23017_PORT_A) _requested[0] = true;
+    if (ports & JOYSTICK_MCP23017_PORT_B) _requested[1] = true;
+}
+
+uint8_t JoystickMcp23017::getSignalledPorts() const {
+    if ((_interruptPins[0] == JOYSTICK_MCP23017_NO_PIN) && (_interruptPins[1] == JOYSTICK_MCP23017_NO_PIN)) {
+        // Polling, unless interrupt() reports the changes
+        return _interruptDriven ? 0 : JOYSTICK_MCP23017_PORT_ALL;
+    }
+
+    uint8_t ports = 0;
+    if ((_interruptPins[0] != JOYSTICK_MCP23017_NO_PIN) && (digitalRead(_interruptPins[0]) == LOW)) {
+        ports |= (_interruptPins[1] == JOYSTICK_MCP23017_NO_PIN) ? JOYSTICK_MCP23017_PORT_ALL
+                                                                  : JOYSTICK_MCP23017_PORT_A;
+    }
+    if ((_interruptPins[1] != JOYSTICK_MCP23017_NO_PIN) && (digitalRead(_interruptPins[1]) == LOW)) {
+        ports |= JOYSTICK_MCP23017_PORT_B;
+    }
+    return ports;
+}
+
+bool JoystickMcp23017::update() {
+    uint8_t ports = _pendingPorts | getSignalledPorts();
+    for (uint8_t port = 0; port < JOYSTICK_MCP23017_PORT_COUNT; port++) {
+        // Cleared before the read, so an edge during the read is not lost
+        if (_requested[port]) {
+            _requested[port] = false;
+            ports |= (uint8_t) (1 << port);
+        }
+    }
+    ports &= (uint8_t) ((1 << _portCount) - 1);
+    if (ports == 0) return false;
+
+    bool changed = false;
+    _pendingPorts = 0;
+
+    JOYSTICK_PROFILE_BEGIN(JOYSTICK_STAGE_SCAN);
+    for (uint8_t port = 0; port < _portCount; port++) {
+        if (!(ports & (1 << port))) continue;
+
+        // INTF, INTCAP, GPIO
+        uint8_t buffer[3];
+        if (!_bus.readRegisters(_address, port * MCP23017_PORT_OFFSET + MCP23017_INTF, buffer, sizeof(buffer))) {
+            _errorCount++;
+            _pendingPorts |= (uint8_t) (1 << port);
+            continue;
+        }
+        _readCount++;
+
+        // The pin that raised the interrupt reports its captured level, so a
+        // pulse shorter than the read latency is still seen for one update;
+        // the current level follows on the next one
+        uint8_t value = (uint8_t) ((buffer[2] & ~buffer[0]) | (buffer[1] & buffer[0]));
+        if (value != buffer[2]) {
+            _pendingPorts |= (uint8_t) (1 << port);
+        }
+
+        if (_values[port] != value) {
+            _values[port] = value;
+            changed = true;
+        }
+    }
+    JOYSTICK_PROFILE_END(JOYSTICK_STAGE_SCAN);
+
+    if (changed) {
+        _joystick.setButtonBytes(_firstByte, _values, _portCount);
+    }
+
+    return changed;
+}
+
+const uint8_t *JoystickMcp23017::getValues() const {
+    return _values;
+}
@@ -0,0 +1,123 @@
+//
+// JoystickMotion.cpp
+//
+
+#include "JoystickMotion.h"
+#include "JoystickMath.h"
+#include "JoystickProfiler.h"
+
+JoystickMotion::JoystickMotion(Joystick_ &joystick) : _joystick(joystick) {
+    updateGyroFactor();
+}
+
+void JoystickMotion::setSampleRate(uint16_t sampleRate) {
+    if (sampleRate == 0) return;
+    _sampleRate = sampleRate;
+    updateGyroFactor();
+}
+
+void JoystickMotion::setGyroRange(uint16_t gyroRange) {
+    _gyroRange = gyroRange;
+    updateGyroFactor();
+}
+
+void JoystickMotion::setFilterShift(uint8_t filterShift) {
+    _filterShift = (filterShift < 31) ? filterShift : 31;
+}
+
+void JoystickMotion::setOutputRange(uint16_t outputRange) {
+    if ((outputRange == 0) || (outputRange > 180)) outputRange = 180;
+    _outputRange = outputRange;
+}
+
+void JoystickMotion::setReportDivider(uint8_t reportDivider) {
+    _reportDivider = (reportDivider > 0) ? reportDivider : 1;
+}
+
+void JoystickMotion::setGyroBias(int16_t x, int16_t y, int16_t z) {
+    _gyroBias[0] = x;
+    _gyroBias[1] = y;
+    _gyroBias[2] = z;
+}
+
+void JoystickMotion::updateGyroFactor() {
+    // Angle step per count and sample: gyroRange / 32768 / sampleRate turns / 360 * 2^32,
+    // kept with as many fractional bits as fit a 16-bit count times the factor into 31 bits.
+    uint64_t numerator = (uint64_t) _gyroRange << 17;
+    uint32_t denominator = 360UL * _sampleRate;
+
+    _gyroShift = 16;
+    while ((_gyroShift > 0) && (((numerator << _gyroShift) / denominator) > 0x7FFF)) {
+        _gyroShift--;
+    }
+    _gyroFactor = (int32_t) ((numerator << _gyroShift) / denominator);
+}
+
+uint32_t JoystickMotion::accelerationRoll(int16_t accelerationY, int16_t accelerationZ) {
+    return (uint32_t) (uint16_t) joystickAtan2(accelerationY, accelerationZ) << 16;
+}
+
+uint32_t JoystickMotion::accelerationPitch(int16_t accelerationX, int16_t accelerationY, int16_t accelerationZ) {
+    uint16_t horizontal = joystickSqrt((uint32_t) ((int32_t) accelerationY * accelerationY) +
+                                       (uint32_t) ((int32_t) accelerationZ * accelerationZ));
+    return (uint32_t) (uint16_t) joystickAtan2(-(int32_t) accelerationX, horizontal) << 16;
+}
+
+void JoystickMotion::begin(int16_t accelerationX, int16_t accelerationY, int16_t accelerationZ) {
+    int32_t range = ((int32_t) _outputRange * 65536L) / 360;
+    if (range > 32767) range = 32767;
+
+    _joystick.setRxAxisRange(-range, range);
+    _joystick.setRyAxisRange(-range, range);
+    _joystick.setRzAxisRange(-range, range);
+
+    _roll = accelerationRoll(accelerationY, accelerationZ);
+    _pitch = accelerationPitch(accelerationX, accelerationY, accelerationZ);
+    _yaw = 0;
+    _sampleCount = 0;
+}
+
+bool JoystickMotion::update(int16_t accelerationX, int16_t accelerationY, int16_t accelerationZ,
+                            int16_t rotationX, int16_t rotationY, int16_t rotationZ) {
+    JOYSTICK_PROFILE_BEGIN(JOYSTICK_STAGE_FILTER);
+
+    // Gyro integration
+    _roll += (uint32_t) ((((int32_t) rotationX - _gyroBias[0]) * _gyroFactor) >> _gyroShift);
+    _pitch += (uint32_t) ((((int32_t) rotationY - _gyroBias[1]) * _gyroFactor) >> _gyroShift);
+    _yaw += (uint32_t) ((((int32_t) rotationZ - _gyroBias[2]) * _gyroFactor) >> _gyroShift);
+
+    // Pull roll and pitch towards the gravity vector
+    int32_t rollError = (int32_t) (accelerationRoll(accelerationY, accelerationZ) - _roll);
+    int32_t pitchError = (int32_t) (accelerationPitch(accelerationX, accelerationY, accelerationZ) - _pitch);
+    _roll += (uint32_t) (rollError >> _filterShift);
+    _pitch += (uint32_t) (pitchError >> _filterShift);
+
+    JOYSTICK_PROFILE_END(JOYSTICK_STAGE_FILTER);
+
+    if (++_sampleCount < _reportDivider) return false;
+    _sampleCount = 0;
+
+    _joystick.beginUpdate();
+    _joystick.setRxAxis(getRoll());
+    _joystick.setRyAxis(getPitch());
+    _joystick.setRzAxis(getYaw());
+    _joystick.endUpdate();
+
+    return true;
+}
+
+int16_t JoystickMotion::getRoll() const {
+    return (int16_t) (_roll >> 16);
+}
+
+int16_t JoystickMotion::getPitch() const {
+    return (int16_t) (_pitch >> 16);
+}
+
+int16_t JoystickMotion::getYaw() const {
+    return (int16_t) (_yaw >> 16);
+}
+
+void JoystickMotion::resetYaw() {
+    _yaw = 0;
+}
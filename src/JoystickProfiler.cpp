@@ -0,0 +1,74 @@
+//
+// JoystickProfiler.cpp
+//
+
+#include "JoystickProfiler.h"
+
+#if defined(JOYSTICK_ENABLE_PROFILER)
+
+static const char *const stageNames[JOYSTICK_STAGE_COUNT] = {"scan", "filter", "encode", "send"};
+
+JoystickProfileStats JoystickProfiler::_stats[JOYSTICK_STAGE_COUNT];
+
+void JoystickProfiler::begin() {
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+    // DEMCR.TRCENA, then DWT_CTRL.CYCCNTENA
+    *(volatile uint32_t *) 0xE000EDFC |= 0x01000000;
+    *(volatile uint32_t *) 0xE0001000 |= 0x00000001;
+#endif
+    reset();
+}
+
+void JoystickProfiler::record(JoystickProfileStage stage, uint32_t ticks) {
+    JoystickProfileStats &stats = _stats[stage];
+
+    if ((stats.count == 0) || (ticks < stats.minimum)) stats.minimum = ticks;
+    if (ticks > stats.maximum) stats.maximum = ticks;
+    stats.total += ticks;
+    stats.count++;
+}
+
+const JoystickProfileStats &JoystickProfiler::getStats(JoystickProfileStage stage) {
+    return _stats[stage];
+}
+
+void JoystickProfiler::reset() {
+    for (uint8_t stage = 0; stage < JOYSTICK_STAGE_COUNT; stage++) {
+        _stats[stage] = {0, 0, 0, 0};
+    }
+}
+
+void JoystickProfiler::dump(Print &output) {
+    for (uint8_t stage = 0; stage < JOYSTICK_STAGE_COUNT; stage++) {
+        const JoystickProfileStats &stats = _stats[stage];
+
+        output.print(stageNames[stage]);
+        output.print(": n=");
+        output.print((unsigned long) stats.count);
+        output.print(" min=");
+        output.print((unsigned long) stats.minimum);
+        output.print(" avg=");
+        output.print((unsigned long) stats.average());
+        output.print(" max=");
+        output.print((unsigned long) stats.maximum);
+        output.print(" ");
+        output.println(getUnit());
+    }
+}
+
+const char *JoystickProfiler::getStageName(JoystickProfileStage stage) {
+    return (stage < JOYSTICK_STAGE_COUNT) ? stageNames[stage] : "";
+}
+
+const char *JoystickProfiler::getUnit() {
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266) || defined(__ARM_ARCH_7M__) || \
+    defined(__ARM_ARCH_7EM__) || defined(__x86_64__) || defined(__i386__)
+    return "cycles";
+#elif defined(ARDUINO)
+    return "us";
+#else
+    return "ns";
+#endif
+}
+
+#endif // JOYSTICK_ENABLE_PROFILER
@@ -0,0 +1,56 @@
+//
+// JoystickShiftRegister.cpp
+//
+
+#include "JoystickShiftRegister.h"
+#include "JoystickProfiler.h"
+
+JoystickShiftRegister::JoystickShiftRegister(Joystick_ &joystick, JoystickSpiBus &bus, uint8_t registerCount,
+                                             uint8_t firstButton)
+        : _joystick(joystick), _bus(bus), _registerCount(registerCount), _firstByte(firstButton / 8) {
+    if (_registerCount > JOYSTICK_SHIFT_REGISTER_MAXIMUM) {
+        _registerCount = JOYSTICK_SHIFT_REGISTER_MAXIMUM;
+    }
+    memset(_values, 0, sizeof(_values));
+}
+
+void JoystickShiftRegister::setInverted(bool inverted) {
+    _inverted = inverted;
+}
+
+void JoystickShiftRegister::setReverseOrder(bool reverseOrder) {
+    _reverseOrder = reverseOrder;
+}
+
+bool JoystickShiftRegister::update() {
+    uint8_t buffer[JOYSTICK_SHIFT_REGISTER_MAXIMUM];
+
+    JOYSTICK_PROFILE_BEGIN(JOYSTICK_STAGE_SCAN);
+    _bus.beginTransaction();
+    _bus.latch();
+    _bus.read(buffer, _registerCount);
+    _bus.endTransaction();
+    JOYSTICK_PROFILE_END(JOYSTICK_STAGE_SCAN);
+
+    bool changed = !_valid;
+    for (uint8_t index = 0; index < _registerCount; index++) {
+        uint8_t value = buffer[_reverseOrder ? (_registerCount - 1 - index) : index];
+        if (_inverted) value = ~value;
+
+        if (_values[index] != value) {
+            _values[index] = value;
+            changed = true;
+        }
+    }
+    _valid = true;
+
+    if (changed) {
+        _joystick.setButtonBytes(_firstByte, _values, _registerCount);
+    }
+
+    return changed;
+}
+
+const uint8_t *JoystickShiftRegister::getValues() const {
+    return _values;
+}
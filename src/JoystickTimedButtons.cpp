@@ -0,0 +1,211 @@
+//
+// JoystickTimedButtons.cpp
+//
+
+#include "JoystickTimedButtons.h"
+
+#define JOYSTICK_TIMER_NONE 0xFF
+#define JOYSTICK_TIMER_WHEEL_MASK (JOYSTICK_TIMER_WHEEL_SIZE - 1)
+
+static_assert((JOYSTICK_TIMER_WHEEL_SIZE & JOYSTICK_TIMER_WHEEL_MASK) == 0,
+              "JOYSTICK_TIMER_WHEEL_SIZE must be a power of two");
+static_assert(JOYSTICK_TIMER_COUNT < JOYSTICK_TIMER_NONE, "JOYSTICK_TIMER_COUNT must be below 255");
+
+JoystickTimedButtons::JoystickTimedButtons(Joystick_ &joystick, uint32_t tickLength, JoystickClock clock)
+        : _joystick(joystick), _clock(clock), _tickLength(tickLength > 0 ? tickLength : 1) {
+    _lastTickTime = _clock();
+
+    for (uint8_t &slot: _slots) {
+        slot = JOYSTICK_TIMER_NONE;
+    }
+    for (uint8_t &buttonTimer: _buttonTimers) {
+        buttonTimer = JOYSTICK_TIMER_NONE;
+    }
+
+    // Chain all timers into the free list
+    for (uint8_t index = 0; index < JOYSTICK_TIMER_COUNT; index++) {
+        _timers[index].next = (index + 1 < JOYSTICK_TIMER_COUNT) ? index + 1 : JOYSTICK_TIMER_NONE;
+    }
+    _freeList = 0;
+}
+
+uint32_t JoystickTimedButtons::toTicks(uint32_t duration) const {
+    uint32_t ticks = (duration + _tickLength - 1) / _tickLength;
+    return (ticks > 0) ? ticks : 1;
+}
+
+uint8_t JoystickTimedButtons::allocate(uint8_t button) {
+    if (button >= JOYSTICK_BUTTON_COUNT_MAXIMUM) return JOYSTICK_TIMER_NONE;
+
+    // A new action replaces the running one
+    if (_buttonTimers[button] != JOYSTICK_TIMER_NONE) {
+        uint8_t timer = _buttonTimers[button];
+        unlink(timer);
+        return timer;
+    }
+
+    if (_freeList == JOYSTICK_TIMER_NONE) return JOYSTICK_TIMER_NONE;
+
+    uint8_t timer = _freeList;
+    _freeList = _timers[timer].next;
+    _timers[timer].button = button;
+    _buttonTimers[button] = timer;
+    _activeCount++;
+    return timer;
+}
+
+void JoystickTimedButtons::release(uint8_t timer) {
+    _buttonTimers[_timers[timer].button] = JOYSTICK_TIMER_NONE;
+    _timers[timer].next = _freeList;
+    _freeList = timer;
+    _activeCount--;
+}
+
+void JoystickTimedButtons::schedule(uint8_t timer, uint32_t ticks) {
+    Timer &entry = _timers[timer];
+    uint8_t slot = (uint8_t) ((_currentTick + ticks) & JOYSTICK_TIMER_WHEEL_MASK);
+
+    entry.slot = slot;
+    entry.rounds = (uint16_t) ((ticks - 1) / JOYSTICK_TIMER_WHEEL_SIZE);
+    entry.previous = JOYSTICK_TIMER_NONE;
+    entry.next = _slots[slot];
+    if (entry.next != JOYSTICK_TIMER_NONE) {
+        _timers[entry.next].previous = timer;
+    }
+    _slots[slot] = timer;
+}
+
+void JoystickTimedButtons::unlink(uint8_t timer) {
+    Timer &entry = _timers[timer];
+
+    if (entry.previous != JOYSTICK_TIMER_NONE) {
+        _timers[entry.previous].next = entry.next;
+    } else if (_slots[entry.slot] == timer) {
+        _slots[entry.slot] = entry.next;
+    }
+    if (entry.next != JOYSTICK_TIMER_NONE) {
+        _timers[entry.next].previous = entry.previous;
+    }
+
+    entry.next = JOYSTICK_TIMER_NONE;
+    entry.previous = JOYSTICK_TIMER_NONE;
+}
+
+bool JoystickTimedButtons::startAutofire(uint8_t button, uint16_t frequency) {
+    if (frequency == 0) return false;
+
+    uint8_t timer = allocate(button);
+    if (timer == JOYSTICK_TIMER_NONE) return false;
+
+    Timer &entry = _timers[timer];
+    entry.action = ACTION_AUTOFIRE;
+    entry.period = toTicks(500000UL / frequency);
+    entry.pressed = true;
+    schedule(timer, entry.period);
+
+    _joystick.pressButton(button);
+    return true;
+}
+
+bool JoystickTimedButtons::pulse(uint8_t button, uint32_t duration) {
+    uint8_t timer = allocate(button);
+    if (timer == JOYSTICK_TIMER_NONE) return false;
+
+    _timers[timer].action = ACTION_RELEASE;
+    schedule(timer, toTicks(duration));
+
+    _joystick.pressButton(button);
+    return true;
+}
+
+bool JoystickTimedButtons::holdAfter(uint8_t button, uint32_t delay, uint32_t duration) {
+    uint8_t timer = allocate(button);
+    if (timer == JOYSTICK_TIMER_NONE) return false;
+
+    Timer &entry = _timers[timer];
+    entry.action = ACTION_PRESS;
+    entry.duration = duration;
+    schedule(timer, toTicks(delay));
+    return true;
+}
+
+void JoystickTimedButtons::cancel(uint8_t button) {
+    if (button >= JOYSTICK_BUTTON_COUNT_MAXIMUM) return;
+
+    uint8_t timer = _buttonTimers[button];
+    if (timer != JOYSTICK_TIMER_NONE) {
+        unlink(timer);
+        release(timer);
+    }
+    _joystick.releaseButton(button);
+}
+
+bool JoystickTimedButtons::isActive(uint8_t button) const {
+    if (button >= JOYSTICK_BUTTON_COUNT_MAXIMUM) return false;
+    return _buttonTimers[button] != JOYSTICK_TIMER_NONE;
+}
+
+uint8_t JoystickTimedButtons::getActiveCount() const {
+    return _activeCount;
+}
+
+uint16_t JoystickTimedButtons::update() {
+    uint32_t now = _clock();
+    uint16_t expired = 0;
+
+    _joystick.beginUpdate();
+    while (joystickTimeDifference(now, _lastTickTime) >= (int32_t) _tickLength) {
+        _lastTickTime += _tickLength;
+        _currentTick++;
+        expired += processSlot((uint8_t) (_currentTick & JOYSTICK_TIMER_WHEEL_MASK));
+    }
+    _joystick.endUpdate();
+
+    return expired;
+}
+
+uint16_t JoystickTimedButtons::processSlot(uint8_t slot) {
+    uint16_t expired = 0;
+
+    // Detach the slot first, rescheduled timers may hash into it again
+    uint8_t timer = _slots[slot];
+    _slots[slot] = JOYSTICK_TIMER_NONE;
+
+    while (timer != JOYSTICK_TIMER_NONE) {
+        Timer &entry = _timers[timer];
+        uint8_t next = entry.next;
+
+        if (entry.rounds > 0) {
+            // Not due in this revolution of the wheel
+            schedule(timer, (uint32_t) entry.rounds * JOYSTICK_TIMER_WHEEL_SIZE);
+        } else {
+            expired++;
+            switch (entry.action) {
+                case ACTION_AUTOFIRE:
+                    entry.pressed = !entry.pressed;
+                    _joystick.setButton(entry.button, entry.pressed);
+                    schedule(timer, entry.period);
+                    break;
+
+                case ACTION_PRESS:
+                    _joystick.pressButton(entry.button);
+                    if (entry.duration > 0) {
+                        entry.action = ACTION_RELEASE;
+                        schedule(timer, toTicks(entry.duration));
+                    } else {
+                        release(timer);
+                    }
+                    break;
+
+                case ACTION_RELEASE:
+                    _joystick.releaseButton(entry.button);
+                    release(timer);
+                    break;
+            }
+        }
+
+        timer = next;
+    }
+
+    return expired;
+}
@@ -0,0 +1,67 @@
+//
+// JoystickTrace.cpp
+//
+
+#include "JoystickTrace.h"
+
+JoystickTrace::JoystickTrace(JoystickClock clock) : _clock(clock) {
+    _lastTime = _clock();
+}
+
+void JoystickTrace::record(uint8_t reportId, const uint8_t data[], uint8_t length) {
+    uint32_t now = _clock();
+    uint32_t interval = (uint32_t) joystickTimeDifference(now, _lastTime);
+    _lastTime = now;
+
+    if (length > JOYSTICK_REPORT_SIZE_MAXIMUM) {
+        length = JOYSTICK_REPORT_SIZE_MAXIMUM;
+    }
+
+    JoystickTraceEntry &entry = _entries[_next];
+    entry.interval = (interval > 0xFFFF) ? 0xFFFF : (uint16_t) interval;
+    entry.reportId = reportId;
+    entry.length = length;
+    memcpy(entry.data, data, length);
+
+    _next = (_next + 1 < JOYSTICK_TRACE_SIZE) ? _next + 1 : 0;
+    if (_count < JOYSTICK_TRACE_SIZE) {
+        _count++;
+    }
+}
+
+void JoystickTrace::clear() {
+    _next = 0;
+    _count = 0;
+    _lastTime = _clock();
+}
+
+uint8_t JoystickTrace::getCount() const {
+    return _count;
+}
+
+const JoystickTraceEntry &JoystickTrace::getEntry(uint8_t index) const {
+    uint16_t position = (uint16_t) _next + JOYSTICK_TRACE_SIZE - _count + index;
+    return _entries[position % JOYSTICK_TRACE_SIZE];
+}
+
+void JoystickTrace::writeUInt16(Print &output, uint16_t value) {
+    output.write((uint8_t) (value & 0x00FF));
+    output.write((uint8_t) (value >> 8));
+}
+
+void JoystickTrace::dump(Print &output, const Joystick_ &joystick) const {
+    output.write((const uint8_t *) "JTRC", 4);
+    output.write((uint8_t) JOYSTICK_TRACE_VERSION);
+
+    writeUInt16(output, joystick.getDescriptorSize());
+    output.write(joystick.getDescriptor(), joystick.getDescriptorSize());
+
+    writeUInt16(output, _count);
+    for (uint8_t index = 0; index < _count; index++) {
+        const JoystickTraceEntry &entry = getEntry(index);
+        writeUInt16(output, entry.interval);
+        output.write(entry.reportId);
+        output.write(entry.length);
+        output.write(entry.data, entry.length);
+    }
+}
@@ -0,0 +1,56 @@
+//
+// BenchSupport.h
+//
+// Timing helper for the host benchmarks. Figures are for the host CPU and
+// only useful for comparing implementations against each other; the cycle
+// count is read from the time-stamp counter on x86 and left out elsewhere.
+//
+
+#ifndef BENCH_SUPPORT_H
+#define BENCH_SUPPORT_H
+
+#include <chrono>
+#include <cstdio>
+#include "ArduinoMock.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_CYCLES 1
+#endif
+
+// Keeps results alive so the measured calls are not optimised out
+extern volatile int32_t benchSink;
+
+struct BenchResult {
+    double nanoseconds;   // per call
+    double cycles;        // per call, 0 without a cycle counter
+};
+
+template<typename Function>
+BenchResult benchmark(const char *name, uint32_t iterations, Function function) {
+    // Warm up caches and branch predictors
+    for (uint32_t index = 0; index < iterations / 16; index++) {
+        function(index);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+#ifdef BENCH_HAS_CYCLES
+    uint64_t startCycles = __rdtsc();
+#endif
+    for (uint32_t index = 0; index < iterations; index++) {
+        function(index);
+    }
+    BenchResult result;
+#ifdef BENCH_HAS_CYCLES
+    result.cycles = (double) (__rdtsc() - startCycles) / iterations;
+#else
+    result.cycles = 0;
+#endif
+    result.nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                         iterations;
+
+    printf("  %-32s %8.1f ns %8.1f cycles\n", name, result.nanoseconds, result.cycles);
+    return result;
+}
+
+#endif // BENCH_SUPPORT_H
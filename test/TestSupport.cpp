@@ -0,0 +1,7 @@
+//
+// TestSupport.cpp
+//
+
+#include "TestSupport.h"
+
+int testFailures = 0;
@@ -0,0 +1,59 @@
+//
+// TestSupport.h
+//
+// Minimal assertion helpers for the host tests. Each test file is its own
+// program; main() runs the test functions with RUN_TEST and returns
+// testResult().
+//
+
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include <cstdio>
+#include "ArduinoMock.h"
+
+extern int testFailures;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQUAL(expected, actual) \
+    do { \
+        long long _expected = (long long) (expected); \
+        long long _actual = (long long) (actual); \
+        if (_expected != _actual) { \
+            printf("%s:%d: %s == %s failed: %lld != %lld\n", __FILE__, __LINE__, #expected, #actual, \
+                   _expected, _actual); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(expected, actual, tolerance) \
+    do { \
+        double _expected = (double) (expected); \
+        double _actual = (double) (actual); \
+        if ((_actual < _expected - (tolerance)) || (_actual > _expected + (tolerance))) { \
+            printf("%s:%d: %s ~ %s failed: %g != %g\n", __FILE__, __LINE__, #expected, #actual, \
+                   _expected, _actual); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define RUN_TEST(test) \
+    do { \
+        mockReset(); \
+        int _failures = testFailures; \
+        test(); \
+        printf("%s %s\n", (testFailures == _failures) ? "PASS" : "FAIL", #test); \
+    } while (0)
+
+inline int testResult() {
+    return (testFailures == 0) ? 0 : 1;
+}
+
+#endif // TEST_SUPPORT_H
@@ -0,0 +1,230 @@
+//
+// bench_link.cpp
+//
+// Frames per second and latency for 1 to 8 nodes. Every node changes an axis
+// and a button in each frame.
+//
+// The loopback runs one writer thread per node on a pipe shared like a bus
+// line. Each frame is timestamped before its write() and again after the
+// decoder's applyFrame(), so the latency covers the transport, framing and
+// decoding on the host. Writers are paced (1 kHz per node) and then flood
+// the pipe to find the throughput.
+//
+// The line table adds the serial transfer time at 10 bits per byte (8N1) with
+// the nodes taking turns; it is computed from the frame size, not measured.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "TestSupport.h"
+#include "JoystickLink.h"
+
+#define ROUNDS          20000
+#define LOOPBACK_FRAMES  1000
+#define PACED_PERIOD_NS  1000000
+
+static const uint32_t baudRates[] = {115200, 1000000};
+
+typedef std::chrono::steady_clock BenchClock;
+
+static int64_t nowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now().time_since_epoch()).count();
+}
+
+static void encodeRound(JoystickLinkEncoder &encoder, uint8_t node, uint32_t round) {
+    encoder.setField(JOYSTICK_FIELD_X_AXIS, (int32_t) ((round * 37 + node) % 1024));
+    encoder.setButton(node, round & 1);
+}
+
+static JoystickBuilder createBuilder() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(32).includeXAxis(true).includeYAxis(true);
+    return builder;
+}
+
+struct LoopbackResult {
+    double framesPerSecond;
+    double median;    // latencies in microseconds
+    double p99;
+    double maximum;
+};
+
+static LoopbackResult runLoopback(uint8_t nodeCount, bool paced) {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(false);
+    JoystickLinkDecoder decoder(joystick);
+
+    int line[2];
+    if (pipe(line) != 0) {
+        perror("pipe");
+        exit(1);
+    }
+
+    // Send time of every frame, by node and frame number
+    std::vector<std::vector<std::atomic<int64_t>>> sendTimes(nodeCount);
+    for (std::vector<std::atomic<int64_t>> &times: sendTimes) {
+        times = std::vector<std::atomic<int64_t>>(LOOPBACK_FRAMES);
+    }
+
+    int64_t start = nowNanoseconds();
+    std::vector<std::thread> writers;
+    for (uint8_t node = 0; node < nodeCount; node++) {
+        writers.emplace_back([&, node]() {
+            JoystickLinkEncoder encoder(node);
+            uint8_t frame[JOYSTICK_LINK_FRAME_MAXIMUM];
+            // Nodes start spread over the period like on a shared line
+            int64_t due = start + (int64_t) PACED_PERIOD_NS * node / nodeCount;
+
+            for (uint32_t index = 0; index < LOOPBACK_FRAMES; index++) {
+                encodeRound(encoder, node, index);
+                uint8_t length = encoder.encode(frame);
+                if (paced) {
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(due - nowNanoseconds()));
+                    due += PACED_PERIOD_NS;
+                }
+                // Writes up to PIPE_BUF bytes are atomic, so frames of
+                // different nodes never interleave
+                sendTimes[node][index].store(nowNanoseconds(), std::memory_order_release);
+                if (write(line[1], frame, length) != length) {
+                    perror("write");
+                    exit(1);
+                }
+            }
+        });
+    }
+
+    // Reader: frames the stream and hands each frame to applyFrame()
+    std::vector<double> latencies;
+    std::vector<uint32_t> received(nodeCount, 0);
+    uint32_t frameCount = (uint32_t) nodeCount * LOOPBACK_FRAMES;
+    uint8_t buffer[4096];
+    size_t buffered = 0;
+
+    while (latencies.size() < frameCount) {
+        ssize_t count = read(line[0], buffer + buffered, sizeof(buffer) - buffered);
+        if (count <= 0) {
+            perror("read");
+            exit(1);
+        }
+        buffered += (size_t) count;
+
+        size_t offset = 0;
+        while ((buffered - offset >= JOYSTICK_LINK_HEADER_SIZE) &&
+               (buffered - offset >= (size_t) JOYSTICK_LINK_HEADER_SIZE + buffer[offset + 1] + 2)) {
+            const uint8_t *frame = buffer + offset;
+            uint8_t length = (uint8_t) (JOYSTICK_LINK_HEADER_SIZE + frame[1] + 2);
+            if (!decoder.applyFrame(frame, length)) {
+                printf("  frame rejected\n");
+                exit(1);
+            }
+            int64_t appliedTime = nowNanoseconds();
+
+            uint8_t node = frame[2] & JOYSTICK_LINK_NODE_MASK;
+            int64_t sendTime = sendTimes[node][received[node]++].load(std::memory_order_acquire);
+            latencies.push_back((double) (appliedTime - sendTime) / 1000);
+            offset += length;
+        }
+        memmove(buffer, buffer + offset, buffered - offset);
+        buffered -= offset;
+    }
+    double elapsed = (double) (nowNanoseconds() - start) / 1e9;
+
+    for (std::thread &writer: writers) {
+        writer.join();
+    }
+    close(line[0]);
+    close(line[1]);
+
+    std::sort(latencies.begin(), latencies.end());
+    LoopbackResult result;
+    result.framesPerSecond = frameCount / elapsed;
+    result.median = latencies[latencies.size() / 2];
+    result.p99 = latencies[latencies.size() * 99 / 100];
+    result.maximum = latencies.back();
+    return result;
+}
+
+static void benchLoopback() {
+    printf("  pipe loopback, %u frames per node\n", LOOPBACK_FRAMES);
+    printf("  nodes | paced: frames/s  median us  p99 us  max us | flooded: frames/s  median us  p99 us  max us\n");
+
+    for (uint8_t nodeCount = 1; nodeCount <= JOYSTICK_LINK_NODE_COUNT; nodeCount++) {
+        LoopbackResult paced = runLoopback(nodeCount, true);
+        LoopbackResult flooded = runLoopback(nodeCount, false);
+        printf("  %5u | %15.0f %10.1f %7.1f %7.1f | %17.0f %10.1f %7.1f %7.1f\n", nodeCount,
+               paced.framesPerSecond, paced.median, paced.p99, paced.maximum,
+               flooded.framesPerSecond, flooded.median, flooded.p99, flooded.maximum);
+    }
+}
+
+static int benchLine() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(false);
+
+    printf("  serial line (computed), host decoding measured\n");
+    printf("  nodes  bytes  decode ns");
+    for (uint32_t baudRate: baudRates) {
+        printf(" | %7u baud: frames/s per node, worst-case latency us", baudRate);
+    }
+    printf("\n");
+
+    for (uint8_t nodeCount = 1; nodeCount <= JOYSTICK_LINK_NODE_COUNT; nodeCount++) {
+        std::vector<JoystickLinkEncoder> encoders;
+        for (uint8_t node = 0; node < nodeCount; node++) {
+            encoders.emplace_back(node);
+        }
+
+        // The stream as it appears on the line
+        std::vector<uint8_t> stream;
+        uint8_t frame[JOYSTICK_LINK_FRAME_MAXIMUM];
+        for (uint32_t round = 0; round < ROUNDS; round++) {
+            for (uint8_t node = 0; node < nodeCount; node++) {
+                encodeRound(encoders[node], node, round);
+                uint8_t length = encoders[node].encode(frame);
+                stream.insert(stream.end(), frame, frame + length);
+            }
+        }
+
+        uint32_t frameCount = ROUNDS * nodeCount;
+        double frameBytes = (double) stream.size() / frameCount;
+
+        JoystickLinkDecoder decoder(joystick);
+        auto start = BenchClock::now();
+        for (size_t offset = 0; offset < stream.size(); offset += 0x8000) {
+            size_t length = stream.size() - offset;
+            decoder.feed(&stream[offset], (uint16_t) ((length > 0x8000) ? 0x8000 : length));
+        }
+        double decodeTime = std::chrono::duration<double, std::nano>(BenchClock::now() - start).count() /
+                            frameCount;
+        mockReports.clear();
+
+        if (decoder.getFrameCount() != frameCount) {
+            printf("  %u of %u frames decoded\n", decoder.getFrameCount(), frameCount);
+            return 1;
+        }
+
+        printf("  %5u %6.1f %10.1f", nodeCount, frameBytes, decodeTime);
+        for (uint32_t baudRate: baudRates) {
+            // A frame waits for at most one frame of every other node, its
+            // own transfer and its decoding
+            double frameTime = frameBytes * 10 * 1e6 / baudRate;
+            double frameRate = 1e6 / (frameTime * nodeCount);
+            double latency = frameTime * nodeCount + decodeTime / 1000;
+            printf(" | %35.0f, %19.1f", frameRate, latency);
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
+
+int main() {
+    benchLoopback();
+    return benchLine();
+}
@@ -0,0 +1,51 @@
+//
+// bench_motion.cpp
+//
+// Per-sample cost of the fixed-point math and of one IMU filter step.
+//
+
+#include "BenchSupport.h"
+#include "JoystickMath.h"
+#include "JoystickMotion.h"
+
+#define ITERATIONS 1000000
+
+volatile int32_t benchSink;
+
+int main() {
+    benchmark("joystickSqrt", ITERATIONS, [](uint32_t index) {
+        benchSink = joystickSqrt(index * 2147u);
+    });
+
+    benchmark("joystickAtan2", ITERATIONS, [](uint32_t index) {
+        benchSink = joystickAtan2((int32_t) (index % 65536) - 32768, 16384);
+    });
+
+    benchmark("joystickSin", ITERATIONS, [](uint32_t index) {
+        benchSink = joystickSin((uint16_t) index);
+    });
+
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.includeRxAxis(true).includeRyAxis(true).includeRzAxis(true);
+    Joystick_ joystick(builder);
+    joystick.begin(false);
+
+    JoystickMotion motion(joystick);
+    motion.begin(0, 0, 16384);
+
+    // A slow wobble, reported at every sample
+    benchmark("JoystickMotion::update", ITERATIONS, [&](uint32_t index) {
+        int16_t tilt = joystickSin((uint16_t) (index * 8)) / 8;
+        benchSink = motion.update(tilt, (int16_t) (tilt / 2), 16384, 100, -50, 25);
+        mockReports.clear();
+    });
+
+    motion.setReportDivider(8);
+    benchmark("JoystickMotion::update, 1 in 8", ITERATIONS, [&](uint32_t index) {
+        int16_t tilt = joystickSin((uint16_t) (index * 8)) / 8;
+        benchSink = motion.update(tilt, (int16_t) (tilt / 2), 16384, 100, -50, 25);
+        mockReports.clear();
+    });
+
+    return 0;
+}
@@ -0,0 +1,79 @@
+//
+// bench_static.cpp
+//
+// Cost of one report update (five analog fields, a button and sendState) for
+// Joystick_ against JoystickStatic with the same layout. `make -C test size`
+// prints the host code size of both.
+//
+
+#include "BenchSupport.h"
+#include "JoystickStatic.h"
+
+#define ITERATIONS 1000000
+
+volatile int32_t benchSink;
+
+struct PedalConfig : JoystickStaticConfig {
+    static constexpr uint8_t buttonCount = 12;
+    static constexpr uint8_t hatSwitchCount = 1;
+    static constexpr uint8_t axisFlags = JOYSTICK_INCLUDE_X_AXIS | JOYSTICK_INCLUDE_Y_AXIS | JOYSTICK_INCLUDE_RZ_AXIS;
+    static constexpr uint8_t simulatorFlags = JOYSTICK_INCLUDE_THROTTLE | JOYSTICK_INCLUDE_BRAKE;
+
+    static constexpr int32_t yAxisMinimum = -500;
+    static constexpr int32_t yAxisMaximum = 500;
+    static constexpr int32_t brakeMinimum = 4095;
+    static constexpr int32_t brakeMaximum = 0;
+};
+
+__attribute__((noinline)) void updateDynamic(Joystick_ &joystick, int32_t value) {
+    joystick.setXAxis(value);
+    joystick.setYAxis(value - 500);
+    joystick.setRzAxis(value);
+    joystick.setThrottle(value);
+    joystick.setBrake(value * 4);
+    joystick.setButton(value % 12, value & 1);
+    joystick.sendState();
+}
+
+__attribute__((noinline)) void updateStatic(JoystickStatic<PedalConfig> &joystick, int32_t value) {
+    joystick.setXAxis(value);
+    joystick.setYAxis(value - 500);
+    joystick.setRzAxis(value);
+    joystick.setThrottle(value);
+    joystick.setBrake(value * 4);
+    joystick.setButton(value % 12, value & 1);
+    joystick.sendState();
+}
+
+int main() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(PedalConfig::buttonCount)
+            .setHatSwitchCount(PedalConfig::hatSwitchCount)
+            .includeAxes(PedalConfig::axisFlags)
+            .includeSimulatorControls(PedalConfig::simulatorFlags);
+    Joystick_ joystick(builder);
+    joystick.setYAxisRange(-500, 500);
+    joystick.setBrakeRange(4095, 0);
+    joystick.begin(false);
+
+    JoystickStatic<PedalConfig> joystickStatic;
+    joystickStatic.begin(false);
+
+    benchmark("Joystick_", ITERATIONS, [&](uint32_t index) {
+        updateDynamic(joystick, (int32_t) (index % 1024));
+        mockReports.clear();
+    });
+    benchmark("JoystickStatic", ITERATIONS, [&](uint32_t index) {
+        updateStatic(joystickStatic, (int32_t) (index % 1024));
+        mockReports.clear();
+    });
+
+    // The mock SendReport copies the report into a vector, which is part of
+    // both figures above
+    benchmark("sendState alone", ITERATIONS, [&](uint32_t index) {
+        joystickStatic.sendState();
+        mockReports.clear();
+    });
+
+    return 0;
+}
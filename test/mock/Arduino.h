@@ -0,0 +1,73 @@
+//
+// Arduino.h
+//
+// Host replacement for the parts of the Arduino core used by the library.
+// Time, pins and analog inputs are driven by the tests (see ArduinoMock.h).
+//
+
+#ifndef ARDUINO_MOCK_H
+#define ARDUINO_MOCK_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#define HIGH 1
+#define LOW  0
+
+#define INPUT        0
+#define OUTPUT       1
+#define INPUT_PULLUP 2
+
+#define MSBFIRST 1
+#define LSBFIRST 0
+
+#define B00001111 0x0F
+
+#define bitRead(value, bit)  (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit)   ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+
+using std::min;
+using std::max;
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+unsigned long micros();
+unsigned long millis();
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+void noInterrupts();
+void interrupts();
+
+class Print {
+public:
+    virtual ~Print() = default;
+
+    virtual size_t write(uint8_t value);
+
+    size_t write(const uint8_t buffer[], size_t size);
+
+    size_t print(const char text[]);
+    size_t print(long value);
+    size_t print(unsigned long value);
+    size_t print(int value);
+    size_t print(unsigned int value);
+
+    size_t println(const char text[] = "");
+    size_t println(long value);
+    size_t println(unsigned long value);
+};
+
+extern Print Serial;
+
+#endif // ARDUINO_MOCK_H
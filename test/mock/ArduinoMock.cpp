@@ -0,0 +1,137 @@
+//
+// ArduinoMock.cpp
+//
+
+#include <cstdio>
+#include "ArduinoMock.h"
+#include "EEPROM.h"
+#include "HID.h"
+#include "SPI.h"
+#include "Wire.h"
+
+uint32_t mockMicros = 0;
+int mockPins[MOCK_PIN_COUNT];
+int mockAnalogPins[MOCK_PIN_COUNT];
+std::vector<std::vector<uint8_t>> mockReports;
+uint8_t mockEeprom[MOCK_EEPROM_SIZE];
+uint32_t mockEepromWrites = 0;
+
+Print Serial;
+SPIClass SPI;
+TwoWire Wire;
+EEPROMClass EEPROM;
+
+void mockReset() {
+    mockMicros = 0;
+    memset(mockPins, 0, sizeof(mockPins));
+    memset(mockAnalogPins, 0, sizeof(mockAnalogPins));
+    mockReports.clear();
+    memset(mockEeprom, 0xFF, sizeof(mockEeprom));
+    mockEepromWrites = 0;
+}
+
+uint32_t mockClock() {
+    return mockMicros;
+}
+
+unsigned long micros() {
+    return mockMicros;
+}
+
+unsigned long millis() {
+    return mockMicros / 1000;
+}
+
+void delayMicroseconds(unsigned int us) {
+    mockMicros += us;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+void digitalWrite(uint8_t pin, uint8_t value) {}
+
+int digitalRead(uint8_t pin) {
+    return (pin < MOCK_PIN_COUNT) ? mockPins[pin] : LOW;
+}
+
+int analogRead(uint8_t pin) {
+    return (pin < MOCK_PIN_COUNT) ? mockAnalogPins[pin] : 0;
+}
+
+void noInterrupts() {}
+
+void interrupts() {}
+
+size_t Print::write(uint8_t value) {
+    fputc(value, stdout);
+    return 1;
+}
+
+size_t Print::write(const uint8_t buffer[], size_t size) {
+    for (size_t index = 0; index < size; index++) {
+        write(buffer[index]);
+    }
+    return size;
+}
+
+// Everything goes through write(), as on the boards, so a Print subclass
+// sees the text
+size_t Print::print(const char text[]) {
+    return write((const uint8_t *) text, strlen(text));
+}
+
+size_t Print::print(long value) {
+    char text[24];
+    snprintf(text, sizeof(text), "%ld", value);
+    return print(text);
+}
+
+size_t Print::print(unsigned long value) {
+    char text[24];
+    snprintf(text, sizeof(text), "%lu", value);
+    return print(text);
+}
+
+size_t Print::print(int value) {
+    return print((long) value);
+}
+
+size_t Print::print(unsigned int value) {
+    return print((unsigned long) value);
+}
+
+size_t Print::println(const char text[]) {
+    return print(text) + print("\n");
+}
+
+size_t Print::println(long value) {
+    return print(value) + print("\n");
+}
+
+size_t Print::println(unsigned long value) {
+    return print(value) + print("\n");
+}
+
+int HID_::SendReport(uint8_t id, const void *data, int length) {
+    std::vector<uint8_t> report;
+    report.push_back(id);
+    report.insert(report.end(), (const uint8_t *) data, (const uint8_t *) data + length);
+    mockReports.push_back(report);
+    return length;
+}
+
+void HID_::AppendDescriptor(HIDSubDescriptor *descriptor) {}
+
+HID_ &HID() {
+    static HID_ hid;
+    return hid;
+}
+
+uint8_t EEPROMClass::read(int address) {
+    return mockEeprom[address];
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+    mockEeprom[address] = value;
+    mockEepromWrites++;
+}
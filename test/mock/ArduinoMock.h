@@ -0,0 +1,34 @@
+//
+// ArduinoMock.h
+//
+// Controls and observations of the host Arduino core
+//
+
+#ifndef ARDUINO_MOCK_CONTROL_H
+#define ARDUINO_MOCK_CONTROL_H
+
+#include <vector>
+#include "Arduino.h"
+#include "EEPROM.h"
+
+#define MOCK_PIN_COUNT 64
+
+// Simulated time returned by micros(); advanced only by the tests
+extern uint32_t mockMicros;
+
+// Levels returned by digitalRead / analogRead
+extern int mockPins[MOCK_PIN_COUNT];
+extern int mockAnalogPins[MOCK_PIN_COUNT];
+
+// Reports passed to HID().SendReport, report ID first
+extern std::vector<std::vector<uint8_t>> mockReports;
+
+extern uint8_t mockEeprom[MOCK_EEPROM_SIZE];
+extern uint32_t mockEepromWrites;
+
+void mockReset();
+
+// JoystickClock backed by mockMicros
+uint32_t mockClock();
+
+#endif // ARDUINO_MOCK_CONTROL_H
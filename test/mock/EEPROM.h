@@ -0,0 +1,29 @@
+//
+// EEPROM.h
+//
+
+#ifndef EEPROM_MOCK_H
+#define EEPROM_MOCK_H
+
+#include "Arduino.h"
+
+#define MOCK_EEPROM_SIZE 1024
+
+class EEPROMClass {
+public:
+    uint8_t read(int address);
+
+    void write(int address, uint8_t value);
+
+    uint16_t length() {
+        return MOCK_EEPROM_SIZE;
+    }
+
+    bool commit() {
+        return true;
+    }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // EEPROM_MOCK_H
@@ -0,0 +1,31 @@
+//
+// HID.h
+//
+// Host replacement for the PluggableUSB HID class. Sent reports are recorded
+// in mockReports.
+//
+
+#ifndef HID_MOCK_H
+#define HID_MOCK_H
+
+#include "Arduino.h"
+
+class HIDSubDescriptor {
+public:
+    HIDSubDescriptor(const void *data, uint16_t length) : data(data), length(length) {}
+
+    const void *data;
+    uint16_t length;
+    HIDSubDescriptor *next = nullptr;
+};
+
+class HID_ {
+public:
+    int SendReport(uint8_t id, const void *data, int length);
+
+    void AppendDescriptor(HIDSubDescriptor *descriptor);
+};
+
+HID_ &HID();
+
+#endif // HID_MOCK_H
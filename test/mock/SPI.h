@@ -0,0 +1,37 @@
+//
+// SPI.h
+//
+
+#ifndef SPI_MOCK_H
+#define SPI_MOCK_H
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0
+#define SPI_MODE2 2
+
+class SPISettings {
+public:
+    SPISettings() = default;
+
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) {}
+};
+
+class SPIClass {
+public:
+    void begin() {}
+
+    void beginTransaction(SPISettings settings) {}
+
+    void endTransaction() {}
+
+    uint8_t transfer(uint8_t value) {
+        return value;
+    }
+
+    void transfer(void *buffer, size_t length) {}
+};
+
+extern SPIClass SPI;
+
+#endif // SPI_MOCK_H
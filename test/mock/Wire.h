@@ -0,0 +1,47 @@
+//
+// Wire.h
+//
+
+#ifndef WIRE_MOCK_H
+#define WIRE_MOCK_H
+
+#include "Arduino.h"
+
+// Acknowledges every transfer and reads zeros; drivers are tested through
+// simulated JoystickI2cBus devices instead.
+class TwoWire {
+public:
+    void begin() {}
+
+    void setClock(uint32_t clock) {}
+
+    void beginTransmission(uint8_t address) {}
+
+    size_t write(uint8_t value) {
+        return 1;
+    }
+
+    size_t write(const uint8_t data[], size_t length) {
+        return length;
+    }
+
+    uint8_t endTransmission(bool stop = true) {
+        return 0;
+    }
+
+    uint8_t requestFrom(uint8_t address, uint8_t length) {
+        return length;
+    }
+
+    int read() {
+        return 0;
+    }
+
+    int available() {
+        return 0;
+    }
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_MOCK_H
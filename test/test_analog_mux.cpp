@@ -0,0 +1,120 @@
+//
+// test_analog_mux.cpp
+//
+
+#include "TestSupport.h"
+#include "JoystickAnalogMux.h"
+
+#define CONVERSION_TIME 13
+
+// Mux whose output reflects the selected channel; conversions take
+// CONVERSION_TIME microseconds of simulated time
+class SimulatedMux : public JoystickAnalogInput {
+public:
+    int16_t levels[JOYSTICK_ANALOG_MUX_CHANNEL_MAXIMUM] = {0};
+    uint8_t selected = 0;
+    uint32_t selectTime = 0;
+    uint32_t conversionStart = 0;
+    uint32_t shortestSettling = 0xFFFFFFFF;
+    bool converting = false;
+
+    void selectChannel(uint8_t channel) override {
+        selected = channel;
+        selectTime = mockMicros;
+    }
+
+    void startConversion() override {
+        uint32_t settling = mockMicros - selectTime;
+        if (settling < shortestSettling) shortestSettling = settling;
+        conversionStart = mockMicros;
+        converting = true;
+    }
+
+    bool conversionReady() override {
+        return converting && (mockMicros - conversionStart >= CONVERSION_TIME);
+    }
+
+    int16_t readConversion() override {
+        converting = false;
+        return levels[selected];
+    }
+};
+
+static void run(JoystickAnalogMux &mux, uint32_t duration) {
+    for (uint32_t end = mockMicros + duration; mockMicros < end; mockMicros++) {
+        mux.update();
+    }
+}
+
+static void testSweepAppliedAsOneReport() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    Joystick_ joystick(builder);
+    SimulatedMux input;
+    JoystickAnalogMux mux(joystick, input, mockClock);
+    joystick.begin(true);
+
+    mux.assignChannel(2, JOYSTICK_FIELD_X_AXIS);
+    mux.assignChannel(5, JOYSTICK_FIELD_Y_AXIS);
+    mux.assignChannel(9, JOYSTICK_FIELD_THROTTLE);
+    input.levels[2] = 1023;
+    input.levels[5] = 0;
+    input.levels[9] = 512;
+    mockReports.clear();
+
+    while (mux.getSweepCount() == 0) {
+        mockMicros++;
+        mux.update();
+    }
+
+    CHECK_EQUAL(1, mockReports.size());
+    CHECK_EQUAL(1023, mux.getChannelValue(2));
+    CHECK_EQUAL(512, mux.getChannelValue(9));
+    CHECK_EQUAL(JOYSTICK_RADIAL_MAXIMUM, joystick.getAxisPosition(JOYSTICK_FIELD_X_AXIS));
+    CHECK_EQUAL(-JOYSTICK_RADIAL_MAXIMUM, joystick.getAxisPosition(JOYSTICK_FIELD_Y_AXIS));
+}
+
+static void testSettlingTimeAndSweepRate() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    Joystick_ joystick(builder);
+    SimulatedMux input;
+    JoystickAnalogMux mux(joystick, input, mockClock);
+    joystick.begin(false);
+
+    for (uint8_t channel = 0; channel < 8; channel++) {
+        mux.assignChannel(channel, (JoystickField) channel);
+    }
+    mux.setSettlingTime(20);
+
+    run(mux, 100000);
+
+    // The next channel settles while a result is handled, so a channel costs
+    // the settling time plus the conversion, polled once per microsecond
+    CHECK(input.shortestSettling >= 20);
+    CHECK_NEAR(8 * (20 + CONVERSION_TIME), mux.getSweepDuration(), 8 * 2);
+    CHECK(mux.getSweepCount() >= 100000 / (8 * (20 + CONVERSION_TIME + 2)));
+}
+
+static void testUnassignRestartsSweep() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    Joystick_ joystick(builder);
+    SimulatedMux input;
+    JoystickAnalogMux mux(joystick, input, mockClock);
+    joystick.begin(false);
+
+    mux.assignChannel(0, JOYSTICK_FIELD_X_AXIS);
+    mux.assignChannel(1, JOYSTICK_FIELD_Y_AXIS);
+    run(mux, 1000);
+    mux.unassignChannel(1);
+
+    uint32_t sweeps = mux.getSweepCount();
+    run(mux, 1000);
+    CHECK(input.selected == 0);
+    CHECK(mux.getSweepCount() > sweeps);
+}
+
+int main() {
+    RUN_TEST(testSweepAppliedAsOneReport);
+    RUN_TEST(testSettlingTimeAndSweepRate);
+    RUN_TEST(testUnassignRestartsSweep);
+    return testResult();
+}
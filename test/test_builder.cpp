@@ -0,0 +1,175 @@
+//
+// test_builder.cpp
+//
+// Report planning against the descriptor the builder actually writes: the
+// compile-time descriptor size, and report bits and padding summed up from
+// the descriptor's input items.
+//
+
+#include "TestSupport.h"
+#include "Joystick.h"
+
+struct DescriptorBits {
+    uint16_t dataBits;
+    uint16_t constantBits;
+};
+
+// Sums the input items of a descriptor; short items only
+static DescriptorBits parseInputBits(const uint8_t descriptor[], uint16_t length) {
+    DescriptorBits bits = {0, 0};
+    uint32_t reportSize = 0;
+    uint32_t reportCount = 0;
+
+    for (uint16_t index = 0; index < length;) {
+        uint8_t prefix = descriptor[index];
+        uint8_t size = prefix & 0x03;
+        if (size == 3) size = 4;
+
+        uint32_t value = 0;
+        for (uint8_t offset = 0; offset < size; offset++) {
+            value |= (uint32_t) descriptor[index + 1 + offset] << (8 * offset);
+        }
+
+        switch (prefix & 0xFC) {
+            case 0x74:   // REPORT_SIZE
+                reportSize = value;
+                break;
+            case 0x94:   // REPORT_COUNT
+                reportCount = value;
+                break;
+            case 0x80:   // INPUT
+                if (value & 0x01) {
+                    bits.constantBits += reportSize * reportCount;
+                } else {
+                    bits.dataBits += reportSize * reportCount;
+                }
+                break;
+            default:
+                break;
+        }
+        index += 1 + size;
+    }
+
+    return bits;
+}
+
+// Checks size and plan of one layout against its built descriptor
+static void checkLayout(const JoystickBuilder &builder) {
+    uint8_t descriptor[JOYSTICK_DESCRIPTOR_SIZE_MAXIMUM];
+    uint8_t length = builder.buildDescriptor(descriptor);
+    CHECK_EQUAL(length, builder.getHidSize());
+
+    JoystickReportPlan plan = builder.plan(1000);
+    DescriptorBits bits = parseInputBits(descriptor, length);
+    CHECK_EQUAL(bits.dataBits + bits.constantBits, plan.reportBits);
+    CHECK_EQUAL(bits.constantBits, plan.paddingBits);
+    CHECK_EQUAL(plan.reportBits / 8, plan.reportSize);
+    CHECK_EQUAL(0, plan.reportBits % 8);
+    CHECK_EQUAL(length, plan.descriptorSize);
+    CHECK_EQUAL(plan.reportSize + 1, plan.transferSize);
+    CHECK_EQUAL((plan.reportSize + 1) * 1000, plan.bandwidth);
+
+    // Packed, the data bits alone need this many bytes
+    CHECK_EQUAL(plan.reportSize - (bits.dataBits + 7) / 8, plan.paddingBytes);
+    CHECK_EQUAL(plan.paddingBytes > 0, plan.wastesPadding);
+
+    JoystickBuilder copy = builder;
+    Joystick_ joystick(copy);
+    CHECK_EQUAL(plan.reportSize, joystick.getReportSize());
+    CHECK_EQUAL(length, joystick.getDescriptorSize());
+}
+
+static void testDescriptorSizeMatchesBuilder() {
+    JoystickBuilder empty(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_GAMEPAD);
+    checkLayout(empty);
+
+    JoystickBuilder defaults(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    defaults.setButtonCount(32).setHatSwitchCount(2).includeAxes(0x3F).includeSimulatorControls(0x1F);
+    checkLayout(defaults);
+
+    JoystickBuilder buttonsOnly(4, JOYSTICK_TYPE_GAMEPAD);
+    buttonsOnly.setButtonCount(13);
+    checkLayout(buttonsOnly);
+
+    JoystickBuilder oneHat(5, JOYSTICK_TYPE_JOYSTICK);
+    oneHat.setButtonCount(4).setHatSwitchCount(1).includeXAxis(true).includeRzAxis(true);
+    checkLayout(oneHat);
+
+    // Alternating absolute and relative axes take one input item each
+    JoystickBuilder alternating(6, JOYSTICK_TYPE_MULTI_AXIS);
+    alternating.setButtonCount(63).setHatSwitchCount(2).includeAxes(0x3F).includeSimulatorControls(0x1F);
+    alternating.setXAxisRelative(true).setZAxisRelative(true).setRyAxisRelative(true);
+    checkLayout(alternating);
+    CHECK_EQUAL(joystickDescriptorSize(63, 2, 0x3F, 0x15, JOYSTICK_SIMULATOR_COUNT), alternating.getHidSize());
+
+    // Relative axes split by an absolute one, and one that is not included
+    JoystickBuilder relative(7, JOYSTICK_TYPE_JOYSTICK);
+    relative.setButtonCount(8).includeXAxis(true).includeYAxis(true).includeRxAxis(true);
+    relative.setXAxisRelative(true).setRxAxisRelative(true).setRzAxisRelative(true);
+    checkLayout(relative);
+
+    JoystickBuilder open(8, JOYSTICK_TYPE_JOYSTICK);
+    open.setButtonCount(16).includeThrottle(true).setApplicationCollectionOpen(true);
+    checkLayout(open);
+}
+
+static void testDescriptorSizeAtCompileTime() {
+    // The default Joystick_ layout
+    static_assert(joystickDescriptorSize(32, 2, 0x3F, 0, JOYSTICK_SIMULATOR_COUNT) == 127,
+                  "Default descriptor size");
+    static_assert(joystickDescriptorSize(0, 0, 0, 0, 0) == 9, "Empty descriptor size");
+    static_assert(joystickAxisRunCount(0x3F, 0x15, true) == 3, "Relative runs");
+    static_assert(joystickAxisRunCount(0x09, 0x29, true) == 1, "Runs skip excluded axes");
+
+    JoystickBuilder defaults(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    defaults.setButtonCount(32).setHatSwitchCount(2).includeAxes(0x3F).includeSimulatorControls(0x1F);
+    CHECK_EQUAL(127, defaults.getHidSize());
+}
+
+static void testPaddingBytes() {
+    // 4 buttons and one hat: 8 data bits in a 2-byte report
+    JoystickBuilder oneHat(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_GAMEPAD);
+    oneHat.setButtonCount(4).setHatSwitchCount(1);
+    JoystickReportPlan plan = oneHat.plan(1000);
+    CHECK_EQUAL(8, plan.paddingBits);
+    CHECK_EQUAL(1, plan.paddingBytes);
+    CHECK(plan.wastesPadding);
+
+    // Padding inside the last button byte costs nothing
+    JoystickBuilder buttons(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_GAMEPAD);
+    buttons.setButtonCount(13).includeXAxis(true);
+    plan = buttons.plan(1000);
+    CHECK_EQUAL(3, plan.paddingBits);
+    CHECK_EQUAL(0, plan.paddingBytes);
+    CHECK(!plan.wastesPadding);
+
+    // 3 + 4 padding bits would fit into one byte with the 9 buttons
+    JoystickBuilder mixed(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_GAMEPAD);
+    mixed.setButtonCount(9).setHatSwitchCount(1);
+    plan = mixed.plan(1000);
+    CHECK_EQUAL(11, plan.paddingBits);
+    CHECK_EQUAL(3, plan.reportSize);
+    CHECK_EQUAL(1, plan.paddingBytes);
+}
+
+static void testBandwidthAndPacketSize() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(32).setHatSwitchCount(2).includeAxes(0x3F).includeSimulatorControls(0x1F);
+
+    JoystickReportPlan plan = builder.plan(1000, 2);
+    CHECK_EQUAL(27, plan.reportSize);
+    CHECK_EQUAL(28 * 1000 * 2, plan.bandwidth);
+    CHECK(!plan.exceedsPacketSize);
+
+    // Low-speed endpoints carry at most 8 bytes
+    plan = builder.plan(125, 1, 8);
+    CHECK(plan.exceedsPacketSize);
+}
+
+int main() {
+    RUN_TEST(testDescriptorSizeMatchesBuilder);
+    RUN_TEST(testDescriptorSizeAtCompileTime);
+    RUN_TEST(testPaddingBytes);
+    RUN_TEST(testBandwidthAndPacketSize);
+    return testResult();
+}
@@ -0,0 +1,220 @@
+//
+// test_config.cpp
+//
+// Configuration blob: sealing and validation, the EEPROM storage against the
+// mock EEPROM, and restoring a joystick from a loaded blob.
+//
+
+#include <vector>
+#include "TestSupport.h"
+#include "JoystickEepromStorage.h"
+#include "JoystickMath.h"
+
+#define CONFIG_ADDRESS 16
+
+static JoystickBuilder createBuilder() {
+    JoystickBuilder builder(5, JOYSTICK_TYPE_GAMEPAD);
+    builder.setButtonCount(20).setHatSwitchCount(1);
+    builder.includeXAxis(true).includeYAxis(true).includeRzAxis(true).includeThrottle(true);
+    builder.setRzAxisRelative(true);
+    return builder;
+}
+
+static void calibrate(Joystick_ &joystick) {
+    joystick.setXAxisRange(12, 1010);
+    joystick.setYAxisRange(1000, 30);
+    joystick.setThrottleRange(-512, 511);
+    joystick.setRadialDeadzone(JOYSTICK_AXIS_PAIR_XY, 2000, 31000, true);
+}
+
+static JoystickConfig createConfig() {
+    JoystickConfig config;
+    memset(&config, 0, sizeof(config));
+
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    calibrate(joystick);
+    builder.captureConfig(config);
+    joystick.captureConfig(config);
+    config.seal();
+    return config;
+}
+
+static uint32_t countDifferences(const uint8_t first[], const uint8_t second[], size_t length) {
+    uint32_t count = 0;
+    for (size_t index = 0; index < length; index++) {
+        if (first[index] != second[index]) count++;
+    }
+    return count;
+}
+
+static void testSealedConfigIsValid() {
+    JoystickConfig config = createConfig();
+    CHECK(config.isValid());
+    CHECK_EQUAL(JOYSTICK_CONFIG_MAGIC, config.magic);
+    CHECK_EQUAL(JOYSTICK_CONFIG_VERSION, config.version);
+    CHECK_EQUAL(sizeof(JoystickConfig), config.size);
+
+    // Sealing again gives the same bytes, trailing padding included
+    JoystickConfig copy = config;
+    size_t end = offsetof(JoystickConfig, crc) + sizeof(config.crc);
+    memset((uint8_t *) &copy + end, 0xAA, sizeof(copy) - end);
+    copy.seal();
+    CHECK_EQUAL(0, memcmp(&config, &copy, sizeof(config)));
+}
+
+static void testRejectsDamagedConfig() {
+    JoystickConfig valid = createConfig();
+
+    JoystickConfig config = valid;
+    config.crc ^= 0x0001;
+    CHECK(!config.isValid());
+
+    config = valid;
+    config.ranges[JOYSTICK_FIELD_X_AXIS].maximum++;
+    CHECK(!config.isValid());
+
+    config = valid;
+    config.magic = 0xFFFF;
+    CHECK(!config.isValid());
+
+    config = valid;
+    config.version = JOYSTICK_CONFIG_VERSION + 1;
+    CHECK(!config.isValid());
+
+    config = valid;
+    config.size = sizeof(JoystickConfig) - 4;
+    CHECK(!config.isValid());
+
+    // A blob of an older layout with a matching CRC is still rejected
+    config = valid;
+    config.version = JOYSTICK_CONFIG_VERSION + 1;
+    config.size = sizeof(JoystickConfig) - 4;
+    config.crc = joystickCrc16((const uint8_t *) &config, offsetof(JoystickConfig, crc));
+    CHECK(!config.isValid());
+}
+
+static void testLoadRejectsBlankOrDamagedEeprom() {
+    JoystickEepromStorage storage;
+    JoystickConfig config;
+
+    // Erased EEPROM reads 0xFF
+    CHECK(!storage.load(config, CONFIG_ADDRESS));
+
+    JoystickConfig valid = createConfig();
+    CHECK(storage.save(valid, CONFIG_ADDRESS));
+    CHECK(storage.load(config, CONFIG_ADDRESS));
+
+    mockEeprom[CONFIG_ADDRESS + offsetof(JoystickConfig, ranges) + 1] ^= 0x10;
+    CHECK(!storage.load(config, CONFIG_ADDRESS));
+
+    // Out of range addresses fail without touching the EEPROM
+    uint32_t writes = mockEepromWrites;
+    CHECK(!storage.save(valid, MOCK_EEPROM_SIZE - sizeof(JoystickConfig) + 1));
+    CHECK(!storage.load(config, MOCK_EEPROM_SIZE - sizeof(JoystickConfig) + 1));
+    CHECK_EQUAL(writes, mockEepromWrites);
+}
+
+static void testSaveWritesChangedBytesOnly() {
+    JoystickEepromStorage storage;
+    JoystickConfig config = createConfig();
+
+    std::vector<uint8_t> before(mockEeprom + CONFIG_ADDRESS, mockEeprom + CONFIG_ADDRESS + sizeof(config));
+    CHECK(storage.save(config, CONFIG_ADDRESS));
+    CHECK_EQUAL(countDifferences(before.data(), (const uint8_t *) &config, sizeof(config)), mockEepromWrites);
+    CHECK_EQUAL(0, memcmp(mockEeprom + CONFIG_ADDRESS, &config, sizeof(config)));
+
+    // Saving the same blob again writes nothing
+    mockEepromWrites = 0;
+    CHECK(storage.save(config, CONFIG_ADDRESS));
+    CHECK_EQUAL(0, mockEepromWrites);
+
+    // One recalibrated range: its bytes and the CRC
+    JoystickConfig previous = config;
+    config.ranges[JOYSTICK_FIELD_THROTTLE].maximum = 400;
+    CHECK(storage.save(config, CONFIG_ADDRESS));
+    uint32_t changed = countDifferences((const uint8_t *) &previous, (const uint8_t *) &config, sizeof(config));
+    CHECK_EQUAL(changed, mockEepromWrites);
+    CHECK(changed <= 3);
+    CHECK(changed >= 1);
+
+    // The neighbouring bytes are left alone
+    CHECK_EQUAL(0xFF, mockEeprom[CONFIG_ADDRESS - 1]);
+    CHECK_EQUAL(0xFF, mockEeprom[CONFIG_ADDRESS + sizeof(config)]);
+}
+
+static void testLoadedLayoutBuildsSameDescriptor() {
+    JoystickEepromStorage storage;
+    JoystickConfig saved = createConfig();
+    CHECK(storage.save(saved, CONFIG_ADDRESS));
+
+    JoystickConfig config;
+    CHECK(storage.load(config, CONFIG_ADDRESS));
+
+    JoystickBuilder original = createBuilder();
+    JoystickBuilder restored(config);
+    uint8_t originalDescriptor[JOYSTICK_DESCRIPTOR_SIZE_MAXIMUM];
+    uint8_t restoredDescriptor[JOYSTICK_DESCRIPTOR_SIZE_MAXIMUM];
+    uint8_t length = original.buildDescriptor(originalDescriptor);
+    CHECK_EQUAL(length, restored.buildDescriptor(restoredDescriptor));
+    CHECK_EQUAL(0, memcmp(originalDescriptor, restoredDescriptor, length));
+    CHECK_EQUAL(original.getRelativeAxisFlags(), restored.getRelativeAxisFlags());
+
+    // The calibrated joystick and the restored one send the same reports
+    Joystick_ calibrated(original);
+    calibrate(calibrated);
+    Joystick_ joystick(restored);
+    joystick.applyConfig(config);
+
+    calibrated.begin(false);
+    joystick.begin(false);
+    for (Joystick_ *target: {&calibrated, &joystick}) {
+        target->setXAxis(700);
+        target->setYAxis(200);
+        target->setThrottle(-100);
+        target->moveAxis(JOYSTICK_FIELD_RZ_AXIS, -40);
+        target->setHatSwitch(0, 90);
+        target->pressButton(17);
+        target->sendState();
+    }
+    CHECK_EQUAL(calibrated.getReportSize(), joystick.getReportSize());
+    CHECK_EQUAL(0, memcmp(calibrated.getReport(), joystick.getReport(), joystick.getReportSize()));
+}
+
+static void testApplyAndCaptureAreSymmetric() {
+    JoystickConfig config = createConfig();
+
+    JoystickBuilder builder(config);
+    Joystick_ joystick(builder);
+    joystick.applyConfig(config);
+
+    JoystickConfig captured = config;
+    memset(captured.ranges, 0, sizeof(captured.ranges));
+    memset(captured.radialSettings, 0, sizeof(captured.radialSettings));
+    joystick.captureConfig(captured);
+    builder.captureConfig(captured);
+    captured.seal();
+    CHECK_EQUAL(0, memcmp(&config, &captured, sizeof(config)));
+
+    // Defaults survive the round trip as well
+    JoystickBuilder defaultBuilder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    Joystick_ defaults(defaultBuilder);
+    defaults.captureConfig(captured);
+    CHECK_EQUAL(JOYSTICK_DEFAULT_AXIS_MINIMUM, captured.ranges[JOYSTICK_FIELD_X_AXIS].minimum);
+    CHECK_EQUAL(JOYSTICK_DEFAULT_AXIS_MAXIMUM, captured.ranges[JOYSTICK_FIELD_X_AXIS].maximum);
+    CHECK(!captured.radialSettings[JOYSTICK_AXIS_PAIR_XY].enabled);
+    joystick.applyConfig(captured);
+    joystick.setXAxis(300);
+    defaults.setXAxis(300);
+    CHECK_EQUAL(defaults.getAxisPosition(JOYSTICK_FIELD_X_AXIS), joystick.getAxisPosition(JOYSTICK_FIELD_X_AXIS));
+}
+
+int main() {
+    RUN_TEST(testSealedConfigIsValid);
+    RUN_TEST(testRejectsDamagedConfig);
+    RUN_TEST(testLoadRejectsBlankOrDamagedEeprom);
+    RUN_TEST(testSaveWritesChangedBytesOnly);
+    RUN_TEST(testLoadedLayoutBuildsSameDescriptor);
+    RUN_TEST(testApplyAndCaptureAreSymmetric);
+    return testResult();
+}
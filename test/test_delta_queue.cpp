@@ -0,0 +1,148 @@
+//
+// test_delta_queue.cpp
+//
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "TestSupport.h"
+#include "JoystickDeltaQueue.h"
+
+static bool reportButton(const Joystick_ &joystick, uint8_t button) {
+    return (joystick.getReport()[button / 8] >> (button % 8)) & 1;
+}
+
+static JoystickBuilder createBuilder() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(32);
+    return builder;
+}
+
+static void fillQueue(JoystickDeltaQueue &queue) {
+    while (queue.size() < JOYSTICK_DELTA_QUEUE_SIZE) {
+        queue.pushField(JOYSTICK_FIELD_Z_AXIS, (int32_t) queue.size());
+    }
+}
+
+static void testBatchedApply() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickDeltaQueue queue;
+    joystick.begin(true);
+    mockReports.clear();
+
+    queue.pushButton(3, true);
+    queue.pushButton(9, true);
+    queue.pushField(JOYSTICK_FIELD_X_AXIS, 1023);
+
+    CHECK_EQUAL(3, queue.apply(joystick));
+    CHECK_EQUAL(1, mockReports.size());
+    CHECK(reportButton(joystick, 3));
+    CHECK(reportButton(joystick, 9));
+    CHECK_EQUAL(JOYSTICK_RADIAL_MAXIMUM, joystick.getAxisPosition(JOYSTICK_FIELD_X_AXIS));
+}
+
+static void testDroppedReleaseIsResent() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickDeltaQueue queue;
+    joystick.begin(true);
+
+    queue.pushButton(5, true);
+    fillQueue(queue);
+    CHECK(!queue.pushButton(5, false));
+    CHECK_EQUAL(1, queue.getDroppedCount());
+
+    queue.apply(joystick);
+    CHECK(!reportButton(joystick, 5));
+}
+
+static void testDroppedFieldIsResent() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickDeltaQueue queue;
+    joystick.begin(true);
+
+    fillQueue(queue);
+    CHECK(!queue.pushField(JOYSTICK_FIELD_X_AXIS, 1023));
+
+    queue.apply(joystick);
+    CHECK_EQUAL(JOYSTICK_RADIAL_MAXIMUM, joystick.getAxisPosition(JOYSTICK_FIELD_X_AXIS));
+}
+
+static void testResendWaitsForOlderDeltas() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickDeltaQueue queue;
+    joystick.begin(true);
+
+    // Only older values of X are queued, the newest one overflowed
+    while (queue.size() < JOYSTICK_DELTA_QUEUE_SIZE) {
+        queue.pushField(JOYSTICK_FIELD_X_AXIS, 0);
+    }
+    CHECK(!queue.pushField(JOYSTICK_FIELD_X_AXIS, 1023));
+
+    queue.apply(joystick, 10);
+    CHECK_EQUAL(-JOYSTICK_RADIAL_MAXIMUM, joystick.getAxisPosition(JOYSTICK_FIELD_X_AXIS));
+
+    queue.apply(joystick);
+    CHECK_EQUAL(JOYSTICK_RADIAL_MAXIMUM, joystick.getAxisPosition(JOYSTICK_FIELD_X_AXIS));
+}
+
+// One producer thread toggling buttons and moving an axis as fast as it can,
+// one consumer applying batches. Drops are expected; the final state must
+// still match the producer's.
+static void testConcurrentStress() {
+    const uint32_t deltaCount = 2000000;
+
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickDeltaQueue queue;
+    joystick.begin(true);
+
+    std::atomic<bool> done{false};
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread producer([&] {
+        for (uint32_t index = 0; index < deltaCount; index++) {
+            if (index % 2) {
+                queue.pushButton((uint8_t) ((index / 2) % 32), (index / 64) % 2);
+            } else {
+                queue.pushField(JOYSTICK_FIELD_X_AXIS, (int32_t) (index % 1024));
+            }
+            if ((index % 1024) == 0) std::this_thread::yield();
+        }
+        queue.pushField(JOYSTICK_FIELD_X_AXIS, 1023);
+        done.store(true);
+    });
+
+    uint32_t applied = 0;
+    while (!done.load() || (queue.size() > 0)) {
+        applied += queue.apply(joystick);
+        std::this_thread::yield();
+    }
+    producer.join();
+    applied += queue.apply(joystick);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("  %u deltas applied, %u coalesced after overflow, %.1fM pushes/s\n", applied,
+           queue.getDroppedCount(), (deltaCount + 1) / seconds / 1e6);
+
+    CHECK_EQUAL(deltaCount + 1, applied + queue.getDroppedCount());
+    CHECK_EQUAL(JOYSTICK_RADIAL_MAXIMUM, joystick.getAxisPosition(JOYSTICK_FIELD_X_AXIS));
+    for (uint8_t button = 0; button < 32; button++) {
+        // Level written by the producer's last delta for this button
+        uint32_t last = deltaCount - 1;
+        while ((last % 2 == 0) || ((last / 2) % 32 != button)) last--;
+        CHECK_EQUAL((last / 64) % 2, reportButton(joystick, button));
+    }
+}
+
+int main() {
+    RUN_TEST(testBatchedApply);
+    RUN_TEST(testDroppedReleaseIsResent);
+    RUN_TEST(testDroppedFieldIsResent);
+    RUN_TEST(testResendWaitsForOlderDeltas);
+    RUN_TEST(testConcurrentStress);
+    return testResult();
+}
@@ -0,0 +1,176 @@
+//
+// test_edge_capture.cpp
+//
+
+#include "TestSupport.h"
+#include "JoystickEdgeCapture.h"
+
+#define DEBOUNCE_TIME 5000
+
+static JoystickBuilder createBuilder() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(8);
+    return builder;
+}
+
+static bool reportButton(const Joystick_ &joystick, uint8_t button) {
+    return (joystick.getReport()[button / 8] >> (button % 8)) & 1;
+}
+
+// Interrupt for an active-low input: the pin changes and the handler runs
+static void edge(JoystickEdgeCapture &capture, uint8_t input, uint8_t pin, bool pressed, uint32_t time) {
+    mockMicros = time;
+    mockPins[pin] = pressed ? LOW : HIGH;
+    capture.capture(input);
+}
+
+struct Fixture {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick{builder};
+    JoystickEdgeCapture capture{joystick, mockClock};
+
+    Fixture() {
+        mockPins[4] = HIGH;
+        mockPins[5] = HIGH;
+        capture.addInput(4, 0);
+        capture.addInput(5, 1);
+        capture.setDebounceTime(DEBOUNCE_TIME);
+        joystick.begin(true);
+        capture.begin();
+        mockReports.clear();
+    }
+};
+
+// The first edge counts right away, the bounce after it is ignored
+static void testEagerDebounce() {
+    Fixture fixture;
+
+    edge(fixture.capture, 0, 4, true, 10000);
+    edge(fixture.capture, 0, 4, false, 10100);
+    edge(fixture.capture, 0, 4, true, 10200);
+
+    mockMicros = 10300;
+    CHECK(fixture.capture.update());
+    CHECK(reportButton(fixture.joystick, 0));
+    CHECK_EQUAL(1, mockReports.size());
+    CHECK_EQUAL(300, fixture.capture.getLastLatency());
+    CHECK_EQUAL(3, fixture.capture.getEdgeCount());
+
+    // Settled on the pressed level: nothing more to report
+    mockMicros = 20000;
+    CHECK(!fixture.capture.update());
+    CHECK_EQUAL(1, mockReports.size());
+}
+
+// A bounce that ends on the other level is applied after the debounce time
+static void testSettlesAfterDebounce() {
+    Fixture fixture;
+
+    edge(fixture.capture, 0, 4, true, 10000);
+    edge(fixture.capture, 0, 4, false, 10500);
+
+    mockMicros = 11000;
+    CHECK(fixture.capture.update());
+    CHECK(fixture.capture.isPressed(0));
+
+    mockMicros = 10000 + DEBOUNCE_TIME - 1;
+    CHECK(!fixture.capture.update());
+    CHECK(fixture.capture.isPressed(0));
+
+    mockMicros = 10000 + DEBOUNCE_TIME;
+    CHECK(fixture.capture.update());
+    CHECK(!fixture.capture.isPressed(0));
+    CHECK(!reportButton(fixture.joystick, 0));
+    CHECK_EQUAL(2, mockReports.size());
+}
+
+// Two accepted changes of one input never merge into one report
+static void testPressAndReleaseInOrder() {
+    Fixture fixture;
+
+    edge(fixture.capture, 0, 4, true, 10000);
+    edge(fixture.capture, 0, 4, false, 10000 + DEBOUNCE_TIME + 100);
+
+    mockMicros = 20000;
+    CHECK(fixture.capture.update());
+    CHECK(reportButton(fixture.joystick, 0));
+    CHECK(fixture.capture.update());
+    CHECK(!reportButton(fixture.joystick, 0));
+    CHECK_EQUAL(2, mockReports.size());
+}
+
+static void testSimultaneousInputsOneReport() {
+    Fixture fixture;
+
+    mockMicros = 10000;
+    mockPins[4] = LOW;
+    mockPins[5] = LOW;
+    fixture.capture.captureInputs(0x03, 0x00);
+
+    mockMicros = 10050;
+    CHECK(fixture.capture.update());
+    CHECK(reportButton(fixture.joystick, 0));
+    CHECK(reportButton(fixture.joystick, 1));
+    CHECK_EQUAL(1, mockReports.size());
+}
+
+// Edges beyond the ring are lost, but the pins are read on the next update
+static void testOverflowRecovery() {
+    Fixture fixture;
+    uint32_t time = 10000;
+
+    // Input 0 toggles slower than the debounce time, more often than the
+    // ring holds, and ends pressed
+    for (uint8_t index = 0; index < JOYSTICK_EDGE_QUEUE_SIZE + 7; index++) {
+        edge(fixture.capture, 0, 4, (index % 2) == 0, time);
+        time += DEBOUNCE_TIME + 1;
+    }
+    // Input 1 changes only while the ring is full
+    edge(fixture.capture, 1, 5, true, time);
+    CHECK_EQUAL(8, fixture.capture.getOverflowCount());
+
+    // Every queued edge is applied in order. Input 1 is read together with
+    // the last one; input 0 already changed in that report and follows in
+    // the next.
+    mockMicros = time + 100;
+    int updates = 0;
+    while (fixture.capture.update() && (updates < 2 * JOYSTICK_EDGE_QUEUE_SIZE)) {
+        updates++;
+    }
+    CHECK_EQUAL(JOYSTICK_EDGE_QUEUE_SIZE + 1, updates);
+    CHECK(fixture.capture.isPressed(0));
+    CHECK(fixture.capture.isPressed(1));
+    CHECK(reportButton(fixture.joystick, 0));
+    CHECK(reportButton(fixture.joystick, 1));
+
+    // The ring is usable again
+    edge(fixture.capture, 1, 5, false, mockMicros + DEBOUNCE_TIME);
+    CHECK(fixture.capture.update());
+    CHECK(!fixture.capture.isPressed(1));
+    CHECK_EQUAL(8, fixture.capture.getOverflowCount());
+}
+
+static void testMaximumLatency() {
+    Fixture fixture;
+
+    edge(fixture.capture, 0, 4, true, 10000);
+    mockMicros = 10800;
+    fixture.capture.update();
+
+    edge(fixture.capture, 1, 5, true, 20000);
+    mockMicros = 20100;
+    fixture.capture.update();
+
+    CHECK_EQUAL(100, fixture.capture.getLastLatency());
+    CHECK_EQUAL(800, fixture.capture.getMaximumLatency());
+}
+
+int main() {
+    RUN_TEST(testEagerDebounce);
+    RUN_TEST(testSettlesAfterDebounce);
+    RUN_TEST(testPressAndReleaseInOrder);
+    RUN_TEST(testSimultaneousInputsOneReport);
+    RUN_TEST(testOverflowRecovery);
+    RUN_TEST(testMaximumLatency);
+    return testResult();
+}
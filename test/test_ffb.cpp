@@ -0,0 +1,266 @@
+//
+// test_ffb.cpp
+//
+// Parses the force feedback descriptor and replays the report sequences a
+// host sends to play effects.
+//
+
+#include <map>
+#include "TestSupport.h"
+#include "JoystickForceFeedback.h"
+
+#define FFB_ID(report) (JOYSTICK_FFB_REPORT_ID + (report))
+
+#define MAIN_INPUT   0x8
+#define MAIN_OUTPUT  0x9
+#define MAIN_FEATURE 0xB
+
+// Report sizes in bits per (report ID, main item), collected from a descriptor
+struct DescriptorLayout {
+    std::map<uint16_t, uint32_t> bits;
+    int depth = 0;
+    int minimumDepth = 0;
+    bool valid = true;
+
+    uint32_t bytes(uint8_t reportId, uint8_t main) {
+        return (bits[(uint16_t) ((reportId << 8) | main)] + 7) / 8;
+    }
+};
+
+static DescriptorLayout parseDescriptor(const uint8_t *descriptor, uint16_t length) {
+    DescriptorLayout layout;
+    uint32_t reportSize = 0;
+    uint32_t reportCount = 0;
+    uint8_t reportId = 0;
+
+    for (uint16_t position = 0; position < length;) {
+        uint8_t prefix = descriptor[position];
+        uint8_t size = (uint8_t) ((prefix & 0x03) == 3 ? 4 : (prefix & 0x03));
+        uint8_t type = (prefix >> 2) & 0x03;
+        uint8_t tag = prefix >> 4;
+        uint32_t value = 0;
+
+        if (position + 1 + size > length) {
+            layout.valid = false;
+            break;
+        }
+        for (uint8_t index = 0; index < size; index++) {
+            value |= (uint32_t) descriptor[position + 1 + index] << (8 * index);
+        }
+        position += 1 + size;
+
+        if (type == 0) {
+            if ((tag == MAIN_INPUT) || (tag == MAIN_OUTPUT) || (tag == MAIN_FEATURE)) {
+                layout.bits[(uint16_t) ((reportId << 8) | tag)] += reportSize * reportCount;
+            } else if (tag == 0xA) {
+                layout.depth++;
+            } else if (tag == 0xC) {
+                layout.depth--;
+                if (layout.depth < layout.minimumDepth) layout.minimumDepth = layout.depth;
+            }
+        } else if (type == 1) {
+            if (tag == 0x7) reportSize = value;
+            if (tag == 0x8) reportId = (uint8_t) value;
+            if (tag == 0x9) reportCount = value;
+        }
+    }
+    return layout;
+}
+
+static JoystickBuilder createBuilder() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(8).includeXAxis(true).includeYAxis(true).setApplicationCollectionOpen(true);
+    return builder;
+}
+
+// The report lengths the handlers expect, as declared by the descriptor
+static void testDescriptorLayout() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickForceFeedback forceFeedback(joystick);
+
+    DescriptorLayout layout = parseDescriptor(forceFeedback.getDescriptor(), forceFeedback.getDescriptorSize());
+    CHECK(layout.valid);
+    // Closes the application collection left open by the joystick
+    CHECK_EQUAL(-1, layout.depth);
+    CHECK_EQUAL(-1, layout.minimumDepth);
+
+    CHECK_EQUAL(2, layout.bytes(FFB_ID(JOYSTICK_FFB_REPORT_STATE), MAIN_INPUT));
+    CHECK_EQUAL(10, layout.bytes(FFB_ID(JOYSTICK_FFB_REPORT_SET_EFFECT), MAIN_OUTPUT));
+    CHECK_EQUAL(14, layout.bytes(FFB_ID(JOYSTICK_FFB_REPORT_SET_CONDITION), MAIN_OUTPUT));
+    CHECK_EQUAL(8, layout.bytes(FFB_ID(JOYSTICK_FFB_REPORT_SET_PERIODIC), MAIN_OUTPUT));
+    CHECK_EQUAL(3, layout.bytes(FFB_ID(JOYSTICK_FFB_REPORT_SET_CONSTANT), MAIN_OUTPUT));
+    CHECK_EQUAL(3, layout.bytes(FFB_ID(JOYSTICK_FFB_REPORT_EFFECT_OPERATION), MAIN_OUTPUT));
+    CHECK_EQUAL(1, layout.bytes(FFB_ID(JOYSTICK_FFB_REPORT_BLOCK_FREE), MAIN_OUTPUT));
+    CHECK_EQUAL(1, layout.bytes(FFB_ID(JOYSTICK_FFB_REPORT_DEVICE_CONTROL), MAIN_OUTPUT));
+    CHECK_EQUAL(1, layout.bytes(FFB_ID(JOYSTICK_FFB_REPORT_DEVICE_GAIN), MAIN_OUTPUT));
+    CHECK_EQUAL(3, layout.bytes(FFB_ID(JOYSTICK_FFB_REPORT_CREATE_EFFECT), MAIN_FEATURE));
+    CHECK_EQUAL(4, layout.bytes(FFB_ID(JOYSTICK_FFB_REPORT_BLOCK_LOAD), MAIN_FEATURE));
+    CHECK_EQUAL(4, layout.bytes(FFB_ID(JOYSTICK_FFB_REPORT_POOL), MAIN_FEATURE));
+
+    // Joystick and force feedback together form one balanced collection
+    uint8_t combined[JOYSTICK_DESCRIPTOR_SIZE_MAXIMUM + 512];
+    uint16_t length = builder.buildDescriptor(combined);
+    memcpy(&combined[length], forceFeedback.getDescriptor(), forceFeedback.getDescriptorSize());
+    length += forceFeedback.getDescriptorSize();
+
+    layout = parseDescriptor(combined, length);
+    CHECK(layout.valid);
+    CHECK_EQUAL(0, layout.depth);
+    CHECK_EQUAL(0, layout.minimumDepth);
+    CHECK_EQUAL(joystick.getReportSize(), layout.bytes(JOYSTICK_DEFAULT_REPORT_ID, MAIN_INPUT));
+}
+
+// Host side of the PID protocol
+struct Host {
+    JoystickForceFeedback &forceFeedback;
+
+    uint8_t createEffect(uint8_t type) {
+        const uint8_t create[] = {type, 0, 0};
+        forceFeedback.handleFeatureReport(FFB_ID(JOYSTICK_FFB_REPORT_CREATE_EFFECT), create, sizeof(create));
+
+        uint8_t blockLoad[4];
+        forceFeedback.getFeatureReport(FFB_ID(JOYSTICK_FFB_REPORT_BLOCK_LOAD), blockLoad, sizeof(blockLoad));
+        return (blockLoad[1] == 1) ? blockLoad[0] : 0;
+    }
+
+    void output(uint8_t report, const uint8_t data[], uint8_t length) {
+        CHECK(forceFeedback.handleOutputReport(FFB_ID(report), data, length));
+    }
+
+    void setEffect(uint8_t block, uint8_t type, uint16_t duration, uint8_t gain, uint8_t flags, uint8_t direction) {
+        const uint8_t data[] = {block, type, (uint8_t) duration, (uint8_t) (duration >> 8), 0, 0, gain, flags,
+                                direction, 0};
+        output(JOYSTICK_FFB_REPORT_SET_EFFECT, data, sizeof(data));
+    }
+
+    void start(uint8_t block, uint8_t loopCount = 1) {
+        const uint8_t data[] = {block, 1, loopCount};
+        output(JOYSTICK_FFB_REPORT_EFFECT_OPERATION, data, sizeof(data));
+    }
+
+    void control(uint8_t control) {
+        output(JOYSTICK_FFB_REPORT_DEVICE_CONTROL, &control, 1);
+    }
+};
+
+static void testConstantForceWithDirection() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickForceFeedback forceFeedback(joystick);
+    Host host{forceFeedback};
+
+    uint8_t block = host.createEffect(JOYSTICK_EFFECT_CONSTANT);
+    CHECK_EQUAL(1, block);
+
+    // From the east (direction 64 of 256): pushes towards negative X
+    host.setEffect(block, JOYSTICK_EFFECT_CONSTANT, 100, 255, 0x04, 64);
+    const uint8_t constant[] = {block, (uint8_t) 5000, (uint8_t) (5000 >> 8)};
+    host.output(JOYSTICK_FFB_REPORT_SET_CONSTANT, constant, sizeof(constant));
+    host.start(block);
+
+    forceFeedback.tick();
+    CHECK_NEAR(-5000, forceFeedback.getForce(0), 2);
+    CHECK_NEAR(0, forceFeedback.getForce(1), 2);
+
+    uint8_t state[2];
+    forceFeedback.buildStateReport(state);
+    CHECK_EQUAL(0x02, state[0]);
+    CHECK_EQUAL(0x01 | (block << 1), state[1]);
+
+    // Ends after its duration of 100 ms
+    for (int tick = 1; tick < 100; tick++) forceFeedback.tick();
+    CHECK(forceFeedback.getEffect(block)->playing);
+    forceFeedback.tick();
+    CHECK(!forceFeedback.getEffect(block)->playing);
+    CHECK_EQUAL(0, forceFeedback.getForce(0));
+}
+
+static void testSpringFollowsStick() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickForceFeedback forceFeedback(joystick);
+    Host host{forceFeedback};
+
+    uint8_t block = host.createEffect(JOYSTICK_EFFECT_SPRING);
+    host.setEffect(block, JOYSTICK_EFFECT_SPRING, JOYSTICK_FFB_DURATION_INFINITE, 255, 0x03, 0);
+    // Axis 0: full coefficient and saturation, no dead band
+    const uint8_t condition[] = {block, 0, 0, 0, 0x10, 0x27, 0x10, 0x27, 0x10, 0x27, 0x10, 0x27, 0, 0};
+    host.output(JOYSTICK_FFB_REPORT_SET_CONDITION, condition, sizeof(condition));
+    host.start(block);
+
+    joystick.setXAxis(1023);
+    joystick.setYAxis(0);
+    forceFeedback.tick();
+    CHECK_EQUAL(-10000, forceFeedback.getForce(0));
+    // The first condition also applies to the second axis
+    CHECK_EQUAL(10000, forceFeedback.getForce(1));
+
+    const uint8_t gain = 128;
+    host.output(JOYSTICK_FFB_REPORT_DEVICE_GAIN, &gain, 1);
+    forceFeedback.tick();
+    CHECK_EQUAL(-10000 * 128 / 255, forceFeedback.getForce(0));
+
+    host.control(5);   // pause
+    forceFeedback.tick();
+    CHECK_EQUAL(0, forceFeedback.getForce(0));
+    host.control(6);   // continue
+    forceFeedback.tick();
+    CHECK(forceFeedback.getForce(0) != 0);
+}
+
+static void testSquareWave() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickForceFeedback forceFeedback(joystick);
+    Host host{forceFeedback};
+
+    uint8_t block = host.createEffect(JOYSTICK_EFFECT_SQUARE);
+    host.setEffect(block, JOYSTICK_EFFECT_SQUARE, JOYSTICK_FFB_DURATION_INFINITE, 255, 0x01, 0);
+    // Magnitude 4000, no offset or phase, period 100 ms
+    const uint8_t periodic[] = {block, 0xA0, 0x0F, 0, 0, 0, 100, 0};
+    host.output(JOYSTICK_FFB_REPORT_SET_PERIODIC, periodic, sizeof(periodic));
+    host.start(block);
+
+    for (int tick = 0; tick < 200; tick++) {
+        forceFeedback.tick();
+        CHECK_EQUAL(((tick % 100) < 50) ? 4000 : -4000, forceFeedback.getForce(0));
+        CHECK_EQUAL(0, forceFeedback.getForce(1));
+    }
+}
+
+static void testPoolAndBlockFree() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickForceFeedback forceFeedback(joystick);
+    Host host{forceFeedback};
+
+    uint8_t pool[4];
+    CHECK_EQUAL(4, forceFeedback.getFeatureReport(FFB_ID(JOYSTICK_FFB_REPORT_POOL), pool, sizeof(pool)));
+    CHECK_EQUAL(JOYSTICK_FFB_EFFECT_COUNT, pool[2]);
+
+    for (uint8_t block = 1; block <= JOYSTICK_FFB_EFFECT_COUNT; block++) {
+        CHECK_EQUAL(block, host.createEffect(JOYSTICK_EFFECT_SINE));
+    }
+    CHECK_EQUAL(0, host.createEffect(JOYSTICK_EFFECT_SINE));
+
+    const uint8_t freed = 3;
+    host.output(JOYSTICK_FFB_REPORT_BLOCK_FREE, &freed, 1);
+    CHECK_EQUAL(freed, host.createEffect(JOYSTICK_EFFECT_DAMPER));
+
+    // Reset frees every block
+    host.control(4);
+    CHECK_EQUAL(1, host.createEffect(JOYSTICK_EFFECT_CONSTANT));
+
+    // Unknown reports are left to other handlers
+    CHECK(!forceFeedback.handleOutputReport(JOYSTICK_DEFAULT_REPORT_ID, pool, 1));
+}
+
+int main() {
+    RUN_TEST(testDescriptorLayout);
+    RUN_TEST(testConstantForceWithDirection);
+    RUN_TEST(testSpringFollowsStick);
+    RUN_TEST(testSquareWave);
+    RUN_TEST(testPoolAndBlockFree);
+    return testResult();
+}
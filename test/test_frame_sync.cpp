@@ -0,0 +1,238 @@
+//
+// test_frame_sync.cpp
+//
+// Frame-synchronized sampling against a simulated host that polls on a fixed
+// grid. Time only moves through advance(), which fires the polls at their
+// exact time, as the start-of-frame interrupt would.
+//
+
+#include "TestSupport.h"
+#include "JoystickFrameSync.h"
+
+#define POLL_INTERVAL 1000
+#define POLL_OFFSET    500
+#define LEAD_TIME      200
+#define LOOP_TIME       10
+#define SAMPLE_TIME     30
+
+static JoystickFrameSync *frameSync;
+static bool hookAvailable;
+static uint32_t nextHostPoll;
+static uint32_t sampleCount;
+static uint32_t lastSample;
+static bool pollAfterSample;
+static uint32_t firstPollAfterSample;
+static uint32_t sampleDuration;
+
+static void advance(uint32_t duration) {
+    uint32_t end = mockMicros + duration;
+    while (joystickTimeDifference(end, nextHostPoll) >= 0) {
+        mockMicros = nextHostPoll;
+        if (sampleCount > 0 && !pollAfterSample) {
+            pollAfterSample = true;
+            firstPollAfterSample = nextHostPoll;
+        }
+        if (hookAvailable) frameSync->pollObserved();
+        nextHostPoll += POLL_INTERVAL;
+    }
+    mockMicros = end;
+}
+
+static void sampleInputs(Joystick_ &joystick) {
+    sampleCount++;
+    lastSample = mockMicros;
+    pollAfterSample = false;
+    joystick.setXAxis((int32_t) sampleCount);
+    advance(sampleDuration);
+}
+
+static JoystickBuilder createBuilder() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(8);
+    builder.includeXAxis(true);
+    return builder;
+}
+
+static void setUp(JoystickFrameSync &sync, bool hook) {
+    frameSync = &sync;
+    hookAvailable = hook;
+    nextHostPoll = POLL_OFFSET;
+    sampleCount = 0;
+    lastSample = 0;
+    pollAfterSample = false;
+    firstPollAfterSample = 0;
+    sampleDuration = SAMPLE_TIME;
+
+    sync.setPollInterval(POLL_INTERVAL);
+    sync.setLeadTime(LEAD_TIME);
+    sync.setSampleCallback(sampleInputs);
+}
+
+// Runs the loop until the clock reaches end
+static void runUntil(uint32_t end) {
+    while (joystickTimeDifference(end, mockMicros) > 0) {
+        frameSync->update();
+        advance(LOOP_TIME);
+    }
+}
+
+// Runs the loop until the next sample has been taken
+static void runUntilSample() {
+    uint32_t samples = sampleCount;
+    while (sampleCount == samples) {
+        frameSync->update();
+        advance(LOOP_TIME);
+    }
+}
+
+static void testHookSamplesBeforePoll() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(false);
+    mockReports.clear();
+    JoystickFrameSync sync(joystick, mockClock);
+    setUp(sync, true);
+
+    // Without an anchor the first update samples immediately
+    runUntil(POLL_OFFSET + 1);
+    CHECK_EQUAL(1, sampleCount);
+    sync.resetStatistics();
+
+    // Once anchored, one sample per poll, within the lead time before it
+    for (uint32_t frame = 0; frame < 20; frame++) {
+        uint32_t poll = nextHostPoll;
+        runUntil(poll);
+        CHECK_EQUAL(frame + 2, sampleCount);
+        CHECK(joystickTimeDifference(poll, lastSample) > 0);
+        CHECK(joystickTimeDifference(poll, lastSample) <= LEAD_TIME);
+        CHECK(joystickTimeDifference(poll, mockMicros) >= 0);
+
+        // The phase is taken once the poll is reported
+        runUntil(poll + LOOP_TIME + 1);
+        CHECK_EQUAL(poll - lastSample, sync.getLastPhase());
+    }
+    CHECK_EQUAL(sampleCount, mockReports.size());
+
+    CHECK_EQUAL(LEAD_TIME, sync.getAveragePhase());
+    CHECK_EQUAL(LEAD_TIME, sync.getMinimumPhase());
+    CHECK_EQUAL(LEAD_TIME, sync.getMaximumPhase());
+    CHECK_EQUAL(SAMPLE_TIME, sync.getLastSampleDuration());
+}
+
+static void testHookPhaseUsesFirstPollAfterSample() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(false);
+    JoystickFrameSync sync(joystick, mockClock);
+    setUp(sync, true);
+
+    runUntil(3 * POLL_INTERVAL);
+    uint32_t poll = nextHostPoll;
+    runUntil(poll - LEAD_TIME + LOOP_TIME);
+    uint32_t samples = sampleCount;
+    CHECK(samples > 0);
+    CHECK_EQUAL(poll - LEAD_TIME, lastSample);
+
+    // The loop stalls over two polls before it sees either of them
+    advance(POLL_INTERVAL + LEAD_TIME + LOOP_TIME);
+    CHECK(pollAfterSample);
+    CHECK_EQUAL(poll, firstPollAfterSample);
+
+    sync.resetStatistics();
+    sync.update();
+    CHECK_EQUAL(LEAD_TIME, sync.getLastPhase());
+    CHECK_EQUAL(LEAD_TIME, sync.getAveragePhase());
+
+    // The grid is anchored on the latest poll
+    CHECK_EQUAL(poll + 2 * POLL_INTERVAL, sync.getNextPoll());
+}
+
+static void testHookPollDuringSampling() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(false);
+    JoystickFrameSync sync(joystick, mockClock);
+    setUp(sync, true);
+
+    runUntil(3 * POLL_INTERVAL);
+
+    // Sampling takes longer than the lead time, so the poll arrives while
+    // the callback runs and takes the previous report
+    sampleDuration = LEAD_TIME + 50;
+    uint32_t poll = nextHostPoll;
+    runUntil(poll + LOOP_TIME);
+    CHECK(joystickTimeDifference(poll, lastSample) > 0);
+    CHECK(joystickTimeDifference(mockMicros, poll) > 0);
+
+    sync.resetStatistics();
+    sync.update();
+    CHECK_EQUAL(poll - lastSample, sync.getLastPhase());
+    CHECK(sync.getLastSampleDuration() >= sampleDuration);
+}
+
+static void testNoHookPredictsFromCompletion() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(false);
+    mockReports.clear();
+    JoystickFrameSync sync(joystick, mockClock);
+    setUp(sync, false);
+
+    // The first report anchors the grid on its completion
+    mockMicros = 100;
+    sync.update();
+    CHECK_EQUAL(1, sampleCount);
+    uint32_t anchor = 100 + SAMPLE_TIME;
+    CHECK_EQUAL(SAMPLE_TIME, sync.getLastPhase());
+    CHECK_EQUAL(anchor + POLL_INTERVAL, sync.getNextPoll());
+
+    // Afterwards it samples the lead time before each predicted poll and
+    // reports the predicted phase right away
+    sync.resetStatistics();
+    for (uint32_t frame = 1; frame <= 10; frame++) {
+        uint32_t predicted = anchor + frame * POLL_INTERVAL;
+        runUntil(predicted);
+        CHECK_EQUAL(frame + 1, sampleCount);
+        CHECK(joystickTimeDifference(predicted, lastSample) > 0);
+        CHECK(joystickTimeDifference(predicted, lastSample) <= LEAD_TIME);
+        CHECK_EQUAL(predicted - lastSample, sync.getLastPhase());
+    }
+    CHECK_EQUAL(11, mockReports.size());
+    CHECK(sync.getMinimumPhase() > LEAD_TIME - LOOP_TIME);
+    CHECK(sync.getMaximumPhase() <= LEAD_TIME);
+    CHECK(sync.getAveragePhase() >= sync.getMinimumPhase());
+    CHECK(sync.getAveragePhase() <= sync.getMaximumPhase());
+}
+
+static void testNoHookBlockingSendReanchors() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(false);
+    JoystickFrameSync sync(joystick, mockClock);
+    setUp(sync, false);
+
+    runUntil(3 * POLL_INTERVAL);
+
+    // A send that blocks past the lead time waited for the host, so its
+    // completion is taken as the poll
+    sampleDuration = LEAD_TIME + 100;
+    runUntilSample();
+    uint32_t done = lastSample + sampleDuration;
+    CHECK_EQUAL(sampleDuration, sync.getLastPhase());
+    CHECK_EQUAL(done + POLL_INTERVAL, sync.getNextPoll());
+
+    // The next sample is the lead time before the new grid
+    sampleDuration = SAMPLE_TIME;
+    runUntilSample();
+    CHECK_EQUAL(done + POLL_INTERVAL - LEAD_TIME, lastSample);
+    CHECK_EQUAL(LEAD_TIME, sync.getLastPhase());
+}
+
+int main() {
+    RUN_TEST(testHookSamplesBeforePoll);
+    RUN_TEST(testHookPhaseUsesFirstPollAfterSample);
+    RUN_TEST(testHookPollDuringSampling);
+    RUN_TEST(testNoHookPredictsFromCompletion);
+    RUN_TEST(testNoHookBlockingSendReanchors);
+    return testResult();
+}
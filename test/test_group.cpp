@@ -0,0 +1,237 @@
+//
+// test_group.cpp
+//
+
+#include <memory>
+#include "TestSupport.h"
+#include "JoystickGroup.h"
+
+#define CONTROLLER_COUNT 4
+#define FRAME_LENGTH     1000
+
+// Controllers with report IDs 1..CONTROLLER_COUNT, each with 8 buttons and X
+struct GroupFixture {
+    std::unique_ptr<Joystick_> joysticks[CONTROLLER_COUNT];
+    JoystickGroup group;
+
+    explicit GroupFixture(uint8_t reportsPerFrame) : group(reportsPerFrame, FRAME_LENGTH, mockClock) {
+        for (uint8_t index = 0; index < CONTROLLER_COUNT; index++) {
+            JoystickBuilder builder(index + 1, JOYSTICK_TYPE_JOYSTICK);
+            builder.setButtonCount(8);
+            builder.includeXAxis(true);
+            joysticks[index].reset(new Joystick_(builder));
+            joysticks[index]->begin(false);
+            group.add(*joysticks[index]);
+        }
+        mockReports.clear();
+    }
+
+    // Runs one frame and returns the report IDs it sent
+    std::vector<uint8_t> frame() {
+        mockReports.clear();
+        group.update();
+        mockMicros += FRAME_LENGTH;
+
+        std::vector<uint8_t> ids;
+        for (const std::vector<uint8_t> &report: mockReports) {
+            ids.push_back(report[0]);
+        }
+        return ids;
+    }
+};
+
+static uint8_t firstId(const std::vector<uint8_t> &ids) {
+    return ids.empty() ? 0 : ids[0];
+}
+
+static void testRoundRobinOrder() {
+    GroupFixture fixture(1);
+
+    for (int frame = 0; frame < 2 * CONTROLLER_COUNT; frame++) {
+        for (uint8_t index = 0; index < CONTROLLER_COUNT; index++) {
+            fixture.group.markDirty(index);
+        }
+        std::vector<uint8_t> ids = fixture.frame();
+        CHECK_EQUAL(1, ids.size());
+        CHECK_EQUAL(frame % CONTROLLER_COUNT + 1, firstId(ids));
+    }
+}
+
+// With several reports per frame no dirty controller is stepped over
+static void testSeveralReportsPerFrame() {
+    GroupFixture fixture(3);
+    const uint8_t expected[][3] = {{1, 2, 3}, {4, 1, 2}, {3, 4, 1}};
+
+    for (const uint8_t (&frame)[3]: expected) {
+        for (uint8_t index = 0; index < CONTROLLER_COUNT; index++) {
+            fixture.group.markDirty(index);
+        }
+        std::vector<uint8_t> ids = fixture.frame();
+        CHECK_EQUAL(3, ids.size());
+        for (uint8_t report = 0; (report < 3) && (report < ids.size()); report++) {
+            CHECK_EQUAL(frame[report], ids[report]);
+        }
+    }
+}
+
+static void testIdleControllersAreSkipped() {
+    GroupFixture fixture(1);
+
+    fixture.joysticks[1]->setButton(0, true);
+    fixture.joysticks[3]->setButton(0, true);
+
+    std::vector<uint8_t> ids = fixture.frame();
+    CHECK_EQUAL(1, ids.size());
+    CHECK_EQUAL(2, firstId(ids));
+    CHECK_EQUAL(0x08, fixture.group.getDirtyMask());
+
+    ids = fixture.frame();
+    CHECK_EQUAL(1, ids.size());
+    CHECK_EQUAL(4, firstId(ids));
+
+    CHECK(fixture.frame().empty());
+}
+
+static void testWaitIsBounded() {
+    GroupFixture fixture(1);
+
+    for (int frame = 0; frame < 100; frame++) {
+        for (uint8_t index = 0; index < CONTROLLER_COUNT; index++) {
+            fixture.joysticks[index]->setXAxis(frame % 2 ? 1023 : 0);
+        }
+        fixture.frame();
+    }
+
+    for (uint8_t index = 0; index < CONTROLLER_COUNT; index++) {
+        CHECK_EQUAL(CONTROLLER_COUNT - 1, fixture.group.getMaximumWait(index));
+    }
+}
+
+// A button edge goes before analog changes queued earlier in the rotation
+static void testDigitalFirst() {
+    GroupFixture fixture(1);
+
+    for (uint8_t index = 0; index < CONTROLLER_COUNT - 1; index++) {
+        fixture.joysticks[index]->setXAxis(1023);
+    }
+    fixture.joysticks[3]->setButton(0, true);
+
+    std::vector<uint8_t> ids = fixture.frame();
+    CHECK_EQUAL(1, ids.size());
+    CHECK_EQUAL(4, firstId(ids));
+
+    // The analog ones follow in rotation
+    for (uint8_t id = 1; id < CONTROLLER_COUNT; id++) {
+        ids = fixture.frame();
+        CHECK_EQUAL(1, ids.size());
+        CHECK_EQUAL(id, firstId(ids));
+    }
+}
+
+// One report is 4 bytes: report ID, buttons and X
+static void testBudgetLimitsAnalogReports() {
+    GroupFixture fixture(CONTROLLER_COUNT);
+    fixture.group.setBandwidthBudget(4, 4);
+
+    for (int frame = 0; frame < 8; frame++) {
+        for (uint8_t index = 0; index < CONTROLLER_COUNT; index++) {
+            fixture.joysticks[index]->setXAxis((frame == 7) ? 1023 : 100 + frame * 100);
+        }
+        std::vector<uint8_t> ids = fixture.frame();
+        CHECK_EQUAL(1, ids.size());
+        CHECK_EQUAL(frame % CONTROLLER_COUNT + 1, firstId(ids));
+    }
+    CHECK_EQUAL(8, fixture.group.getBudgetDeferredCount());
+    CHECK_EQUAL(8, fixture.group.getDeferredCount());
+
+    // The held values merged: the rest of the controllers report the latest X
+    mockReports.clear();
+    for (int frame = 0; frame < CONTROLLER_COUNT; frame++) {
+        fixture.group.update();
+        mockMicros += FRAME_LENGTH;
+    }
+    CHECK_EQUAL(CONTROLLER_COUNT - 1, mockReports.size());
+    for (const std::vector<uint8_t> &report: mockReports) {
+        CHECK_EQUAL(0xFF, report[2]);
+        CHECK_EQUAL(0xFF, report[3]);
+    }
+}
+
+static void testButtonsOverdrawBudget() {
+    GroupFixture fixture(CONTROLLER_COUNT);
+    fixture.group.setBandwidthBudget(4, 4);
+
+    for (uint8_t index = 0; index < CONTROLLER_COUNT; index++) {
+        fixture.joysticks[index]->setButton(0, true);
+    }
+    CHECK_EQUAL(CONTROLLER_COUNT, fixture.frame().size());
+    CHECK_EQUAL(0, fixture.group.getBudgetDeferredCount());
+
+    // The debt delays analog reports until it is paid back
+    fixture.joysticks[0]->setXAxis(1023);
+    CHECK(fixture.frame().empty());
+    CHECK(fixture.frame().empty());
+    CHECK(fixture.frame().empty());
+    CHECK_EQUAL(1, fixture.frame().size());
+    CHECK_EQUAL(3, fixture.group.getBudgetDeferredCount());
+}
+
+// A burst below one report would hold analog reports back forever
+static void testBudgetBurstCoversOneReport() {
+    GroupFixture fixture(CONTROLLER_COUNT);
+    fixture.group.setBandwidthBudget(1, 2);
+
+    fixture.joysticks[0]->setXAxis(1023);
+    std::vector<uint8_t> ids = fixture.frame();
+    CHECK_EQUAL(1, ids.size());
+    CHECK_EQUAL(1, firstId(ids));
+
+    // Saved up again after four frames
+    fixture.joysticks[1]->setXAxis(1023);
+    for (int frame = 0; frame < 3; frame++) {
+        CHECK(fixture.frame().empty());
+    }
+    ids = fixture.frame();
+    CHECK_EQUAL(1, ids.size());
+    CHECK_EQUAL(2, firstId(ids));
+
+    // A larger controller added later raises the burst as well
+    JoystickBuilder builder(CONTROLLER_COUNT + 1, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(8).includeXAxis(true).includeYAxis(true).includeZAxis(true);
+    Joystick_ large(builder);
+    large.begin(false);
+    CHECK_EQUAL(CONTROLLER_COUNT, fixture.group.add(large));
+
+    large.setZAxis(1023);
+    bool sent = false;
+    for (int frame = 0; (frame < 20) && !sent; frame++) {
+        sent = !fixture.frame().empty();
+    }
+    CHECK(sent);
+}
+
+// Reports held by reportsPerFrame are not budget deferrals
+static void testFrameLimitIsNotBudgetDeferral() {
+    GroupFixture fixture(1);
+
+    fixture.joysticks[0]->setXAxis(1023);
+    fixture.joysticks[1]->setXAxis(1023);
+    fixture.frame();
+    fixture.frame();
+
+    CHECK_EQUAL(1, fixture.group.getDeferredCount());
+    CHECK_EQUAL(0, fixture.group.getBudgetDeferredCount());
+}
+
+int main() {
+    RUN_TEST(testRoundRobinOrder);
+    RUN_TEST(testSeveralReportsPerFrame);
+    RUN_TEST(testIdleControllersAreSkipped);
+    RUN_TEST(testWaitIsBounded);
+    RUN_TEST(testDigitalFirst);
+    RUN_TEST(testBudgetLimitsAnalogReports);
+    RUN_TEST(testButtonsOverdrawBudget);
+    RUN_TEST(testBudgetBurstCoversOneReport);
+    RUN_TEST(testFrameLimitIsNotBudgetDeferral);
+    return testResult();
+}
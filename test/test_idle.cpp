@@ -0,0 +1,162 @@
+//
+// test_idle.cpp
+//
+// Idle detection and wake latency against the simulated clock. The sleep
+// callback stands in for the CPU: it lets time pass instead of sleeping.
+//
+
+#include "TestSupport.h"
+#include "JoystickIdleManager.h"
+
+#define SCAN_TIME          20
+#define LOOP_TIME          10
+#define ACTIVE_INTERVAL  1000
+#define IDLE_INTERVAL   50000
+#define IDLE_TIMEOUT     5000
+
+static bool buttonInput;
+static uint32_t sleepCount;
+static uint32_t lastMaxSleep;
+
+static void scanInputs(Joystick_ &joystick) {
+    mockMicros += SCAN_TIME;
+    joystick.setButton(0, buttonInput);
+}
+
+static void sleepUntilNextScan(uint32_t maxSleep) {
+    sleepCount++;
+    lastMaxSleep = maxSleep;
+    if (maxSleep != JOYSTICK_IDLE_SLEEP_FOREVER) {
+        mockMicros += maxSleep;
+    }
+}
+
+static JoystickBuilder createBuilder() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(8);
+    return builder;
+}
+
+static void setUp(JoystickIdleManager &manager, uint32_t idleInterval) {
+    buttonInput = false;
+    sleepCount = 0;
+    lastMaxSleep = 0;
+
+    manager.setScanCallback(scanInputs);
+    manager.setSleepCallback(sleepUntilNextScan);
+    manager.setActiveInterval(ACTIVE_INTERVAL);
+    manager.setIdleInterval(idleInterval);
+    manager.setIdleTimeout(IDLE_TIMEOUT);
+}
+
+// Runs the loop until the clock reaches end
+static void runUntil(JoystickIdleManager &manager, uint32_t end) {
+    while (joystickTimeDifference(end, mockMicros) > 0) {
+        manager.update();
+        mockMicros += LOOP_TIME;
+    }
+}
+
+static void testGoesIdleAfterTimeout() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickIdleManager manager(joystick, mockClock);
+    setUp(manager, IDLE_INTERVAL);
+    joystick.begin(false);
+
+    runUntil(manager, IDLE_TIMEOUT - 100);
+    CHECK(!manager.isIdle());
+    CHECK_EQUAL(0, sleepCount);
+    CHECK_NEAR(IDLE_TIMEOUT / ACTIVE_INTERVAL, manager.getScanCount(), 1);
+
+    runUntil(manager, IDLE_TIMEOUT + 100);
+    CHECK(manager.isIdle());
+
+    // While idle it scans at the idle interval and sleeps in between
+    uint32_t scans = manager.getScanCount();
+    runUntil(manager, IDLE_TIMEOUT + 10 * IDLE_INTERVAL);
+    CHECK_NEAR(10, manager.getScanCount() - scans, 1);
+    CHECK(sleepCount >= 9);
+    CHECK(lastMaxSleep <= IDLE_INTERVAL);
+}
+
+// Without wake() an edge waits for the next slow scan
+static void testPolledEdgeWhileIdle() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickIdleManager manager(joystick, mockClock);
+    setUp(manager, IDLE_INTERVAL);
+    joystick.begin(false);
+
+    runUntil(manager, 2 * IDLE_TIMEOUT);
+    CHECK(manager.isIdle());
+
+    mockReports.clear();
+    buttonInput = true;
+    uint32_t edge = mockMicros;
+    while (mockReports.empty()) {
+        manager.update();
+        mockMicros += LOOP_TIME;
+    }
+    CHECK(!manager.isIdle());
+    CHECK(joystickTimeDifference(mockMicros, edge) <= IDLE_INTERVAL + SCAN_TIME + LOOP_TIME);
+}
+
+static void testWakeLatency() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickIdleManager manager(joystick, mockClock);
+    setUp(manager, 0);
+    joystick.begin(false);
+
+    runUntil(manager, 2 * IDLE_TIMEOUT);
+    CHECK(manager.isIdle());
+    CHECK_EQUAL(JOYSTICK_IDLE_SLEEP_FOREVER, lastMaxSleep);
+
+    // Scanning has stopped: a change alone goes unnoticed
+    uint32_t scans = manager.getScanCount();
+    buttonInput = true;
+    runUntil(manager, 4 * IDLE_TIMEOUT);
+    CHECK_EQUAL(scans, manager.getScanCount());
+
+    // The interrupt ends the sleep; the next update() scans and reports
+    mockReports.clear();
+    manager.wake();
+    mockMicros += LOOP_TIME;
+    CHECK(manager.update());
+    CHECK_EQUAL(1, mockReports.size());
+    CHECK(!manager.isIdle());
+    CHECK_EQUAL(LOOP_TIME + SCAN_TIME, manager.getLastWakeLatency());
+
+    // Further wakes keep the first edge's time
+    manager.wake();
+    mockMicros += 100;
+    manager.wake();
+    mockMicros += LOOP_TIME;
+    manager.update();
+    CHECK_EQUAL(100 + LOOP_TIME + SCAN_TIME, manager.getLastWakeLatency());
+    CHECK_EQUAL(100 + LOOP_TIME + SCAN_TIME, manager.getMaximumWakeLatency());
+}
+
+static void testActivityRestartsTimeout() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickIdleManager manager(joystick, mockClock);
+    setUp(manager, IDLE_INTERVAL);
+    joystick.begin(false);
+
+    for (int toggle = 0; toggle < 5; toggle++) {
+        runUntil(manager, mockMicros + IDLE_TIMEOUT / 2);
+        buttonInput = !buttonInput;
+    }
+    CHECK(!manager.isIdle());
+    CHECK_EQUAL(0, sleepCount);
+}
+
+int main() {
+    RUN_TEST(testGoesIdleAfterTimeout);
+    RUN_TEST(testPolledEdgeWhileIdle);
+    RUN_TEST(testWakeLatency);
+    RUN_TEST(testActivityRestartsTimeout);
+    return testResult();
+}
@@ -0,0 +1,255 @@
+//
+// test_link.cpp
+//
+
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "TestSupport.h"
+#include "JoystickLink.h"
+
+#define LOOPBACK_FRAMES 300
+
+static JoystickBuilder createBuilder() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(32).includeXAxis(true).includeYAxis(true);
+    return builder;
+}
+
+static bool reportButton(const Joystick_ &joystick, uint8_t button) {
+    return (joystick.getReport()[button / 8] >> (button % 8)) & 1;
+}
+
+struct Frame {
+    uint8_t data[JOYSTICK_LINK_FRAME_MAXIMUM];
+    uint8_t length;
+};
+
+static Frame encode(JoystickLinkEncoder &encoder) {
+    Frame frame;
+    frame.length = encoder.encode(frame.data);
+    return frame;
+}
+
+static void testRoundTrip() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickLinkDecoder decoder(joystick);
+    JoystickLinkEncoder encoder(2);
+    joystick.begin(true);
+
+    encoder.setField(JOYSTICK_FIELD_X_AXIS, 1023);
+    encoder.setField(JOYSTICK_FIELD_Y_AXIS, -70000);
+    encoder.setButton(9, true);
+    encoder.setButton(20, true);
+    Frame frame = encode(encoder);
+
+    // The first frame after a reset is a key frame
+    CHECK_EQUAL(2 | JOYSTICK_LINK_KEY_FRAME, frame.data[2]);
+    CHECK_EQUAL(1, decoder.feed(frame.data, frame.length));
+    CHECK_EQUAL(JOYSTICK_RADIAL_MAXIMUM, joystick.getAxisPosition(JOYSTICK_FIELD_X_AXIS));
+    CHECK_EQUAL(-JOYSTICK_RADIAL_MAXIMUM, joystick.getAxisPosition(JOYSTICK_FIELD_Y_AXIS));
+    CHECK(reportButton(joystick, 9));
+    CHECK(reportButton(joystick, 20));
+
+    // Only the change follows, without the key frame flag
+    encoder.setButton(9, false);
+    frame = encode(encoder);
+    CHECK_EQUAL(2, frame.data[2]);
+    CHECK_EQUAL(JOYSTICK_LINK_HEADER_SIZE + 4 + 2, frame.length);
+    CHECK_EQUAL(1, decoder.feed(frame.data, frame.length));
+    CHECK(!reportButton(joystick, 9));
+    CHECK(reportButton(joystick, 20));
+
+    // Nothing changed, nothing sent
+    CHECK_EQUAL(0, encode(encoder).length);
+}
+
+static void testLostFramesAndDuplicates() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickLinkDecoder decoder(joystick);
+    JoystickLinkEncoder encoder(0);
+
+    Frame frames[4];
+    for (int index = 0; index < 4; index++) {
+        encoder.setField(JOYSTICK_FIELD_X_AXIS, index * 100);
+        frames[index] = encode(encoder);
+    }
+
+    CHECK_EQUAL(1, decoder.feed(frames[0].data, frames[0].length));
+    CHECK_EQUAL(1, decoder.feed(frames[3].data, frames[3].length));
+    CHECK_EQUAL(2, decoder.getLostFrameCount());
+
+    // Repeated and late frames are rejected
+    CHECK_EQUAL(0, decoder.feed(frames[3].data, frames[3].length));
+    CHECK_EQUAL(0, decoder.feed(frames[1].data, frames[1].length));
+    CHECK_EQUAL(2, decoder.getRejectedFrameCount());
+    CHECK_EQUAL(2, decoder.getFrameCount());
+}
+
+// A rebooted node starts its sequence again; its first (key) frame resyncs
+static void testNodeRebootResyncs() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickLinkDecoder decoder(joystick);
+    JoystickLinkEncoder *encoder = new JoystickLinkEncoder(1);
+    encoder->setKeyFrameInterval(0);
+
+    for (int index = 0; index < 100; index++) {
+        encoder->setField(JOYSTICK_FIELD_X_AXIS, index);
+        Frame frame = encode(*encoder);
+        decoder.feed(frame.data, frame.length);
+    }
+    CHECK_EQUAL(100, decoder.getFrameCount());
+
+    delete encoder;
+    encoder = new JoystickLinkEncoder(1);
+    encoder->setKeyFrameInterval(0);
+
+    // Sequence 0 after 99 is 157 frames back
+    encoder->setField(JOYSTICK_FIELD_X_AXIS, 1023);
+    Frame frame = encode(*encoder);
+    CHECK_EQUAL(1, decoder.feed(frame.data, frame.length));
+    CHECK_EQUAL(JOYSTICK_RADIAL_MAXIMUM, joystick.getAxisPosition(JOYSTICK_FIELD_X_AXIS));
+
+    encoder->setField(JOYSTICK_FIELD_X_AXIS, 0);
+    frame = encode(*encoder);
+    CHECK_EQUAL(1, decoder.feed(frame.data, frame.length));
+    CHECK_EQUAL(-JOYSTICK_RADIAL_MAXIMUM, joystick.getAxisPosition(JOYSTICK_FIELD_X_AXIS));
+    CHECK_EQUAL(0, decoder.getRejectedFrameCount());
+    CHECK_EQUAL(0, decoder.getLostFrameCount());
+    delete encoder;
+}
+
+// A sync byte in the noise claims a length that swallows the real frame;
+// after its CRC fails the real frame is found inside the claimed bytes
+static void testRescanAfterFalseSync() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickLinkDecoder decoder(joystick);
+    JoystickLinkEncoder encoder(0);
+
+    encoder.setField(JOYSTICK_FIELD_X_AXIS, 1023);
+    Frame frame = encode(encoder);
+
+    const uint8_t noise[] = {0x00, JOYSTICK_LINK_SYNC, 20, 0x13, 0x37};
+    CHECK_EQUAL(0, decoder.feed(noise, sizeof(noise)));
+    CHECK_EQUAL(0, decoder.feed(frame.data, frame.length));
+
+    // The false frame needs its claimed length before its CRC fails
+    uint16_t frames = 0;
+    for (uint8_t index = 0; index < 20; index++) {
+        frames += decoder.feed((uint8_t) 0x00);
+    }
+    CHECK_EQUAL(1, frames);
+    CHECK_EQUAL(1, decoder.getFrameCount());
+    CHECK_EQUAL(1, decoder.getCrcErrorCount());
+    CHECK_EQUAL(JOYSTICK_RADIAL_MAXIMUM, joystick.getAxisPosition(JOYSTICK_FIELD_X_AXIS));
+}
+
+static void testCorruptedFrame() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickLinkDecoder decoder(joystick);
+    JoystickLinkEncoder encoder(0);
+
+    encoder.setField(JOYSTICK_FIELD_X_AXIS, 1023);
+    Frame corrupted = encode(encoder);
+    corrupted.data[JOYSTICK_LINK_HEADER_SIZE + 1] ^= 0x10;
+    encoder.setField(JOYSTICK_FIELD_Y_AXIS, 1023);
+    Frame frame = encode(encoder);
+
+    CHECK_EQUAL(0, decoder.feed(corrupted.data, corrupted.length));
+    CHECK_EQUAL(1, decoder.getCrcErrorCount());
+    CHECK_EQUAL(1, decoder.feed(frame.data, frame.length));
+    CHECK(joystick.getAxisPosition(JOYSTICK_FIELD_X_AXIS) != JOYSTICK_RADIAL_MAXIMUM);
+    CHECK_EQUAL(JOYSTICK_RADIAL_MAXIMUM, joystick.getAxisPosition(JOYSTICK_FIELD_Y_AXIS));
+
+    // Too long to be a frame
+    const uint8_t invalid[] = {JOYSTICK_LINK_SYNC, JOYSTICK_LINK_PAYLOAD_MAXIMUM + 1};
+    CHECK_EQUAL(0, decoder.feed(invalid, sizeof(invalid)));
+    CHECK_EQUAL(1, decoder.getRejectedFrameCount());
+}
+
+static void testSeveralNodes() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickLinkDecoder decoder(joystick);
+    joystick.begin(true);
+    mockReports.clear();
+
+    for (uint8_t node = 0; node < JOYSTICK_LINK_NODE_COUNT; node++) {
+        JoystickLinkEncoder encoder(node);
+        encoder.setButtonBytes(node / 2, &node, 1);
+        encoder.setButton(node * 4, true);
+        Frame frame = encode(encoder);
+        CHECK_EQUAL(1, decoder.feed(frame.data, frame.length));
+    }
+    // One report per frame
+    CHECK_EQUAL(JOYSTICK_LINK_NODE_COUNT, mockReports.size());
+    CHECK(reportButton(joystick, 28));
+}
+
+// One writer thread per node on a pipe shared like a bus line; the reader
+// passes whatever read() returns to feed()
+static void testPipeLoopback() {
+    // Button bytes are absolute, so every node owns one
+    JoystickBuilder builder = createBuilder();
+    builder.setButtonCount(8 * JOYSTICK_LINK_NODE_COUNT);
+    Joystick_ joystick(builder);
+    JoystickLinkDecoder decoder(joystick);
+    joystick.begin(false);
+
+    int line[2];
+    CHECK_EQUAL(0, pipe(line));
+
+    std::vector<std::thread> writers;
+    for (uint8_t node = 0; node < JOYSTICK_LINK_NODE_COUNT; node++) {
+        writers.emplace_back([&line, node]() {
+            JoystickLinkEncoder encoder(node);
+            encoder.setKeyFrameInterval(16);
+            for (uint32_t index = 0; index < LOOPBACK_FRAMES; index++) {
+                encoder.setField(JOYSTICK_FIELD_X_AXIS, (int32_t) index);
+                encoder.setButton(node * 8, index & 1);
+                Frame frame = encode(encoder);
+                // Frames up to PIPE_BUF bytes are written atomically
+                if (write(line[1], frame.data, frame.length) != frame.length) return;
+            }
+        });
+    }
+
+    uint8_t buffer[256];
+    while (decoder.getFrameCount() < JOYSTICK_LINK_NODE_COUNT * LOOPBACK_FRAMES) {
+        ssize_t count = read(line[0], buffer, sizeof(buffer));
+        if (count <= 0) break;
+        decoder.feed(buffer, (uint16_t) count);
+    }
+    for (std::thread &writer: writers) {
+        writer.join();
+    }
+    close(line[0]);
+    close(line[1]);
+
+    CHECK_EQUAL(JOYSTICK_LINK_NODE_COUNT * LOOPBACK_FRAMES, decoder.getFrameCount());
+    CHECK_EQUAL(0, decoder.getCrcErrorCount());
+    CHECK_EQUAL(0, decoder.getLostFrameCount());
+    CHECK_EQUAL(0, decoder.getRejectedFrameCount());
+
+    // The last frame of every node is applied
+    joystick.sendState();
+    for (uint8_t node = 0; node < JOYSTICK_LINK_NODE_COUNT; node++) {
+        CHECK_EQUAL((LOOPBACK_FRAMES - 1) & 1, reportButton(joystick, node * 8));
+    }
+}
+
+int main() {
+    RUN_TEST(testRoundTrip);
+    RUN_TEST(testLostFramesAndDuplicates);
+    RUN_TEST(testNodeRebootResyncs);
+    RUN_TEST(testRescanAfterFalseSync);
+    RUN_TEST(testCorruptedFrame);
+    RUN_TEST(testSeveralNodes);
+    RUN_TEST(testPipeLoopback);
+    return testResult();
+}
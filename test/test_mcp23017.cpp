@@ -0,0 +1,317 @@
+//
+// test_mcp23017.cpp
+//
+// JoystickMcp23017 against a simulated expander behind the JoystickI2cBus
+// interface, including its interrupt outputs.
+//
+
+#include "TestSupport.h"
+#include "JoystickMcp23017.h"
+
+#define ADDRESS  0x21
+#define INTA_PIN 2
+#define INTB_PIN 3
+
+// Registers in the IOCON.BANK=1 layout
+#define REG_IODIR   0x00
+#define REG_IPOL    0x01
+#define REG_GPINTEN 0x02
+#define REG_IOCON   0x05
+#define REG_GPPU    0x06
+#define REG_INTF    0x07
+#define REG_INTCAP  0x08
+#define REG_GPIO    0x09
+
+// Interrupt on change against the previous level; INTCAP holds the port at
+// the first change until INTCAP or GPIO is read
+class SimulatedMcp23017 : public JoystickI2cBus {
+public:
+    uint8_t registers[0x20] = {};
+    uint8_t levels[2] = {0xFF, 0xFF};   // pins, high while released
+    bool bank1 = false;
+    uint32_t reads[2] = {0, 0};
+    uint32_t failReads = 0;
+
+    SimulatedMcp23017() {
+        registers[REG_IODIR] = 0xFF;
+        registers[0x10 + REG_IODIR] = 0xFF;
+        updateIntPins();
+    }
+
+    bool writeRegisters(uint8_t address, uint8_t reg, const uint8_t data[], uint8_t length) override {
+        if (address != ADDRESS) return false;
+
+        for (uint8_t index = 0; index < length; index++, reg++) {
+            if (!bank1) {
+                // Only the IOCON switch to BANK=1 is modelled for BANK=0
+                if ((reg == 0x0A) && (data[index] & 0x80)) bank1 = true;
+                registers[REG_IOCON] = data[index];
+                registers[0x10 + REG_IOCON] = data[index];
+                continue;
+            }
+            if (reg < sizeof(registers)) registers[reg] = data[index];
+        }
+        updateIntPins();
+        return true;
+    }
+
+    bool readRegisters(uint8_t address, uint8_t reg, uint8_t buffer[], uint8_t length) override {
+        if ((address != ADDRESS) || !bank1) return false;
+        if (failReads > 0) {
+            failReads--;
+            return false;
+        }
+
+        uint8_t port = reg >> 4;
+        reads[port]++;
+        bool clear = false;
+        for (uint8_t index = 0; index < length; index++, reg++) {
+            uint8_t offset = reg & 0x0F;
+            buffer[index] = (offset == REG_GPIO) ? gpio(port) : registers[reg];
+            if ((offset == REG_INTCAP) || (offset == REG_GPIO)) clear = true;
+        }
+        if (clear) registers[port * 0x10 + REG_INTF] = 0;
+        updateIntPins();
+        return true;
+    }
+
+    void setPin(uint8_t port, uint8_t pin, bool pressed) {
+        uint8_t previous = levels[port];
+        if (pressed) {
+            levels[port] &= (uint8_t) ~(1 << pin);
+        } else {
+            levels[port] |= (uint8_t) (1 << pin);
+        }
+
+        uint8_t changed = (uint8_t) ((previous ^ levels[port]) & registers[port * 0x10 + REG_GPINTEN]);
+        if (changed && (registers[port * 0x10 + REG_INTF] == 0)) {
+            registers[port * 0x10 + REG_INTF] = changed;
+            registers[port * 0x10 + REG_INTCAP] = gpio(port);
+        }
+        updateIntPins();
+    }
+
+private:
+    uint8_t gpio(uint8_t port) const {
+        return levels[port] ^ registers[port * 0x10 + REG_IPOL];
+    }
+
+    void updateIntPins() {
+        bool intA = registers[REG_INTF] != 0;
+        bool intB = registers[0x10 + REG_INTF] != 0;
+        if (registers[REG_IOCON] & 0x40) {
+            intA = intB = intA || intB;
+        }
+        mockPins[INTA_PIN] = intA ? LOW : HIGH;
+        mockPins[INTB_PIN] = intB ? LOW : HIGH;
+    }
+};
+
+static JoystickBuilder createBuilder() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(16);
+    return builder;
+}
+
+static bool reportButton(const Joystick_ &joystick, uint8_t button) {
+    return (joystick.getReport()[button / 8] >> (button % 8)) & 1;
+}
+
+static uint32_t totalReads(const SimulatedMcp23017 &expander) {
+    return expander.reads[0] + expander.reads[1];
+}
+
+static void testBeginConfigures() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    SimulatedMcp23017 expander;
+    JoystickMcp23017 buttons(joystick, expander, ADDRESS);
+    joystick.begin(true);
+
+    expander.setPin(0, 3, true);
+    CHECK(buttons.begin());
+
+    CHECK(expander.bank1);
+    for (uint8_t port = 0; port < 2; port++) {
+        CHECK_EQUAL(0xFF, expander.registers[port * 0x10 + REG_IODIR]);
+        CHECK_EQUAL(0xFF, expander.registers[port * 0x10 + REG_IPOL]);
+        CHECK_EQUAL(0xFF, expander.registers[port * 0x10 + REG_GPINTEN]);
+        CHECK_EQUAL(0xFF, expander.registers[port * 0x10 + REG_GPPU]);
+    }
+    CHECK(reportButton(joystick, 3));
+    CHECK_EQUAL(0x08, buttons.getValues()[0]);
+
+    // A missing expander is reported
+    JoystickMcp23017 missing(joystick, expander, ADDRESS + 1);
+    CHECK(!missing.begin());
+}
+
+static void testPollingWithoutPins() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    SimulatedMcp23017 expander;
+    JoystickMcp23017 buttons(joystick, expander, ADDRESS);
+    joystick.begin(true);
+    buttons.begin();
+
+    uint32_t reads = totalReads(expander);
+    buttons.update();
+    buttons.update();
+    CHECK_EQUAL(reads + 4, totalReads(expander));
+
+    expander.setPin(1, 6, true);
+    CHECK(buttons.update());
+    CHECK(reportButton(joystick, 14));
+}
+
+static void testInterruptPins() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    SimulatedMcp23017 expander;
+    JoystickMcp23017 buttons(joystick, expander, ADDRESS);
+    joystick.begin(true);
+    buttons.setInterruptPins(INTA_PIN, INTB_PIN);
+    buttons.begin();
+
+    // Nothing signalled, nothing read
+    uint32_t reads = totalReads(expander);
+    for (int loop = 0; loop < 10; loop++) {
+        CHECK(!buttons.update());
+    }
+    CHECK_EQUAL(reads, totalReads(expander));
+
+    // Only the signalled port is read
+    uint32_t readsA = expander.reads[0];
+    uint32_t readsB = expander.reads[1];
+    mockReports.clear();
+    expander.setPin(1, 1, true);
+    CHECK_EQUAL(LOW, mockPins[INTB_PIN]);
+    CHECK(buttons.update());
+    CHECK_EQUAL(readsA, expander.reads[0]);
+    CHECK_EQUAL(readsB + 1, expander.reads[1]);
+    CHECK_EQUAL(HIGH, mockPins[INTB_PIN]);
+    CHECK(reportButton(joystick, 9));
+    CHECK_EQUAL(1, mockReports.size());
+}
+
+// With only INTA the outputs are mirrored and either port reads both
+static void testMirroredInterrupt() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    SimulatedMcp23017 expander;
+    JoystickMcp23017 buttons(joystick, expander, ADDRESS);
+    joystick.begin(true);
+    buttons.setInterruptPins(INTA_PIN);
+    buttons.begin();
+
+    uint32_t reads = totalReads(expander);
+    CHECK(!buttons.update());
+    CHECK_EQUAL(reads, totalReads(expander));
+
+    expander.setPin(1, 7, true);
+    CHECK_EQUAL(LOW, mockPins[INTA_PIN]);
+    CHECK(buttons.update());
+    CHECK_EQUAL(reads + 2, totalReads(expander));
+    CHECK(reportButton(joystick, 15));
+}
+
+// A press released before the read is still reported for one update
+static void testShortPulse() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    SimulatedMcp23017 expander;
+    JoystickMcp23017 buttons(joystick, expander, ADDRESS);
+    joystick.begin(true);
+    buttons.setInterruptPins(INTA_PIN, INTB_PIN);
+    buttons.begin();
+
+    mockReports.clear();
+    expander.setPin(0, 0, true);
+    expander.setPin(0, 0, false);
+    CHECK(buttons.update());
+    CHECK(reportButton(joystick, 0));
+
+    // The release follows without another interrupt
+    CHECK_EQUAL(HIGH, mockPins[INTA_PIN]);
+    CHECK(buttons.update());
+    CHECK(!reportButton(joystick, 0));
+    CHECK_EQUAL(2, mockReports.size());
+
+    CHECK(!buttons.update());
+}
+
+// A pin-change handler without interrupt pins: no polling at all
+static void testInterruptDriven() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    SimulatedMcp23017 expander;
+    JoystickMcp23017 buttons(joystick, expander, ADDRESS);
+    joystick.begin(true);
+    buttons.setInterruptDriven(true);
+    buttons.begin();
+
+    uint32_t reads = totalReads(expander);
+    for (int loop = 0; loop < 10; loop++) {
+        CHECK(!buttons.update());
+    }
+    CHECK_EQUAL(reads, totalReads(expander));
+
+    expander.setPin(0, 5, true);
+    buttons.interrupt(JOYSTICK_MCP23017_PORT_A);
+    CHECK(buttons.update());
+    CHECK_EQUAL(reads + 1, totalReads(expander));
+    CHECK(reportButton(joystick, 5));
+
+    CHECK(!buttons.update());
+    CHECK_EQUAL(reads + 1, totalReads(expander));
+}
+
+static void testFirstInterruptStopsPolling() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    SimulatedMcp23017 expander;
+    JoystickMcp23017 buttons(joystick, expander, ADDRESS);
+    joystick.begin(true);
+    buttons.begin();
+
+    uint32_t reads = totalReads(expander);
+    buttons.update();
+    CHECK_EQUAL(reads + 2, totalReads(expander));
+
+    buttons.interrupt(JOYSTICK_MCP23017_PORT_B);
+    buttons.update();
+    CHECK_EQUAL(reads + 3, totalReads(expander));
+    buttons.update();
+    CHECK_EQUAL(reads + 3, totalReads(expander));
+}
+
+static void testReadErrorIsRetried() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    SimulatedMcp23017 expander;
+    JoystickMcp23017 buttons(joystick, expander, ADDRESS);
+    joystick.begin(true);
+    buttons.setInterruptDriven(true);
+    buttons.begin();
+
+    expander.setPin(0, 2, true);
+    buttons.interrupt(JOYSTICK_MCP23017_PORT_A);
+    expander.failReads = 1;
+    CHECK(!buttons.update());
+    CHECK_EQUAL(1, buttons.getErrorCount());
+
+    CHECK(buttons.update());
+    CHECK(reportButton(joystick, 2));
+}
+
+int main() {
+    RUN_TEST(testBeginConfigures);
+    RUN_TEST(testPollingWithoutPins);
+    RUN_TEST(testInterruptPins);
+    RUN_TEST(testMirroredInterrupt);
+    RUN_TEST(testShortPulse);
+    RUN_TEST(testInterruptDriven);
+    RUN_TEST(testFirstInterruptStopsPolling);
+    RUN_TEST(testReadErrorIsRetried);
+    return testResult();
+}
@@ -0,0 +1,161 @@
+//
+// test_motion.cpp
+//
+
+#include <cmath>
+#include "TestSupport.h"
+#include "JoystickMath.h"
+#include "JoystickMotion.h"
+
+#define BINARY_ANGLE_PER_DEGREE (65536.0 / 360.0)
+
+static double wrapDegrees(double degrees) {
+    while (degrees > 180.0) degrees -= 360.0;
+    while (degrees < -180.0) degrees += 360.0;
+    return degrees;
+}
+
+static void testSqrt() {
+    for (uint32_t value = 0; value < 0x100000; value += 7) {
+        CHECK_EQUAL((uint32_t) floor(sqrt((double) value)), joystickSqrt(value));
+    }
+    CHECK_EQUAL(65535, joystickSqrt(0xFFFFFFFF));
+    CHECK_EQUAL(46339, joystickSqrt(2UL * 32767 * 32767));
+}
+
+static void testAtan2() {
+    double maximumError = 0;
+
+    for (uint32_t radius = 10; radius <= 1000000; radius *= 3) {
+        for (int step = 0; step < 3600; step++) {
+            double radians = step * M_PI / 1800.0;
+            int32_t x = (int32_t) lround(radius * cos(radians));
+            int32_t y = (int32_t) lround(radius * sin(radians));
+            double expected = atan2((double) y, (double) x) * 180.0 / M_PI;
+            double actual = joystickAtan2(y, x) / BINARY_ANGLE_PER_DEGREE;
+            double error = fabs(wrapDegrees(actual - expected));
+            if (error > maximumError) maximumError = error;
+        }
+    }
+
+    printf("  atan2 maximum error %.4f degrees\n", maximumError);
+    CHECK(maximumError < 0.025);
+    CHECK_EQUAL(0, joystickAtan2(0, 0));
+}
+
+static void testSinCos() {
+    int maximumError = 0;
+
+    for (uint32_t angle = 0; angle < 65536; angle++) {
+        double radians = angle * 2.0 * M_PI / 65536.0;
+        int sinError = abs(joystickSin((uint16_t) angle) - (int) lround(32767 * sin(radians)));
+        int cosError = abs(joystickCos((uint16_t) angle) - (int) lround(32767 * cos(radians)));
+        maximumError = max(maximumError, max(sinError, cosError));
+    }
+
+    printf("  sin/cos maximum error %d counts\n", maximumError);
+    CHECK(maximumError <= 4);
+}
+
+static void testCrc16() {
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    CHECK_EQUAL(0x29B1, joystickCrc16(check, sizeof(check)));
+    CHECK_EQUAL(0x29B1, joystickCrc16(&check[4], 5, joystickCrc16(check, 4)));
+}
+
+// Raw 16-bit accelerometer reading for a tilt, 1 g = 16384
+static void tiltedGravity(double rollDegrees, int16_t &y, int16_t &z) {
+    y = (int16_t) lround(16384 * sin(rollDegrees * M_PI / 180.0));
+    z = (int16_t) lround(16384 * cos(rollDegrees * M_PI / 180.0));
+}
+
+static void testSeedFromAccelerometer() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    Joystick_ joystick(builder);
+    JoystickMotion motion(joystick);
+    int16_t y;
+    int16_t z;
+
+    tiltedGravity(30, y, z);
+    motion.begin(0, y, z);
+    CHECK_NEAR(30 * BINARY_ANGLE_PER_DEGREE, motion.getRoll(), 2);
+    CHECK_NEAR(0, motion.getPitch(), 2);
+
+    motion.begin(-8192, 0, 14189);
+    CHECK_NEAR(30 * BINARY_ANGLE_PER_DEGREE, motion.getPitch(), 3);
+}
+
+static void testFilterConvergesToGravity() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    Joystick_ joystick(builder);
+    JoystickMotion motion(joystick);
+    int16_t y;
+    int16_t z;
+
+    motion.begin(0, 0, 16384);
+    tiltedGravity(-45, y, z);
+
+    // Time constant of 2^6 samples
+    for (int sample = 0; sample < 64; sample++) {
+        motion.update(0, y, z, 0, 0, 0);
+    }
+    CHECK_NEAR(-45 * (1 - exp(-1.0)) * BINARY_ANGLE_PER_DEGREE, motion.getRoll(), 40);
+
+    for (int sample = 0; sample < 2000; sample++) {
+        motion.update(0, y, z, 0, 0, 0);
+    }
+    CHECK_NEAR(-45 * BINARY_ANGLE_PER_DEGREE, motion.getRoll(), 64);
+}
+
+static void testGyroIntegration() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    Joystick_ joystick(builder);
+    JoystickMotion motion(joystick);
+    motion.begin(0, 0, 16384);
+
+    // 90 deg/s for one second at 1 kHz with the 2000 deg/s range
+    int16_t rate = (int16_t) lround(90.0 * 32768 / 2000);
+    for (int sample = 0; sample < 1000; sample++) {
+        motion.update(0, 0, 16384, 0, 0, rate);
+    }
+    double expected = rate * 2000.0 / 32768;
+    CHECK_NEAR(expected, motion.getYaw() / BINARY_ANGLE_PER_DEGREE, 0.05);
+
+    // Bias is removed before integration
+    motion.resetYaw();
+    motion.setGyroBias(0, 0, 25);
+    for (int sample = 0; sample < 1000; sample++) {
+        motion.update(0, 0, 16384, 0, 0, 25);
+    }
+    CHECK_EQUAL(0, motion.getYaw());
+}
+
+static void testReportDivider() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.includeRxAxis(true).includeRyAxis(true).includeRzAxis(true);
+    Joystick_ joystick(builder);
+    JoystickMotion motion(joystick);
+    joystick.begin(true);
+    motion.begin(0, 0, 16384);
+    motion.setReportDivider(4);
+    mockReports.clear();
+
+    uint8_t updates = 0;
+    for (int sample = 0; sample < 16; sample++) {
+        if (motion.update(0, 0, 16384, 0, 0, 1000)) updates++;
+    }
+    CHECK_EQUAL(4, updates);
+    CHECK_EQUAL(4, mockReports.size());
+}
+
+int main() {
+    RUN_TEST(testSqrt);
+    RUN_TEST(testAtan2);
+    RUN_TEST(testSinCos);
+    RUN_TEST(testCrc16);
+    RUN_TEST(testSeedFromAccelerometer);
+    RUN_TEST(testFilterConvergesToGravity);
+    RUN_TEST(testGyroIntegration);
+    RUN_TEST(testReportDivider);
+    return testResult();
+}
@@ -0,0 +1,125 @@
+//
+// test_profiler.cpp
+//
+// Stage profiler, built together with the library with
+// JOYSTICK_ENABLE_PROFILER (see the Makefile): statistics, the stages timed
+// by sendState() and the dump() format.
+//
+
+#include <string>
+#include "TestSupport.h"
+#include "Joystick.h"
+#include "JoystickProfiler.h"
+
+#if !defined(JOYSTICK_ENABLE_PROFILER)
+#error "test_profiler needs JOYSTICK_ENABLE_PROFILER"
+#endif
+
+// Collects everything written to it
+class StringPrint : public Print {
+public:
+    std::string text;
+
+    size_t write(uint8_t value) override {
+        text += (char) value;
+        return 1;
+    }
+};
+
+static void testStatistics() {
+    JoystickProfiler::begin();
+
+    JoystickProfiler::record(JOYSTICK_STAGE_SCAN, 30);
+    JoystickProfiler::record(JOYSTICK_STAGE_SCAN, 10);
+    JoystickProfiler::record(JOYSTICK_STAGE_SCAN, 23);
+    JoystickProfiler::record(JOYSTICK_STAGE_FILTER, 0);
+
+    const JoystickProfileStats &scan = JoystickProfiler::getStats(JOYSTICK_STAGE_SCAN);
+    CHECK_EQUAL(3, scan.count);
+    CHECK_EQUAL(10, scan.minimum);
+    CHECK_EQUAL(30, scan.maximum);
+    CHECK_EQUAL(63, scan.total);
+    CHECK_EQUAL(21, scan.average());
+
+    // A zero sample is a minimum, not an empty stage
+    const JoystickProfileStats &filter = JoystickProfiler::getStats(JOYSTICK_STAGE_FILTER);
+    CHECK_EQUAL(1, filter.count);
+    CHECK_EQUAL(0, filter.minimum);
+
+    CHECK_EQUAL(0, JoystickProfiler::getStats(JOYSTICK_STAGE_SEND).count);
+    CHECK_EQUAL(0, JoystickProfiler::getStats(JOYSTICK_STAGE_SEND).average());
+
+    // Totals do not wrap at 32 bits
+    JoystickProfiler::record(JOYSTICK_STAGE_SEND, 0xFFFFFFFF);
+    JoystickProfiler::record(JOYSTICK_STAGE_SEND, 0xFFFFFFFF);
+    CHECK_EQUAL(0xFFFFFFFF, JoystickProfiler::getStats(JOYSTICK_STAGE_SEND).average());
+
+    JoystickProfiler::reset();
+    for (uint8_t stage = 0; stage < JOYSTICK_STAGE_COUNT; stage++) {
+        const JoystickProfileStats &stats = JoystickProfiler::getStats((JoystickProfileStage) stage);
+        CHECK_EQUAL(0, stats.count);
+        CHECK_EQUAL(0, stats.maximum);
+        CHECK_EQUAL(0, stats.total);
+    }
+}
+
+static void testMacrosRecordStages() {
+    JoystickProfiler::begin();
+
+    {
+        JOYSTICK_PROFILE_BEGIN(JOYSTICK_STAGE_FILTER);
+        JOYSTICK_PROFILE_END(JOYSTICK_STAGE_FILTER);
+    }
+    CHECK_EQUAL(1, JoystickProfiler::getStats(JOYSTICK_STAGE_FILTER).count);
+
+    // sendState() times encoding and sending of every report
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(8).includeXAxis(true);
+    Joystick_ joystick(builder);
+    joystick.begin(false);
+    for (uint32_t index = 0; index < 4; index++) {
+        joystick.setXAxis(index);
+        joystick.sendState();
+    }
+
+    for (JoystickProfileStage stage: {JOYSTICK_STAGE_ENCODE, JOYSTICK_STAGE_SEND}) {
+        const JoystickProfileStats &stats = JoystickProfiler::getStats(stage);
+        CHECK_EQUAL(5, stats.count);
+        CHECK(stats.minimum <= stats.average());
+        CHECK(stats.average() <= stats.maximum);
+    }
+    CHECK_EQUAL(0, JoystickProfiler::getStats(JOYSTICK_STAGE_SCAN).count);
+}
+
+static void testDumpFormat() {
+    JoystickProfiler::begin();
+    JoystickProfiler::record(JOYSTICK_STAGE_SCAN, 12);
+    JoystickProfiler::record(JOYSTICK_STAGE_SCAN, 18);
+    JoystickProfiler::record(JOYSTICK_STAGE_SEND, 1000);
+
+    StringPrint output;
+    JoystickProfiler::dump(output);
+
+    std::string unit = JoystickProfiler::getUnit();
+    std::string expected =
+            "scan: n=2 min=12 avg=15 max=18 " + unit + "\n"
+            "filter: n=0 min=0 avg=0 max=0 " + unit + "\n"
+            "encode: n=0 min=0 avg=0 max=0 " + unit + "\n"
+            "send: n=1 min=1000 avg=1000 max=1000 " + unit + "\n";
+    CHECK(output.text == expected);
+    if (output.text != expected) {
+        printf("%s", output.text.c_str());
+    }
+
+    // The TSC on the host
+    CHECK(unit == "cycles");
+    CHECK(std::string(JoystickProfiler::getStageName(JOYSTICK_STAGE_ENCODE)) == "encode");
+    CHECK(std::string(JoystickProfiler::getStageName(JOYSTICK_STAGE_COUNT)).empty());
+}
+
+int main() {
+    RUN_TEST(testStatistics);
+    RUN_TEST(testMacrosRecordStages);
+    RUN_TEST(testDumpFormat);
+    return testResult();
+}
@@ -0,0 +1,88 @@
+//
+// test_radial_deadzone.cpp
+//
+
+#include <cmath>
+#include "TestSupport.h"
+#include "Joystick.h"
+
+// X and Y only, so the report holds the two 16-bit values
+static JoystickBuilder createBuilder() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.includeXAxis(true).includeYAxis(true);
+    return builder;
+}
+
+static int32_t reportAxis(const Joystick_ &joystick, uint8_t offset) {
+    const uint8_t *report = joystick.getReport();
+    int32_t value = report[offset] | (report[offset + 1] << 8);
+    return value - JOYSTICK_RADIAL_MAXIMUM - (value > JOYSTICK_RADIAL_MAXIMUM);
+}
+
+static void sendStick(Joystick_ &joystick, int32_t x, int32_t y) {
+    joystick.beginUpdate();
+    joystick.setXAxis(x);
+    joystick.setYAxis(y);
+    joystick.endUpdate();
+}
+
+static double outputLength(const Joystick_ &joystick) {
+    return hypot(reportAxis(joystick, 0), reportAxis(joystick, 2));
+}
+
+static void testSquareGateCornerOnCircle() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(true);
+    joystick.setRadialDeadzone(JOYSTICK_AXIS_PAIR_XY, 0, JOYSTICK_RADIAL_MAXIMUM, true);
+
+    sendStick(joystick, 1023, 1023);
+    CHECK_NEAR(23170, reportAxis(joystick, 0), 2);
+    CHECK_NEAR(23170, reportAxis(joystick, 2), 2);
+    CHECK_NEAR(JOYSTICK_RADIAL_MAXIMUM, outputLength(joystick), 3);
+
+    // The middle of a gate edge is full deflection too
+    sendStick(joystick, 1023, 511);
+    CHECK_NEAR(JOYSTICK_RADIAL_MAXIMUM, reportAxis(joystick, 0), 2);
+    CHECK_NEAR(0, reportAxis(joystick, 2), 40);
+
+    // Half way to a corner is half the circle radius
+    sendStick(joystick, 767, 767);
+    CHECK_NEAR(JOYSTICK_RADIAL_MAXIMUM / 2, outputLength(joystick), 40);
+}
+
+static void testCircularGateClipsCorner() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(true);
+    joystick.setRadialDeadzone(JOYSTICK_AXIS_PAIR_XY, 0);
+
+    sendStick(joystick, 1023, 1023);
+    CHECK_NEAR(23170, reportAxis(joystick, 0), 2);
+    CHECK_NEAR(23170, reportAxis(joystick, 2), 2);
+
+    sendStick(joystick, 767, 511);
+    CHECK_NEAR(16400, reportAxis(joystick, 0), 40);
+}
+
+static void testDeadzoneAndSaturation() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(true);
+    joystick.setRadialDeadzone(JOYSTICK_AXIS_PAIR_XY, 3277, 29491, true);
+
+    sendStick(joystick, 560, 540);
+    CHECK_EQUAL(0, reportAxis(joystick, 0));
+    CHECK_EQUAL(0, reportAxis(joystick, 2));
+
+    // Beyond the saturation radius of the square the output stays on the circle
+    sendStick(joystick, 1000, 1023);
+    CHECK_NEAR(JOYSTICK_RADIAL_MAXIMUM, outputLength(joystick), 3);
+}
+
+int main() {
+    RUN_TEST(testSquareGateCornerOnCircle);
+    RUN_TEST(testCircularGateClipsCorner);
+    RUN_TEST(testDeadzoneAndSaturation);
+    return testResult();
+}
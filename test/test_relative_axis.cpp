@@ -0,0 +1,178 @@
+//
+// test_relative_axis.cpp
+//
+// Relative axes: descriptor items, the per-report clamp and the carry-over of
+// deltas that do not fit into one report.
+//
+
+#include <vector>
+#include "TestSupport.h"
+#include "Joystick.h"
+
+// Report layout of createBuilder(): buttons, X, Y (relative), Z (absolute)
+#define X_OFFSET 2
+#define Y_OFFSET 4
+
+static JoystickBuilder createBuilder() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(8);
+    builder.includeXAxis(true).includeYAxis(true).includeZAxis(true);
+    builder.setXAxisRelative(true).setYAxisRelative(true);
+    return builder;
+}
+
+static bool containsBytes(const uint8_t *data, uint16_t size, const std::vector<uint8_t> &expected) {
+    for (uint16_t start = 0; start + expected.size() <= size; start++) {
+        if (memcmp(data + start, expected.data(), expected.size()) == 0) return true;
+    }
+    return false;
+}
+
+static int16_t reportValue(const std::vector<uint8_t> &report, uint8_t offset) {
+    return (int16_t) (report[offset] | (report[offset + 1] << 8));
+}
+
+static void testDescriptorDeclaresRelativeInput() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+
+    const uint8_t *descriptor = joystick.getDescriptor();
+    uint16_t size = joystick.getDescriptorSize();
+
+    // X and Y share one INPUT (Data,Var,Rel) item with a symmetric range
+    CHECK(containsBytes(descriptor, size, {
+            0x16, 0x01, 0x80,
+            0x26, 0xFF, 0x7F,
+            0x95, 0x02,
+            0x09, 0x30, 0x09, 0x31,
+            0x81, 0x06}));
+
+    // Z stays INPUT (Data,Var,Abs)
+    CHECK(containsBytes(descriptor, size, {
+            0x95, 0x01,
+            0x09, 0x32,
+            0x81, 0x02}));
+    CHECK_EQUAL(7, joystick.getReportSize());
+}
+
+static void testDeltaIsClampedPerReport() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(false);
+    mockReports.clear();
+
+    joystick.moveAxis(JOYSTICK_FIELD_X_AXIS, 100000);
+    joystick.moveAxis(JOYSTICK_FIELD_Y_AXIS, -40000);
+    CHECK(joystick.hasPendingRelative());
+    CHECK_EQUAL(0, mockReports.size());
+
+    // Manual mode: each sendState() carries at most the field range
+    std::vector<int32_t> x, y;
+    while (joystick.hasPendingRelative()) {
+        joystick.sendState();
+        x.push_back(reportValue(mockReports.back(), X_OFFSET));
+        y.push_back(reportValue(mockReports.back(), Y_OFFSET));
+    }
+    CHECK_EQUAL(4, x.size());
+    CHECK_EQUAL(JOYSTICK_RELATIVE_MAXIMUM, x[0]);
+    CHECK_EQUAL(JOYSTICK_RELATIVE_MAXIMUM, x[1]);
+    CHECK_EQUAL(JOYSTICK_RELATIVE_MAXIMUM, x[2]);
+    CHECK_EQUAL(100000 - 3 * JOYSTICK_RELATIVE_MAXIMUM, x[3]);
+    CHECK_EQUAL(JOYSTICK_RELATIVE_MINIMUM, y[0]);
+    CHECK_EQUAL(-40000 - JOYSTICK_RELATIVE_MINIMUM, y[1]);
+    CHECK_EQUAL(0, y[2]);
+
+    // -32768 is never sent
+    CHECK_EQUAL(0x01, mockReports[0][Y_OFFSET]);
+    CHECK_EQUAL(0x80, mockReports[0][Y_OFFSET + 1]);
+
+    // Nothing is left: further reports carry no movement
+    joystick.sendState();
+    joystick.sendState();
+    CHECK_EQUAL(0, reportValue(mockReports.back(), X_OFFSET));
+    CHECK_EQUAL(0, joystick.getChangedFields() & JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_X_AXIS));
+}
+
+static void testDeltasAccumulateBetweenReports() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(false);
+    mockReports.clear();
+
+    joystick.moveAxis(JOYSTICK_FIELD_X_AXIS, 10);
+    joystick.moveAxis(JOYSTICK_FIELD_X_AXIS, 20);
+    joystick.moveAxis(JOYSTICK_FIELD_X_AXIS, -5);
+    joystick.setZAxis(300);
+    joystick.sendState();
+    CHECK_EQUAL(1, mockReports.size());
+    CHECK_EQUAL(25, reportValue(mockReports[0], X_OFFSET));
+    CHECK(!joystick.hasPendingRelative());
+
+    // The same delta again is a movement, not an unchanged field
+    joystick.moveAxis(JOYSTICK_FIELD_X_AXIS, 25);
+    joystick.sendState();
+    CHECK_EQUAL(25, reportValue(mockReports[1], X_OFFSET));
+    CHECK(joystick.getChangedFields() & JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_X_AXIS));
+
+    // Moving an absolute axis does nothing
+    joystick.moveAxis(JOYSTICK_FIELD_THROTTLE, 25);
+    CHECK_EQUAL(0, joystick.getPendingFields());
+}
+
+static void testAutoSendFlushesRemainder() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(true);
+    mockReports.clear();
+
+    // A fast flick followed by nothing: the remainder still goes out
+    joystick.moveAxis(JOYSTICK_FIELD_X_AXIS, 70000);
+    CHECK_EQUAL(3, mockReports.size());
+    int32_t sum = 0;
+    for (const std::vector<uint8_t> &report : mockReports) {
+        sum += reportValue(report, X_OFFSET);
+    }
+    CHECK_EQUAL(70000, sum);
+    CHECK_EQUAL(70000 - 2 * JOYSTICK_RELATIVE_MAXIMUM, reportValue(mockReports[2], X_OFFSET));
+    CHECK(!joystick.hasPendingRelative());
+    CHECK_EQUAL(0, joystick.getPendingFields());
+
+    // A batch sends one report plus what does not fit
+    mockReports.clear();
+    joystick.beginUpdate();
+    joystick.moveAxis(JOYSTICK_FIELD_X_AXIS, -50000);
+    joystick.moveAxis(JOYSTICK_FIELD_Y_AXIS, 5);
+    CHECK_EQUAL(0, mockReports.size());
+    joystick.endUpdate();
+    CHECK_EQUAL(2, mockReports.size());
+    CHECK_EQUAL(JOYSTICK_RELATIVE_MINIMUM, reportValue(mockReports[0], X_OFFSET));
+    CHECK_EQUAL(5, reportValue(mockReports[0], Y_OFFSET));
+    CHECK_EQUAL(-50000 - JOYSTICK_RELATIVE_MINIMUM, reportValue(mockReports[1], X_OFFSET));
+    CHECK_EQUAL(0, reportValue(mockReports[1], Y_OFFSET));
+}
+
+static void testAutoSendHoldsRemainderWhileSuspended() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(true);
+
+    joystick.setSuspended(true);
+    mockReports.clear();
+    joystick.moveAxis(JOYSTICK_FIELD_X_AXIS, 40000);
+    CHECK_EQUAL(0, mockReports.size());
+    CHECK(joystick.hasPendingRelative());
+
+    joystick.setSuspended(false);
+    CHECK_EQUAL(2, mockReports.size());
+    CHECK_EQUAL(JOYSTICK_RELATIVE_MAXIMUM, reportValue(mockReports[0], X_OFFSET));
+    CHECK_EQUAL(40000 - JOYSTICK_RELATIVE_MAXIMUM, reportValue(mockReports[1], X_OFFSET));
+}
+
+int main() {
+    RUN_TEST(testDescriptorDeclaresRelativeInput);
+    RUN_TEST(testDeltaIsClampedPerReport);
+    RUN_TEST(testDeltasAccumulateBetweenReports);
+    RUN_TEST(testAutoSendFlushesRemainder);
+    RUN_TEST(testAutoSendHoldsRemainderWhileSuspended);
+    return testResult();
+}
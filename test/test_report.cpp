@@ -0,0 +1,187 @@
+//
+// test_report.cpp
+//
+// The last sent report and the change masks: getReport() against the bytes
+// handed to the HID core, changed versus pending fields around sendState(),
+// hat switch nibbles and batched updates.
+//
+
+#include "TestSupport.h"
+#include "Joystick.h"
+
+// Report layout of createBuilder()
+#define HAT_OFFSET      2
+#define X_OFFSET        3
+#define Y_OFFSET        5
+#define THROTTLE_OFFSET 7
+#define REPORT_SIZE     9
+
+static JoystickBuilder createBuilder() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(16).setHatSwitchCount(2);
+    builder.includeXAxis(true).includeYAxis(true).includeThrottle(true);
+    return builder;
+}
+
+static uint16_t reportValue(const uint8_t report[], uint8_t offset) {
+    return (uint16_t) (report[offset] | (report[offset + 1] << 8));
+}
+
+static void checkLastReport(const Joystick_ &joystick) {
+    CHECK(!mockReports.empty());
+    if (mockReports.empty()) return;
+
+    const std::vector<uint8_t> &sent = mockReports.back();
+    CHECK_EQUAL(joystick.getReportId(), sent[0]);
+    CHECK_EQUAL(joystick.getReportSize() + 1, sent.size());
+    CHECK_EQUAL(0, memcmp(joystick.getReport(), sent.data() + 1, joystick.getReportSize()));
+}
+
+static void testReportMatchesSentBytes() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(true);
+    CHECK_EQUAL(REPORT_SIZE, joystick.getReportSize());
+    checkLastReport(joystick);
+
+    joystick.pressButton(0);
+    joystick.pressButton(9);
+    joystick.setXAxis(1023);
+    joystick.setYAxis(0);
+    joystick.setThrottleRange(0, 255);
+    joystick.setThrottle(255);
+    checkLastReport(joystick);
+
+    const uint8_t *report = joystick.getReport();
+    CHECK_EQUAL(0x01, report[0]);
+    CHECK_EQUAL(0x02, report[1]);
+    CHECK_EQUAL(0xFFFF, reportValue(report, X_OFFSET));
+    CHECK_EQUAL(0x0000, reportValue(report, Y_OFFSET));
+    CHECK_EQUAL(0xFFFF, reportValue(report, THROTTLE_OFFSET));
+}
+
+static void testChangedAndPendingFields() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(false);
+    CHECK_EQUAL(0, joystick.getPendingFields());
+    uint16_t initial = joystick.getChangedFields();
+
+    // Pending collects setters until the next send, changed stays put
+    joystick.setXAxis(700);
+    joystick.pressButton(3);
+    CHECK_EQUAL(JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_X_AXIS) | JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_BUTTONS),
+                joystick.getPendingFields());
+    CHECK_EQUAL(initial, joystick.getChangedFields());
+
+    // Sending moves it over to changed
+    joystick.sendState();
+    CHECK_EQUAL(0, joystick.getPendingFields());
+    CHECK_EQUAL(JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_X_AXIS) | JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_BUTTONS),
+                joystick.getChangedFields());
+
+    // Setting the same value again is not pending, a resend changes nothing
+    joystick.setXAxis(700);
+    CHECK_EQUAL(0, joystick.getPendingFields());
+    joystick.sendState();
+    CHECK_EQUAL(0, joystick.getChangedFields());
+
+    // A change that encodes to the same report bytes is pending but not
+    // changed
+    joystick.setThrottleRange(0, 65535 * 2);
+    joystick.setThrottle(0);
+    joystick.setThrottle(1);
+    CHECK_EQUAL(JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_THROTTLE), joystick.getPendingFields());
+    joystick.sendState();
+    CHECK_EQUAL(0, joystick.getChangedFields());
+
+    // Changed only compares the last two reports
+    joystick.setYAxis(100);
+    joystick.setYAxis(0);
+    joystick.sendState();
+    CHECK_EQUAL(0, joystick.getChangedFields());
+}
+
+static void testHatSwitchNibbles() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(false);
+
+    // Both released
+    CHECK_EQUAL(0x88, joystick.getReport()[HAT_OFFSET]);
+
+    joystick.setHatSwitch(0, 90);
+    joystick.sendState();
+    CHECK_EQUAL(0x82, joystick.getReport()[HAT_OFFSET]);
+    CHECK_EQUAL(JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_HAT_SWITCH_0), joystick.getChangedFields());
+
+    joystick.setHatSwitch(1, 315);
+    joystick.sendState();
+    CHECK_EQUAL(0x72, joystick.getReport()[HAT_OFFSET]);
+    CHECK_EQUAL(JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_HAT_SWITCH_1), joystick.getChangedFields());
+
+    // 405 degrees wraps to 45, intermediate angles round down
+    joystick.setHatSwitch(0, 405);
+    joystick.setHatSwitch(1, 100);
+    joystick.sendState();
+    CHECK_EQUAL(0x21, joystick.getReport()[HAT_OFFSET]);
+    CHECK_EQUAL(JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_HAT_SWITCH_0) | JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_HAT_SWITCH_1),
+                joystick.getChangedFields());
+
+    joystick.setHatSwitch(0, JOYSTICK_HATSWITCH_RELEASE);
+    joystick.sendState();
+    CHECK_EQUAL(0x28, joystick.getReport()[HAT_OFFSET]);
+
+    // Hat switches beyond the configured count are ignored
+    joystick.setHatSwitch(2, 0);
+    CHECK_EQUAL(0, joystick.getPendingFields());
+}
+
+static void testBatchedUpdateSendsOneReport() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(true);
+    mockReports.clear();
+
+    joystick.beginUpdate();
+    joystick.setXAxis(100);
+    joystick.setYAxis(200);
+    joystick.pressButton(15);
+    joystick.setHatSwitch(1, 180);
+
+    // Nested batches send once the outermost one ends
+    joystick.beginUpdate();
+    joystick.setThrottle(50);
+    joystick.endUpdate();
+    CHECK_EQUAL(0, mockReports.size());
+
+    joystick.endUpdate();
+    CHECK_EQUAL(1, mockReports.size());
+    checkLastReport(joystick);
+    CHECK_EQUAL(0x80, joystick.getReport()[1]);
+    CHECK_EQUAL(0x48, joystick.getReport()[HAT_OFFSET]);
+    CHECK_EQUAL(JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_X_AXIS) | JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_Y_AXIS) |
+                JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_BUTTONS) | JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_HAT_SWITCH_1) |
+                JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_THROTTLE), joystick.getChangedFields());
+
+    // A batch without changes sends nothing, an unmatched end is ignored
+    joystick.beginUpdate();
+    joystick.endUpdate();
+    joystick.endUpdate();
+    CHECK_EQUAL(1, mockReports.size());
+
+    // setButtonBytes is a batch of its own
+    const uint8_t values[] = {0xA5, 0x5A};
+    joystick.setButtonBytes(0, values, 2);
+    CHECK_EQUAL(2, mockReports.size());
+    CHECK_EQUAL(0xA5, joystick.getReport()[0]);
+    CHECK_EQUAL(0x5A, joystick.getReport()[1]);
+}
+
+int main() {
+    RUN_TEST(testReportMatchesSentBytes);
+    RUN_TEST(testChangedAndPendingFields);
+    RUN_TEST(testHatSwitchNibbles);
+    RUN_TEST(testBatchedUpdateSendsOneReport);
+    return testResult();
+}
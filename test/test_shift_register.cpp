@@ -0,0 +1,140 @@
+//
+// test_shift_register.cpp
+//
+
+#include "TestSupport.h"
+#include "JoystickShiftRegister.h"
+
+// Chain of 74HC165s; the first byte clocked out is chain[0]. The clock line
+// is simulated as well: every rising edge after the load shifts the chain by
+// one bit, including the one from switching to the idle-high SPI mode.
+class SimulatedChain : public JoystickSpiBus {
+public:
+    uint8_t chain[JOYSTICK_SHIFT_REGISTER_MAXIMUM] = {0};
+    uint8_t latched[JOYSTICK_SHIFT_REGISTER_MAXIMUM] = {0};
+    uint32_t latchCount = 0;
+    uint32_t readCount = 0;
+
+    // Clock level; a mode 0 device on the same bus leaves it low
+    bool clockHigh = false;
+    bool sharedWithMode0 = false;
+    bool inTransaction = false;
+
+    void beginTransaction() override {
+        inTransaction = true;
+        setClock(true);
+    }
+
+    void endTransaction() override {
+        inTransaction = false;
+        if (sharedWithMode0) setClock(false);
+    }
+
+    void latch() override {
+        memcpy(latched, chain, sizeof(chain));
+        latchCount++;
+    }
+
+    void read(uint8_t buffer[], uint8_t length) override {
+        // Outside a transaction the read has to set up mode 2 itself
+        if (!inTransaction) setClock(true);
+        memcpy(buffer, latched, length);
+        readCount++;
+    }
+
+private:
+    void setClock(bool high) {
+        if (high && !clockHigh) shift();
+        clockHigh = high;
+    }
+
+    // QH takes the next input; SER is tied low
+    void shift() {
+        for (uint8_t index = 0; index < JOYSTICK_SHIFT_REGISTER_MAXIMUM; index++) {
+            uint8_t next = (index + 1 < JOYSTICK_SHIFT_REGISTER_MAXIMUM) ? latched[index + 1] : 0;
+            latched[index] = (uint8_t) ((latched[index] << 1) | (next >> 7));
+        }
+    }
+};
+
+static bool reportButton(const Joystick_ &joystick, uint8_t button) {
+    return (joystick.getReport()[button / 8] >> (button % 8)) & 1;
+}
+
+static JoystickBuilder createBuilder() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(32);
+    return builder;
+}
+
+static void testOneBurstOneReport() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    SimulatedChain chain;
+    JoystickShiftRegister registers(joystick, chain, 3, 8);
+    joystick.begin(true);
+
+    CHECK(registers.update());
+    mockReports.clear();
+
+    chain.chain[0] = 0x01;
+    chain.chain[2] = 0x80;
+    CHECK(registers.update());
+    CHECK_EQUAL(1, mockReports.size());
+    CHECK_EQUAL(2, chain.readCount);
+    CHECK(reportButton(joystick, 8));
+    CHECK(reportButton(joystick, 31));
+    CHECK(!reportButton(joystick, 0));
+
+    // Unchanged inputs cost a read but no report
+    CHECK(!registers.update());
+    CHECK_EQUAL(1, mockReports.size());
+}
+
+static void testInvertedAndReversed() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    SimulatedChain chain;
+    JoystickShiftRegister registers(joystick, chain, 2);
+    registers.setInverted(true);
+    registers.setReverseOrder(true);
+    joystick.begin(true);
+
+    memset(chain.chain, 0xFF, sizeof(chain.chain));
+    chain.chain[1] = 0xFE;   // register closest to MISO holds buttons 0-7
+    registers.update();
+
+    CHECK_EQUAL(0x01, registers.getValues()[0]);
+    CHECK_EQUAL(0x00, registers.getValues()[1]);
+    CHECK(reportButton(joystick, 0));
+    CHECK(!reportButton(joystick, 8));
+}
+
+static void testModeSwitchDoesNotShiftLatchedInputs() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    SimulatedChain chain;
+    JoystickShiftRegister registers(joystick, chain, 2);
+    joystick.begin(true);
+
+    // First read after SPI.begin(), and every read on a bus shared with a
+    // mode 0 device: the clock idles low until the transaction starts
+    chain.sharedWithMode0 = true;
+    chain.chain[0] = 0x81;
+    chain.chain[1] = 0x42;
+    for (uint8_t read = 0; read < 3; read++) {
+        registers.update();
+        CHECK_EQUAL(0x81, registers.getValues()[0]);
+        CHECK_EQUAL(0x42, registers.getValues()[1]);
+        CHECK(!chain.clockHigh);
+    }
+    CHECK(reportButton(joystick, 7));
+    CHECK(reportButton(joystick, 14));
+}
+
+int main() {
+    RUN_TEST(testOneBurstOneReport);
+    RUN_TEST(testInvertedAndReversed);
+    RUN_TEST(testModeSwitchDoesNotShiftLatchedInputs);
+    return testResult();
+}
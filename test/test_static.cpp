@@ -0,0 +1,111 @@
+//
+// test_static.cpp
+//
+
+#include "TestSupport.h"
+#include "JoystickStatic.h"
+
+#define REPORT_ID 3
+
+struct PedalConfig : JoystickStaticConfig {
+    static constexpr uint8_t reportId = REPORT_ID;
+    static constexpr uint8_t buttonCount = 12;
+    static constexpr uint8_t hatSwitchCount = 1;
+    static constexpr uint8_t axisFlags = JOYSTICK_INCLUDE_X_AXIS | JOYSTICK_INCLUDE_Y_AXIS | JOYSTICK_INCLUDE_RZ_AXIS;
+    static constexpr uint8_t simulatorFlags = JOYSTICK_INCLUDE_THROTTLE | JOYSTICK_INCLUDE_BRAKE;
+
+    static constexpr int32_t xAxisMinimum = 1023;
+    static constexpr int32_t xAxisMaximum = 0;
+    static constexpr int32_t yAxisMinimum = -500;
+    static constexpr int32_t yAxisMaximum = 500;
+    static constexpr int32_t rzAxisMinimum = 0;
+    static constexpr int32_t rzAxisMaximum = 100000;
+    static constexpr int32_t throttleMinimum = 0;
+    static constexpr int32_t throttleMaximum = 255;
+    static constexpr int32_t brakeMinimum = 4095;
+    static constexpr int32_t brakeMaximum = 0;
+};
+
+static void configure(Joystick_ &joystick) {
+    joystick.setXAxisRange(1023, 0);
+    joystick.setYAxisRange(-500, 500);
+    joystick.setRzAxisRange(0, 100000);
+    joystick.setThrottleRange(0, 255);
+    joystick.setBrakeRange(4095, 0);
+}
+
+static JoystickBuilder createBuilder() {
+    JoystickBuilder builder(REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(PedalConfig::buttonCount)
+            .setHatSwitchCount(PedalConfig::hatSwitchCount)
+            .includeAxes(PedalConfig::axisFlags)
+            .includeSimulatorControls(PedalConfig::simulatorFlags);
+    return builder;
+}
+
+// Both send their report; the last two reports must be identical
+static bool sameReports(Joystick_ &joystick, JoystickStatic<PedalConfig> &joystickStatic) {
+    mockReports.clear();
+    joystick.sendState();
+    joystickStatic.sendState();
+    return (mockReports.size() == 2) && (mockReports[0] == mockReports[1]);
+}
+
+static void testLayoutMatches() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickStatic<PedalConfig> joystickStatic;
+
+    CHECK_EQUAL(joystick.getReportSize(), (JoystickStatic<PedalConfig>::reportSize));
+    CHECK(sameReports(joystick, joystickStatic));
+}
+
+static void testPerFieldRanges() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickStatic<PedalConfig> joystickStatic;
+    configure(joystick);
+    int mismatches = 0;
+
+    for (int32_t value = -1000; value <= 110000; value += 7) {
+        joystick.setXAxis(value);
+        joystickStatic.setXAxis(value);
+        joystick.setYAxis(value);
+        joystickStatic.setYAxis(value);
+        joystick.setRzAxis(value);
+        joystickStatic.setRzAxis(value);
+        joystick.setThrottle(value);
+        joystickStatic.setThrottle(value);
+        joystick.setBrake(value);
+        joystickStatic.setBrake(value);
+        if (!sameReports(joystick, joystickStatic)) mismatches++;
+    }
+    CHECK_EQUAL(0, mismatches);
+}
+
+static void testButtonsAndHat() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickStatic<PedalConfig> joystickStatic;
+
+    for (uint8_t button = 0; button < PedalConfig::buttonCount + 2; button += 3) {
+        joystick.pressButton(button);
+        joystickStatic.pressButton(button);
+    }
+    joystick.releaseButton(3);
+    joystickStatic.releaseButton(3);
+    CHECK(sameReports(joystick, joystickStatic));
+
+    for (int16_t angle = -1; angle < 360; angle += 45) {
+        joystick.setHatSwitch(0, angle);
+        joystickStatic.setHatSwitch(0, angle);
+        CHECK(sameReports(joystick, joystickStatic));
+    }
+}
+
+int main() {
+    RUN_TEST(testLayoutMatches);
+    RUN_TEST(testPerFieldRanges);
+    RUN_TEST(testButtonsAndHat);
+    return testResult();
+}
@@ -0,0 +1,67 @@
+//
+// test_suspend.cpp
+//
+
+#include "TestSupport.h"
+#include "Joystick.h"
+
+static uint32_t wakeupCount = 0;
+
+static void countWakeup() {
+    wakeupCount++;
+}
+
+static void testSetterWhileSuspendedWakesAndResumes() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(16);
+    Joystick_ joystick(builder);
+    joystick.begin(true);
+    joystick.setWakeupFields(JOYSTICK_FIELD_MASK(JOYSTICK_FIELD_BUTTONS));
+    joystick.setWakeupCallback(countWakeup);
+    wakeupCount = 0;
+
+    joystick.setSuspended(true);
+    mockReports.clear();
+
+    // Nothing is sent while suspended, but the first wakeup field change
+    // requests exactly one remote wakeup
+    joystick.setXAxis(700);
+    CHECK_EQUAL(0, wakeupCount);
+    joystick.pressButton(4);
+    joystick.pressButton(5);
+    CHECK_EQUAL(1, wakeupCount);
+    CHECK_EQUAL(0, mockReports.size());
+
+    // Resume sends one report with everything accumulated
+    joystick.setSuspended(false);
+    CHECK_EQUAL(1, mockReports.size());
+    CHECK_EQUAL(0x30, mockReports[0][1]);
+    CHECK_EQUAL(0, joystick.getPendingFields());
+
+    // A second suspend may request a new wakeup
+    joystick.setSuspended(true);
+    joystick.releaseButton(4);
+    CHECK_EQUAL(2, wakeupCount);
+}
+
+static void testResumeWithoutChangesSendsNothing() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    Joystick_ joystick(builder);
+    joystick.begin(true);
+
+    joystick.setSuspended(true);
+    mockReports.clear();
+    joystick.setSuspended(false);
+    CHECK_EQUAL(0, mockReports.size());
+
+    // No suspend query on the host: the state is left alone
+    joystick.setSuspended(true);
+    joystick.pollSuspended();
+    CHECK(joystick.isSuspended());
+}
+
+int main() {
+    RUN_TEST(testSetterWhileSuspendedWakesAndResumes);
+    RUN_TEST(testResumeWithoutChangesSendsNothing);
+    return testResult();
+}
@@ -0,0 +1,138 @@
+//
+// test_timed_buttons.cpp
+//
+
+#include "TestSupport.h"
+#include "JoystickTimedButtons.h"
+
+static bool reportButton(const Joystick_ &joystick, uint8_t button) {
+    return (joystick.getReport()[button / 8] >> (button % 8)) & 1;
+}
+
+static JoystickBuilder createBuilder() {
+    JoystickBuilder builder(JOYSTICK_DEFAULT_REPORT_ID, JOYSTICK_TYPE_JOYSTICK);
+    builder.setButtonCount(64);
+    return builder;
+}
+
+// Advances the simulated clock to time (microseconds) one tick at a time
+static void runUntil(JoystickTimedButtons &timers, uint32_t time) {
+    while (mockMicros < time) {
+        mockMicros += 1000;
+        timers.update();
+    }
+}
+
+static void testPulseAndDelayedHold() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(true);
+    JoystickTimedButtons timers(joystick, 1000, mockClock);
+
+    CHECK(timers.pulse(1, 20000));
+    CHECK(timers.holdAfter(2, 100000, 30000));
+    CHECK(reportButton(joystick, 1));
+
+    runUntil(timers, 19000);
+    CHECK(reportButton(joystick, 1));
+    runUntil(timers, 20000);
+    CHECK(!reportButton(joystick, 1));
+    CHECK(!timers.isActive(1));
+
+    runUntil(timers, 99000);
+    CHECK(!reportButton(joystick, 2));
+    runUntil(timers, 100000);
+    CHECK(reportButton(joystick, 2));
+    runUntil(timers, 130000);
+    CHECK(!reportButton(joystick, 2));
+    CHECK_EQUAL(0, timers.getActiveCount());
+}
+
+static void testAutofire() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(true);
+    JoystickTimedButtons timers(joystick, 1000, mockClock);
+
+    // 10 Hz: 50 ms pressed, 50 ms released
+    CHECK(timers.startAutofire(0, 10));
+
+    uint8_t toggles = 0;
+    bool pressed = true;
+    for (uint32_t time = 1000; time <= 500000; time += 1000) {
+        runUntil(timers, time);
+        if (reportButton(joystick, 0) != pressed) {
+            pressed = !pressed;
+            toggles++;
+            CHECK_EQUAL(0, time % 50000);
+        }
+    }
+    CHECK_EQUAL(10, toggles);
+
+    timers.cancel(0);
+    CHECK(!timers.isActive(0));
+    CHECK(!reportButton(joystick, 0));
+}
+
+static void testLongerThanWheel() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(true);
+    JoystickTimedButtons timers(joystick, 1000, mockClock);
+
+    // Several wheel rounds
+    uint32_t duration = 3 * JOYSTICK_TIMER_WHEEL_SIZE * 1000 + 7000;
+    timers.pulse(5, duration);
+
+    runUntil(timers, duration - 1000);
+    CHECK(reportButton(joystick, 5));
+    runUntil(timers, duration);
+    CHECK(!reportButton(joystick, 5));
+}
+
+static void testSimultaneousExpiryIsOneReport() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(true);
+    JoystickTimedButtons timers(joystick, 1000, mockClock);
+
+    for (uint8_t button = 0; button < 20; button++) {
+        timers.pulse(button, 10000);
+    }
+
+    runUntil(timers, 9000);
+    mockReports.clear();
+    runUntil(timers, 10000);
+    CHECK_EQUAL(1, mockReports.size());
+    for (uint8_t button = 0; button < 20; button++) {
+        CHECK(!reportButton(joystick, button));
+    }
+}
+
+static void testCapacity() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    joystick.begin(true);
+    JoystickTimedButtons timers(joystick, 1000, mockClock);
+
+    for (uint8_t button = 0; button < JOYSTICK_TIMER_COUNT; button++) {
+        CHECK(timers.pulse(button, 50000));
+    }
+    CHECK(!timers.pulse(JOYSTICK_TIMER_COUNT, 50000));
+
+    // Replacing the action of a button reuses its timer
+    CHECK(timers.startAutofire(0, 5));
+    CHECK_EQUAL(JOYSTICK_TIMER_COUNT, timers.getActiveCount());
+
+    timers.cancel(1);
+    CHECK(timers.pulse(JOYSTICK_TIMER_COUNT, 50000));
+}
+
+int main() {
+    RUN_TEST(testPulseAndDelayedHold);
+    RUN_TEST(testAutofire);
+    RUN_TEST(testLongerThanWheel);
+    RUN_TEST(testSimultaneousExpiryIsOneReport);
+    RUN_TEST(testCapacity);
+    return testResult();
+}
@@ -0,0 +1,167 @@
+//
+// test_trace.cpp
+//
+// Report trace: the ring after it wrapped, entry order and intervals, and the
+// binary dump checked byte by byte against the layout in JoystickTrace.h.
+//
+
+#include <vector>
+#include "TestSupport.h"
+#include "JoystickTrace.h"
+
+// Collects everything written to it
+class BufferPrint : public Print {
+public:
+    std::vector<uint8_t> bytes;
+
+    size_t write(uint8_t value) override {
+        bytes.push_back(value);
+        return 1;
+    }
+};
+
+static JoystickBuilder createBuilder() {
+    JoystickBuilder builder(3, JOYSTICK_TYPE_GAMEPAD);
+    builder.setButtonCount(8).includeXAxis(true);
+    return builder;
+}
+
+static uint16_t readUInt16(const std::vector<uint8_t> &bytes, size_t offset) {
+    return (uint16_t) (bytes[offset] | (bytes[offset + 1] << 8));
+}
+
+static void testRingWrapsAround() {
+    JoystickTrace trace(mockClock);
+    CHECK_EQUAL(0, trace.getCount());
+
+    // Entry n is n + 1 bytes long, filled with n, and follows the previous
+    // one after 10 * n microseconds
+    uint8_t data[JOYSTICK_REPORT_SIZE_MAXIMUM];
+    uint8_t total = JOYSTICK_TRACE_SIZE + 5;
+    for (uint8_t index = 0; index < total; index++) {
+        mockMicros += 10 * index;
+        memset(data, index, sizeof(data));
+        trace.record(index, data, (uint8_t) (index % JOYSTICK_REPORT_SIZE_MAXIMUM + 1));
+        CHECK_EQUAL((index < JOYSTICK_TRACE_SIZE) ? index + 1 : JOYSTICK_TRACE_SIZE, trace.getCount());
+    }
+
+    // Oldest first: the first five were overwritten
+    for (uint8_t index = 0; index < JOYSTICK_TRACE_SIZE; index++) {
+        const JoystickTraceEntry &entry = trace.getEntry(index);
+        uint8_t recorded = index + 5;
+        CHECK_EQUAL(recorded, entry.reportId);
+        CHECK_EQUAL(recorded % JOYSTICK_REPORT_SIZE_MAXIMUM + 1, entry.length);
+        CHECK_EQUAL(recorded, entry.data[0]);
+        CHECK_EQUAL(recorded, entry.data[entry.length - 1]);
+        CHECK_EQUAL(10 * recorded, entry.interval);
+    }
+
+    // Oversized reports are cut, long gaps saturate
+    mockMicros += 100000;
+    trace.record(99, data, JOYSTICK_REPORT_SIZE_MAXIMUM + 10);
+    const JoystickTraceEntry &last = trace.getEntry(JOYSTICK_TRACE_SIZE - 1);
+    CHECK_EQUAL(99, last.reportId);
+    CHECK_EQUAL(JOYSTICK_REPORT_SIZE_MAXIMUM, last.length);
+    CHECK_EQUAL(0xFFFF, last.interval);
+    CHECK_EQUAL(6, trace.getEntry(0).reportId);
+
+    // clear() restarts the ring and the interval
+    mockMicros += 50;
+    trace.clear();
+    CHECK_EQUAL(0, trace.getCount());
+    mockMicros += 7;
+    trace.record(1, data, 1);
+    CHECK_EQUAL(1, trace.getCount());
+    CHECK_EQUAL(1, trace.getEntry(0).reportId);
+    CHECK_EQUAL(7, trace.getEntry(0).interval);
+}
+
+static void testRecordsSentReports() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickTrace trace(mockClock);
+    joystick.begin(false);
+    joystick.setTrace(&trace);
+    mockReports.clear();
+
+    for (uint32_t index = 0; index < 3; index++) {
+        mockMicros += 1000;
+        joystick.setXAxis(100 * index);
+        joystick.sendState();
+    }
+
+    CHECK_EQUAL(3, trace.getCount());
+    for (uint8_t index = 0; index < 3; index++) {
+        const JoystickTraceEntry &entry = trace.getEntry(index);
+        const std::vector<uint8_t> &sent = mockReports[index];
+        CHECK_EQUAL(sent[0], entry.reportId);
+        CHECK_EQUAL(sent.size() - 1, entry.length);
+        CHECK_EQUAL(0, memcmp(sent.data() + 1, entry.data, entry.length));
+        CHECK_EQUAL(1000, entry.interval);
+    }
+
+    joystick.setTrace(nullptr);
+    joystick.sendState();
+    CHECK_EQUAL(3, trace.getCount());
+}
+
+static void testDumpLayout() {
+    JoystickBuilder builder = createBuilder();
+    Joystick_ joystick(builder);
+    JoystickTrace trace(mockClock);
+    joystick.begin(false);
+    joystick.setTrace(&trace);
+    mockReports.clear();
+
+    // Past capacity, so the dump starts in the middle of the ring
+    uint32_t total = JOYSTICK_TRACE_SIZE + 9;
+    for (uint32_t index = 0; index < total; index++) {
+        mockMicros += 250 + index;
+        joystick.pressButton(index % 8);
+        joystick.setXAxis(index);
+        joystick.sendState();
+    }
+
+    BufferPrint output;
+    trace.dump(output, joystick);
+    const std::vector<uint8_t> &bytes = output.bytes;
+
+    // Header: magic, version, descriptor size and bytes
+    uint16_t descriptorSize = joystick.getDescriptorSize();
+    uint8_t reportSize = joystick.getReportSize();
+    CHECK_EQUAL(4 + 1 + 2 + descriptorSize + 2 + JOYSTICK_TRACE_SIZE * (4 + reportSize), bytes.size());
+    if (bytes.size() < 9u + descriptorSize) return;
+    CHECK_EQUAL(0, memcmp(bytes.data(), "JTRC", 4));
+    CHECK_EQUAL(JOYSTICK_TRACE_VERSION, bytes[4]);
+    CHECK_EQUAL(descriptorSize, readUInt16(bytes, 5));
+    CHECK_EQUAL(0, memcmp(bytes.data() + 7, joystick.getDescriptor(), descriptorSize));
+
+    // Entries: the last JOYSTICK_TRACE_SIZE reports, oldest first
+    size_t offset = 7 + descriptorSize;
+    CHECK_EQUAL(JOYSTICK_TRACE_SIZE, readUInt16(bytes, offset));
+    offset += 2;
+    for (uint32_t index = 0; index < JOYSTICK_TRACE_SIZE; index++) {
+        if (offset + 4 + reportSize > bytes.size()) return;
+        uint32_t sent = total - JOYSTICK_TRACE_SIZE + index;
+        const std::vector<uint8_t> &report = mockReports[sent];
+        CHECK_EQUAL(250 + sent, readUInt16(bytes, offset));
+        CHECK_EQUAL(report[0], bytes[offset + 2]);
+        CHECK_EQUAL(reportSize, bytes[offset + 3]);
+        CHECK_EQUAL(0, memcmp(bytes.data() + offset + 4, report.data() + 1, reportSize));
+        offset += 4 + reportSize;
+    }
+
+    // An empty trace is the header and a zero count
+    trace.clear();
+    BufferPrint empty;
+    trace.dump(empty, joystick);
+    CHECK_EQUAL(4 + 1 + 2 + descriptorSize + 2, empty.bytes.size());
+    CHECK_EQUAL(0, readUInt16(empty.bytes, 7 + descriptorSize));
+}
+
+int main() {
+    RUN_TEST(testRingWrapsAround);
+    RUN_TEST(testRecordsSentReports);
+    RUN_TEST(testDumpLayout);
+    return testResult();
+}